@@ -0,0 +1,162 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+BenchmarkRunner::BenchmarkRunner(const std::string& nameFilter, double scale)
+    : filter(nameFilter), sampleScale(scale > 0.0 ? scale : 1.0) {
+}
+
+bool BenchmarkRunner::isSelected(const std::string& name) const {
+    return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+void BenchmarkRunner::run(const std::string& name, int samples, const std::function<void()>& body) {
+    run(name, samples, [] {}, body);
+}
+
+void BenchmarkRunner::run(const std::string& name, int samples, const std::function<void()>& prepare,
+                          const std::function<void()>& body) {
+    if (!isSelected(name)) {
+        return;
+    }
+    
+    int sampleCount = std::max(1, (int)(samples * sampleScale));
+    for (int i = 0; i < WARMUP_SAMPLES; i++) {
+        prepare();
+        body();
+    }
+    
+    std::vector<double> times;
+    times.reserve(sampleCount);
+    double total = 0.0;
+    for (int i = 0; i < sampleCount; i++) {
+        prepare();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        times.push_back(ns);
+        total += ns;
+    }
+    std::sort(times.begin(), times.end());
+    
+    BenchmarkResult result;
+    result.name = name;
+    result.samples = sampleCount;
+    result.minNs = times.front();
+    result.meanNs = total / sampleCount;
+    result.medianNs = percentile(times, 0.50);
+    result.p90Ns = percentile(times, 0.90);
+    result.p99Ns = percentile(times, 0.99);
+    result.maxNs = times.back();
+    results.push_back(result);
+    
+    std::cerr << std::left << std::setw(40) << name << " median " << std::right << std::setw(12)
+              << std::fixed << std::setprecision(0) << result.medianNs << " ns, p99 "
+              << std::setw(12) << result.p99Ns << " ns (" << sampleCount << " samples)" << std::endl;
+}
+
+double BenchmarkRunner::percentile(const std::vector<double>& sorted, double fraction) {
+    // Nearest-rank, so every reported value is a sample that actually happened
+    size_t rank = (size_t)std::ceil(fraction * sorted.size());
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+void BenchmarkRunner::writeJson(std::ostream& output) const {
+    output << "{\n  \"benchmarks\": [\n";
+    output << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+        output << "    {\"name\": \"" << result.name << "\", \"samples\": " << result.samples
+               << ", \"min_ns\": " << result.minNs << ", \"mean_ns\": " << result.meanNs
+               << ", \"median_ns\": " << result.medianNs << ", \"p90_ns\": " << result.p90Ns
+               << ", \"p99_ns\": " << result.p99Ns << ", \"max_ns\": " << result.maxNs << "}"
+               << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    output << "  ]\n}\n";
+}
+
+// Reads one "key": number field from a line written by writeJson
+static double readField(const std::string& line, const char* key) {
+    std::string pattern = std::string("\"") + key + "\": ";
+    size_t at = line.find(pattern);
+    if (at == std::string::npos) {
+        return 0.0;
+    }
+    return std::strtod(line.c_str() + at + pattern.size(), nullptr);
+}
+
+bool BenchmarkRunner::loadJson(const std::string& filename, std::vector<BenchmarkResult>& baseline) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Could not open baseline " << filename << std::endl;
+        return false;
+    }
+    
+    baseline.clear();
+    std::string line;
+    const std::string namePattern = "\"name\": \"";
+    while (std::getline(file, line)) {
+        size_t nameStart = line.find(namePattern);
+        if (nameStart == std::string::npos) {
+            continue;
+        }
+        nameStart += namePattern.size();
+        size_t nameEnd = line.find('"', nameStart);
+        if (nameEnd == std::string::npos) {
+            continue;
+        }
+        
+        BenchmarkResult result;
+        result.name = line.substr(nameStart, nameEnd - nameStart);
+        result.samples = (int)readField(line, "samples");
+        result.minNs = readField(line, "min_ns");
+        result.meanNs = readField(line, "mean_ns");
+        result.medianNs = readField(line, "median_ns");
+        result.p90Ns = readField(line, "p90_ns");
+        result.p99Ns = readField(line, "p99_ns");
+        result.maxNs = readField(line, "max_ns");
+        baseline.push_back(result);
+    }
+    return true;
+}
+
+int BenchmarkRunner::compare(const std::vector<BenchmarkResult>& baseline, double thresholdPercent,
+                             std::ostream& output) const {
+    int regressions = 0;
+    int missing = 0;
+    output << std::left << std::setw(40) << "case" << std::right << std::setw(14) << "baseline ns"
+           << std::setw(14) << "current ns" << std::setw(10) << "change" << "\n";
+    
+    for (const BenchmarkResult& result : results) {
+        auto match = std::find_if(baseline.begin(), baseline.end(),
+            [&](const BenchmarkResult& old) { return old.name == result.name; });
+        output << std::left << std::setw(40) << result.name << std::right << std::fixed;
+        if (match == baseline.end() || match->medianNs <= 0.0) {
+            // A case the baseline doesn't know can't be checked, so it fails until the baseline is refreshed
+            missing++;
+            output << std::setw(14) << "-" << std::setw(14) << std::setprecision(0) << result.medianNs
+                   << std::setw(10) << "new" << "  NO BASELINE" << "\n";
+            continue;
+        }
+        
+        double change = (result.medianNs - match->medianNs) / match->medianNs * 100.0;
+        bool regressed = change > thresholdPercent;
+        if (regressed) {
+            regressions++;
+        }
+        output << std::setw(14) << std::setprecision(0) << match->medianNs << std::setw(14) << result.medianNs
+               << std::setw(9) << std::showpos << std::setprecision(1) << change << std::noshowpos << "%"
+               << (regressed ? "  REGRESSION" : "") << "\n";
+    }
+    
+    output << std::setprecision(1) << regressions << " regression(s) above " << thresholdPercent << "%, "
+           << missing << " case(s) missing from the baseline" << std::endl;
+    return regressions + missing;
+}
@@ -0,0 +1,109 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Timing summary for one benchmark case
+ *
+ * Every sample is timed on its own, so the percentiles show frame-to-frame
+ * spread (e.g. a rock stability rebuild landing on one tick) and not just
+ * the average.
+ */
+struct BenchmarkResult {
+    std::string name;
+    int samples;
+    double minNs;
+    double meanNs;
+    double medianNs;
+    double p90Ns;
+    double p99Ns;
+    double maxNs;
+};
+
+/**
+ * @brief Runs benchmark cases and reports them as JSON
+ */
+class BenchmarkRunner {
+public:
+    static const int WARMUP_SAMPLES = 3;  // discarded before timing starts
+
+private:
+    std::string filter;
+    double sampleScale;
+    std::vector<BenchmarkResult> results;
+
+public:
+    /**
+     * @brief Create a runner
+     * @param nameFilter Only cases whose name contains this are run (empty = all)
+     * @param scale Multiplier applied to every case's sample count
+     */
+    BenchmarkRunner(const std::string& nameFilter = "", double scale = 1.0);
+    
+    /**
+     * @brief Time a case
+     * @param name Case name, "group/case" style
+     * @param samples Number of timed samples
+     * @param body Work for one sample
+     */
+    void run(const std::string& name, int samples, const std::function<void()>& body);
+    
+    /**
+     * @brief Time a case that needs untimed setup before each sample
+     * @param name Case name, "group/case" style
+     * @param samples Number of timed samples
+     * @param prepare Called before every sample, outside the timed region
+     * @param body Work for one sample
+     */
+    void run(const std::string& name, int samples, const std::function<void()>& prepare,
+             const std::function<void()>& body);
+    
+    const std::vector<BenchmarkResult>& getResults() const { return results; }
+    
+    /**
+     * @brief Write results as JSON, one case per line so diffs stay readable
+     * @param output Stream to write to
+     */
+    void writeJson(std::ostream& output) const;
+    
+    /**
+     * @brief Read results back from a file written by writeJson
+     * @param filename Baseline file
+     * @param baseline Receives the cases found in the file
+     * @return False if the file could not be read
+     */
+    static bool loadJson(const std::string& filename, std::vector<BenchmarkResult>& baseline);
+    
+    /**
+     * @brief Compare medians against a baseline and print a table
+     * @param baseline Results from an earlier run
+     * @param thresholdPercent Slowdown (in percent of the baseline median) counted as a regression
+     * @param output Stream for the table
+     * @return Number of regressed cases plus cases missing from the baseline
+     */
+    int compare(const std::vector<BenchmarkResult>& baseline, double thresholdPercent,
+                std::ostream& output) const;
+
+private:
+    bool isSelected(const std::string& name) const;
+    static double percentile(const std::vector<double>& sorted, double fraction);
+};
+
+/**
+ * @brief Stops the optimizer from discarding a result the benchmark never reads
+ */
+template <typename T>
+inline void keepAlive(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static const T* volatile sink;
+    sink = &value;
+#endif
+}
+
+#endif // BENCHMARK_H
@@ -0,0 +1,497 @@
+#include "Benchmark.h"
+#include "AnimationManager.h"
+#include "BehaviorKernel.h"
+#include "FixedTimestep.h"
+#include "FlowField.h"
+#include "Game.h"
+#include "GameSnapshot.h"
+#include "InputProvider.h"
+#include "Logger.h"
+#include "Monster.h"
+#include "MonsterStore.h"
+#include "Player.h"
+#include "Profiler.h"
+#include "Projectile.h"
+#include "Random.h"
+#include "SpatialIndex.h"
+#include "TerrainGrid.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+static const int LEVEL_COUNT = 5;
+
+// Digs a serpentine tunnel through a blank grid, with a rock bedded in the
+// floor under every fourth cell so stability scans have rocks to examine
+static void carveStressLevel(TerrainGrid& grid) {
+    for (int y = 2; y < grid.getHeight(); y += 4) {
+        for (int x = 0; x < grid.getWidth(); x++) {
+            grid.digTunnelAt(Position(x, y));
+            if (x % 4 == 0 && y + 1 < grid.getHeight()) {
+                grid.setBlock(Position(x, y + 1), BlockType::ROCK);
+            }
+        }
+        int linkX = ((y / 4) % 2 == 0) ? grid.getWidth() - 1 : 0;
+        for (int step = 1; step < 4 && y + step < grid.getHeight(); step++) {
+            grid.digTunnelAt(Position(linkX, y + step));
+        }
+    }
+}
+
+// Every empty cell of a grid, in row-major order
+static std::vector<Position> findEmptyCells(const TerrainGrid& grid) {
+    std::vector<Position> cells;
+    for (int y = 0; y < grid.getHeight(); y++) {
+        for (int x = 0; x < grid.getWidth(); x++) {
+            if (grid.isBlockEmpty(Position(x, y))) {
+                cells.push_back(Position(x, y));
+            }
+        }
+    }
+    return cells;
+}
+
+static void benchmarkTerrain(BenchmarkRunner& runner) {
+    runner.run("terrain/load_level1", 200, [] {
+        TerrainGrid grid(1);
+        keepAlive(grid);
+    });
+    
+    // Same level in the binary format, minus the mapping
+    std::vector<uint8_t> binaryLevel;
+    TerrainGrid(1).writeBinary(binaryLevel);
+    runner.run("terrain/load_level1_binary", 200, [&] {
+        TerrainGrid grid(1, 1);
+        grid.loadBinary(binaryLevel.data(), binaryLevel.size(), "level1");
+        keepAlive(grid);
+    });
+    
+    TerrainGrid pristine(512, 512);
+    TerrainGrid grid(512, 512);
+    runner.run("terrain/dig_512x512_row_sweep", 50, [&] { grid = pristine; }, [&] {
+        for (int y = 0; y < grid.getHeight(); y += 2) {
+            for (int x = 0; x < grid.getWidth(); x++) {
+                grid.digTunnelAt(Position(x, y));
+            }
+        }
+    });
+    
+    TerrainGrid stress(512, 512);
+    carveStressLevel(stress);
+    stress.checkAllRocksForFalling();
+    runner.run("terrain/stability_full_scan_512x512", 100, [&] {
+        stress.checkAllRocksForFalling();
+    });
+    
+    // Rocks knocked loose are removed again, as Game does once they have fallen
+    Random random(Random::DEFAULT_SEED, 7);
+    runner.run("terrain/stability_dirty_16_digs", 1000, [&] {
+        for (const Position& rock : stress.getTriggeredRockFalls()) {
+            stress.removeRockAt(rock);
+        }
+        for (int i = 0; i < 16; i++) {
+            stress.digTunnelAt(Position(random.nextInt(512), random.nextInt(512)));
+        }
+    }, [&] {
+        stress.checkDirtyRocksForFalling();
+    });
+    
+    runner.run("terrain/count_dug_cells_512x512", 1000, [&] {
+        keepAlive(stress.countDugCells());
+    });
+}
+
+static void benchmarkMonsters(BenchmarkRunner& runner) {
+    TerrainGrid terrain(256, 256);
+    carveStressLevel(terrain);
+    std::vector<Position> openCells = findEmptyCells(terrain);
+    Position target = openCells[openCells.size() / 2];
+    
+    FlowField flowField;
+    flowField.update(terrain, target);
+    
+    for (int count : {10, 100, 1000}) {
+        std::vector<Monster> monsters;
+        monsters.reserve(count);
+        for (int i = 0; i < count; i++) {
+            Position start = openCells[(size_t)i * 7919 % openCells.size()];
+            Monster::MonsterType type = (i % 3 == 0) ? Monster::GREEN_DRAGON : Monster::RED_MONSTER;
+            monsters.emplace_back(start, type, &terrain);
+            monsters.back().setFlowField(&flowField);
+            monsters.back().seedRandom(Random::DEFAULT_SEED, Random::MONSTER_STREAM_BASE + i);
+        }
+        
+        runner.run("monster/update_" + std::to_string(count), 2000, [&] {
+            for (auto& monster : monsters) {
+                monster.setTarget(target);
+                monster.update(1.0f / 60.0f);
+            }
+        });
+        
+        // Same monsters in the structure-of-arrays store the game uses
+        MonsterStore store;
+        store.setTerrain(&terrain);
+        store.setFlowField(&flowField);
+        for (const auto& monster : monsters) {
+            store.add(monster);
+        }
+        runner.run("monster/store_update_" + std::to_string(count), 2000, [&] {
+            store.update(1.0f / 60.0f, target);
+        });
+    }
+    
+    runner.run("monster/flow_field_rebuild_256x256", 200, [&] { flowField.invalidate(); }, [&] {
+        flowField.update(terrain, target);
+    });
+}
+
+static void benchmarkBehaviorKernel(BenchmarkRunner& runner) {
+    TerrainGrid terrain(256, 256);
+    carveStressLevel(terrain);
+    std::vector<Position> openCells = findEmptyCells(terrain);
+    Position target = openCells[openCells.size() / 2];
+    
+    for (int count : {10, 100, 10000}) {
+        // Per-object path: setTarget runs Monster::updateBehaviorState
+        std::vector<Monster> monsters;
+        monsters.reserve(count);
+        for (int i = 0; i < count; i++) {
+            Position start = openCells[(size_t)i * 7919 % openCells.size()];
+            monsters.emplace_back(start, Monster::RED_MONSTER, &terrain);
+        }
+        runner.run("monster/state_objects_" + std::to_string(count), 2000, [&] {
+            for (auto& monster : monsters) {
+                monster.setTarget(target);
+            }
+        });
+        
+        std::vector<int32_t> x(count), y(count), states(count, Monster::PATROLLING);
+        std::vector<float> aggression(count, 0.0f), detect(count), lose(count);
+        for (int i = 0; i < count; i++) {
+            x[i] = monsters[i].getPosition().x;
+            y[i] = monsters[i].getPosition().y;
+            float range = monsters[i].getDetectionRange();
+            detect[i] = range * range;
+            lose[i] = range * 1.5f * range * 1.5f;
+        }
+        BehaviorKernel::Batch batch = { x.data(), y.data(), states.data(), aggression.data(),
+                                        detect.data(), lose.data(), count };
+        
+        for (BehaviorKernel::Path path : {BehaviorKernel::SCALAR, BehaviorKernel::SSE2, BehaviorKernel::AVX2}) {
+            if (path > BehaviorKernel::getBestPath()) {
+                continue;
+            }
+            runner.run(std::string("monster/state_kernel_") + BehaviorKernel::getPathName(path) + "_" +
+                       std::to_string(count), 2000, [&] {
+                BehaviorKernel::updateStates(path, batch, target.x, target.y);
+            });
+        }
+    }
+}
+
+static void benchmarkParallelMonsters(BenchmarkRunner& runner) {
+    TerrainGrid terrain(256, 256);
+    carveStressLevel(terrain);
+    std::vector<Position> openCells = findEmptyCells(terrain);
+    Position target = openCells[openCells.size() / 2];
+    
+    FlowField flowField;
+    flowField.update(terrain, target);
+    
+    // Same 10000 monsters decided on one thread and on every hardware thread.
+    // Named for the role, not the count, so a baseline from one machine
+    // still matches on another
+    const int count = 10000;
+    int hardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    const std::pair<int, const char*> threadCounts[] = { { 1, "1" }, { hardwareThreads, "max" } };
+    
+    for (const auto& [threads, label] : threadCounts) {
+        WorkerPool pool(threads);
+        MonsterStore store;
+        store.setTerrain(&terrain);
+        store.setFlowField(&flowField);
+        store.setWorkerPool(&pool);
+        store.reserve(count);
+        for (int i = 0; i < count; i++) {
+            Position start = openCells[(size_t)i * 7919 % openCells.size()];
+            Monster monster(start, (i % 3 == 0) ? Monster::GREEN_DRAGON : Monster::RED_MONSTER, &terrain);
+            monster.seedRandom(Random::DEFAULT_SEED, Random::MONSTER_STREAM_BASE + i);
+            store.add(monster);
+        }
+        
+        runner.run("monster/store_update_" + std::to_string(count) + "_threads_" + label, 1000, [&] {
+            store.update(1.0f / 60.0f, target);
+        });
+    }
+}
+
+static void benchmarkDecisionStagger(BenchmarkRunner& runner) {
+    TerrainGrid terrain(256, 256);
+    carveStressLevel(terrain);
+    std::vector<Position> openCells = findEmptyCells(terrain);
+    Position target = openCells[openCells.size() / 2];
+    
+    FlowField flowField;
+    flowField.update(terrain, target);
+    
+    // All monsters deciding on the same tick spike p99/max; staggered phases
+    // spread the same work evenly over the interval
+    const int count = 5000;
+    for (bool staggered : {false, true}) {
+        MonsterStore store;
+        store.setTerrain(&terrain);
+        store.setFlowField(&flowField);
+        store.getScheduler().setBudget(0);
+        store.reserve(count);
+        for (int i = 0; i < count; i++) {
+            Position start = openCells[(size_t)i * 7919 % openCells.size()];
+            Monster monster(start, Monster::RED_MONSTER, &terrain);
+            monster.seedRandom(Random::DEFAULT_SEED, Random::MONSTER_STREAM_BASE + i);
+            if (staggered) {
+                monster.setDecisionPhase(DecisionScheduler::getPhase(i));
+            }
+            store.add(monster);
+        }
+        
+        runner.run(std::string("monster/store_update_") + std::to_string(count) +
+                   (staggered ? "_staggered" : "_synchronized"), 1800, [&] {
+            store.update(1.0f / 60.0f, target);
+        });
+    }
+}
+
+static void benchmarkLevelOfDetail(BenchmarkRunner& runner) {
+    TerrainGrid terrain(256, 256);
+    carveStressLevel(terrain);
+    std::vector<Position> openCells = findEmptyCells(terrain);
+    Position target = openCells[openCells.size() / 2];
+    
+    FlowField flowField;
+    flowField.update(terrain, target);
+    
+    // Monsters spread over the whole map: with LOD most of them are distant
+    const int count = 10000;
+    for (bool lod : {false, true}) {
+        MonsterStore store;
+        store.setTerrain(&terrain);
+        store.setFlowField(&flowField);
+        store.setLodDistance(lod ? MonsterStore::DEFAULT_LOD_DISTANCE : 0.0f);
+        store.reserve(count);
+        for (int i = 0; i < count; i++) {
+            Position start = openCells[(size_t)i * 7919 % openCells.size()];
+            Monster monster(start, (i % 3 == 0) ? Monster::GREEN_DRAGON : Monster::RED_MONSTER, &terrain);
+            monster.seedRandom(Random::DEFAULT_SEED, Random::MONSTER_STREAM_BASE + i);
+            monster.setDecisionPhase(DecisionScheduler::getPhase(i));
+            store.add(monster);
+        }
+        
+        runner.run(std::string("monster/store_update_") + std::to_string(count) + (lod ? "_lod" : "_full_ai"), 1000, [&] {
+            store.update(1.0f / 60.0f, target);
+        });
+    }
+}
+
+static void benchmarkProjectiles(BenchmarkRunner& runner) {
+    TerrainGrid terrain(1);
+    Player player(terrain.getPlayerStartPosition());
+    player.setTerrain(&terrain);
+    
+    // One sample fires 100 harpoons and runs each through extend and retract
+    runner.run("projectile/extend_retract_x100", 500, [&] {
+        for (int shot = 0; shot < 100; shot++) {
+            Projectile harpoon(&player, (Projectile::Direction)(shot % 4), 8);
+            for (int tick = 0; tick < 200 && !harpoon.isFinished(); tick++) {
+                harpoon.update(0.05f);
+            }
+            keepAlive(harpoon);
+        }
+    });
+}
+
+static void benchmarkCollisions(BenchmarkRunner& runner) {
+    TerrainGrid terrain(256, 256);
+    carveStressLevel(terrain);
+    std::vector<Position> openCells = findEmptyCells(terrain);
+    
+    SpatialIndex index;
+    index.reset(terrain.getWidth(), terrain.getHeight());
+    std::vector<Monster> monsters;
+    for (int i = 0; i < 1000; i++) {
+        Position start = openCells[(size_t)i * 7919 % openCells.size()];
+        monsters.emplace_back(start, Monster::RED_MONSTER, &terrain);
+        index.insert(start);
+    }
+    
+    std::vector<Position> probes;
+    Random random(Random::DEFAULT_SEED, 11);
+    for (int i = 0; i < 1000; i++) {
+        probes.push_back(openCells[random.nextInt((int)openCells.size())]);
+    }
+    
+    // The same 1000 harpoon tips against 1000 monsters, indexed and brute force
+    runner.run("collision/spatial_index_1000x1000", 1000, [&] {
+        int hits = 0;
+        for (const Position& probe : probes) {
+            hits += index.firstAt(probe) != SpatialIndex::NONE;
+        }
+        keepAlive(hits);
+    });
+    
+    runner.run("collision/linear_scan_1000x1000", 50, [&] {
+        int hits = 0;
+        for (const Position& probe : probes) {
+            for (const Monster& monster : monsters) {
+                if (monster.getPosition() == probe) {
+                    hits++;
+                    break;
+                }
+            }
+        }
+        keepAlive(hits);
+    });
+}
+
+static void benchmarkAnimations(BenchmarkRunner& runner) {
+    for (int count : {1000, 5000}) {
+        AnimationManager animations;
+        runner.run("animation/update_" + std::to_string(count), 500, [&] {
+            animations = AnimationManager();
+            for (int i = 0; i < count; i++) {
+                Position pos(i % 40, (i / 40) % 30);
+                switch (i % 3) {
+                    case 0: animations.addExplosion(pos); break;
+                    case 1: animations.addHarpoonImpact(pos); break;
+                    default: animations.addScorePopup(pos, 100); break;
+                }
+            }
+        }, [&] {
+            // A 0.3 s step retires the harpoon impacts, so removal is measured too
+            animations.update(0.3f);
+        });
+    }
+}
+
+// Whole-game ticks on each shipped level, driven by the seeded bot
+static void benchmarkLevels(BenchmarkRunner& runner) {
+    for (int level = 1; level <= LEVEL_COUNT; level++) {
+        std::string filename = "resources/level" + std::to_string(level) + ".txt";
+        if (!std::ifstream(filename).good()) {
+            std::cerr << "Skipping level " << level << ": " << filename << " not found" << std::endl;
+            continue;
+        }
+        
+        RandomBotInput bot(Random::DEFAULT_SEED + level);
+        Game game(&bot, true, Random::DEFAULT_SEED);
+        FixedTimestep clock(60.0f);
+        game.startLevel(level);
+        
+        // Restart whenever the bot dies or clears the level so every sample is live play
+        runner.run("game/update_level" + std::to_string(level), 3600, [&] {
+            if (game.isGameOver()) {
+                game.startLevel(level);
+            }
+            game.beginFrame();
+        }, [&] {
+            game.update(clock.getStepSeconds());
+        });
+    }
+}
+
+// Save and restore of the whole game, as a rollback or look-ahead step would do
+static void benchmarkSnapshots(BenchmarkRunner& runner) {
+    RandomBotInput bot(Random::DEFAULT_SEED);
+    Game game(&bot, true, Random::DEFAULT_SEED);
+    FixedTimestep clock(60.0f);
+    game.startLevel(LEVEL_COUNT);
+    for (int tick = 0; tick < 600 && !game.isGameOver(); tick++) {
+        game.beginFrame();
+        game.update(clock.getStepSeconds());
+    }
+    
+    GameSnapshot snapshot;
+    game.saveSnapshot(snapshot);
+    runner.run("snapshot/save_level" + std::to_string(LEVEL_COUNT), 5000, [&] {
+        game.saveSnapshot(snapshot);
+        keepAlive(snapshot.size());
+    });
+    runner.run("snapshot/restore_level" + std::to_string(LEVEL_COUNT), 5000, [&] {
+        keepAlive(game.restoreSnapshot(snapshot));
+    });
+}
+
+static void printUsage() {
+    std::cerr << "Usage: benchmarks [--filter text] [--scale factor] [--output file.json]\n"
+              << "                  [--compare baseline.json] [--threshold percent]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    double scale = 1.0;
+    const char* outputFile = nullptr;
+    const char* baselineFile = nullptr;
+    double threshold = 15.0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            baselineFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = std::atof(argv[++i]);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+    
+    // Level setup logs at info level; keep it out of the timings
+    Logger::getInstance()->setLevel(Logger::LEVEL_WARNING);
+    Profiler::getInstance()->setEnabled(false);
+    
+    std::vector<BenchmarkResult> baseline;
+    if (baselineFile && !BenchmarkRunner::loadJson(baselineFile, baseline)) {
+        return 2;
+    }
+    
+    BenchmarkRunner runner(filter, scale);
+    benchmarkTerrain(runner);
+    benchmarkMonsters(runner);
+    benchmarkBehaviorKernel(runner);
+    benchmarkParallelMonsters(runner);
+    benchmarkDecisionStagger(runner);
+    benchmarkLevelOfDetail(runner);
+    benchmarkProjectiles(runner);
+    benchmarkCollisions(runner);
+    benchmarkAnimations(runner);
+    benchmarkLevels(runner);
+    benchmarkSnapshots(runner);
+    Logger::getInstance()->flush();
+    
+    if (outputFile) {
+        std::ofstream file(outputFile);
+        if (!file.is_open()) {
+            std::cerr << "Could not write " << outputFile << std::endl;
+            return 2;
+        }
+        runner.writeJson(file);
+    } else {
+        runner.writeJson(std::cout);
+    }
+    
+    if (baselineFile) {
+        return runner.compare(baseline, threshold, std::cerr) > 0 ? 1 : 0;
+    }
+    return 0;
+}
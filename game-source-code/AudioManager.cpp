@@ -1,6 +1,6 @@
 // AudioManager.cpp - Fixed version
 #include "AudioManager.h"
-#include <iostream>
+#include "Logger.h"
 
 AudioManager* AudioManager::instance = nullptr;
 
@@ -24,7 +24,7 @@ void AudioManager::initialize() {
     InitAudioDevice();
     audioInitialized = true;
     
-    std::cout << "Audio system initialized (sound effects disabled for now)" << std::endl;
+    GAME_LOG_INFO("Audio system initialized (sound effects disabled for now)");
 }
 
 void AudioManager::cleanup() {
@@ -0,0 +1,196 @@
+#include "BehaviorKernel.h"
+#include "Monster.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BEHAVIOR_KERNEL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 code is compiled with a target attribute, so the rest of the game
+// keeps building for the baseline instruction set
+#if BEHAVIOR_KERNEL_SSE2 && defined(__GNUC__)
+#define BEHAVIOR_KERNEL_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    // Monster::updateBehaviorState for one monster
+    inline void updateOne(const BehaviorKernel::Batch& batch, int i, int targetX, int targetY) {
+        float distance = BehaviorKernel::squaredDistance(batch.x[i] - targetX, batch.y[i] - targetY);
+        int32_t current = batch.states[i];
+        float timer = batch.aggressionTimers[i];
+        
+        bool patrolling = current == Monster::PATROLLING;
+        bool chasing = current == Monster::CHASING;
+        bool aggressive = current == Monster::AGGRESSIVE;
+        
+        bool startChase = patrolling && distance <= batch.detectRangeSq[i];
+        bool giveUp = chasing && distance > batch.loseRangeSq[i];
+        bool enrage = chasing && !giveUp && distance <= BehaviorKernel::AGGRESSIVE_RANGE_SQ;
+        bool calmDown = aggressive && timer <= 0.0f && distance > BehaviorKernel::CALM_DOWN_RANGE_SQ;
+        
+        batch.aggressionTimers[i] = enrage ? BehaviorKernel::AGGRESSION_TIME : timer;
+        batch.states[i] = (startChase || calmDown) ? (int32_t)Monster::CHASING
+                        : giveUp ? (int32_t)Monster::PATROLLING
+                        : enrage ? (int32_t)Monster::AGGRESSIVE
+                        : current;
+    }
+    
+    void updateScalar(const BehaviorKernel::Batch& batch, int first, int targetX, int targetY) {
+        for (int i = first; i < batch.count; i++) {
+            updateOne(batch, i, targetX, targetY);
+        }
+    }
+
+#if BEHAVIOR_KERNEL_SSE2
+    // SSE2 has no blend instruction: (mask & a) | (~mask & b)
+    inline __m128i selectInt(__m128i mask, __m128i a, __m128i b) {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+    
+    inline __m128 selectFloat(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+    
+    void updateSse2(const BehaviorKernel::Batch& batch, int targetX, int targetY) {
+        const __m128i patrolState = _mm_set1_epi32(Monster::PATROLLING);
+        const __m128i chaseState = _mm_set1_epi32(Monster::CHASING);
+        const __m128i aggressiveState = _mm_set1_epi32(Monster::AGGRESSIVE);
+        const __m128 aggressiveRange = _mm_set1_ps(BehaviorKernel::AGGRESSIVE_RANGE_SQ);
+        const __m128 calmRange = _mm_set1_ps(BehaviorKernel::CALM_DOWN_RANGE_SQ);
+        const __m128 aggressionTime = _mm_set1_ps(BehaviorKernel::AGGRESSION_TIME);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128i targetXs = _mm_set1_epi32(targetX);
+        const __m128i targetYs = _mm_set1_epi32(targetY);
+        
+        int i = 0;
+        for (; i + 4 <= batch.count; i += 4) {
+            // Squared in float, like squaredDistance
+            __m128 deltaX = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128((const __m128i*)(batch.x + i)), targetXs));
+            __m128 deltaY = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128((const __m128i*)(batch.y + i)), targetYs));
+            __m128 distance = _mm_add_ps(_mm_mul_ps(deltaX, deltaX), _mm_mul_ps(deltaY, deltaY));
+            __m128i current = _mm_loadu_si128((const __m128i*)(batch.states + i));
+            __m128 timer = _mm_loadu_ps(batch.aggressionTimers + i);
+            
+            __m128 patrolling = _mm_castsi128_ps(_mm_cmpeq_epi32(current, patrolState));
+            __m128 chasing = _mm_castsi128_ps(_mm_cmpeq_epi32(current, chaseState));
+            __m128 aggressive = _mm_castsi128_ps(_mm_cmpeq_epi32(current, aggressiveState));
+            
+            __m128 startChase = _mm_and_ps(patrolling, _mm_cmple_ps(distance, _mm_loadu_ps(batch.detectRangeSq + i)));
+            __m128 giveUp = _mm_and_ps(chasing, _mm_cmpgt_ps(distance, _mm_loadu_ps(batch.loseRangeSq + i)));
+            __m128 enrage = _mm_andnot_ps(giveUp, _mm_and_ps(chasing, _mm_cmple_ps(distance, aggressiveRange)));
+            __m128 calmDown = _mm_and_ps(aggressive, _mm_and_ps(_mm_cmple_ps(timer, zero), _mm_cmpgt_ps(distance, calmRange)));
+            
+            __m128 newTimer = selectFloat(enrage, aggressionTime, timer);
+            __m128i newState = selectInt(_mm_castps_si128(enrage), aggressiveState, current);
+            newState = selectInt(_mm_castps_si128(giveUp), patrolState, newState);
+            newState = selectInt(_mm_castps_si128(_mm_or_ps(startChase, calmDown)), chaseState, newState);
+            
+            _mm_storeu_ps(batch.aggressionTimers + i, newTimer);
+            _mm_storeu_si128((__m128i*)(batch.states + i), newState);
+        }
+        updateScalar(batch, i, targetX, targetY);
+    }
+#endif
+
+#if BEHAVIOR_KERNEL_AVX2
+    __attribute__((target("avx2")))
+    void updateAvx2(const BehaviorKernel::Batch& batch, int targetX, int targetY) {
+        const __m256i patrolState = _mm256_set1_epi32(Monster::PATROLLING);
+        const __m256i chaseState = _mm256_set1_epi32(Monster::CHASING);
+        const __m256i aggressiveState = _mm256_set1_epi32(Monster::AGGRESSIVE);
+        const __m256 aggressiveRange = _mm256_set1_ps(BehaviorKernel::AGGRESSIVE_RANGE_SQ);
+        const __m256 calmRange = _mm256_set1_ps(BehaviorKernel::CALM_DOWN_RANGE_SQ);
+        const __m256 aggressionTime = _mm256_set1_ps(BehaviorKernel::AGGRESSION_TIME);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256i targetXs = _mm256_set1_epi32(targetX);
+        const __m256i targetYs = _mm256_set1_epi32(targetY);
+        
+        int i = 0;
+        for (; i + 8 <= batch.count; i += 8) {
+            // Squared in float, not with _mm256_mullo_epi32, which wraps far from the target
+            __m256 deltaX = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(batch.x + i)), targetXs));
+            __m256 deltaY = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(batch.y + i)), targetYs));
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(deltaX, deltaX), _mm256_mul_ps(deltaY, deltaY));
+            __m256i current = _mm256_loadu_si256((const __m256i*)(batch.states + i));
+            __m256 timer = _mm256_loadu_ps(batch.aggressionTimers + i);
+            
+            __m256 patrolling = _mm256_castsi256_ps(_mm256_cmpeq_epi32(current, patrolState));
+            __m256 chasing = _mm256_castsi256_ps(_mm256_cmpeq_epi32(current, chaseState));
+            __m256 aggressive = _mm256_castsi256_ps(_mm256_cmpeq_epi32(current, aggressiveState));
+            
+            __m256 startChase = _mm256_and_ps(patrolling,
+                _mm256_cmp_ps(distance, _mm256_loadu_ps(batch.detectRangeSq + i), _CMP_LE_OQ));
+            __m256 giveUp = _mm256_and_ps(chasing,
+                _mm256_cmp_ps(distance, _mm256_loadu_ps(batch.loseRangeSq + i), _CMP_GT_OQ));
+            __m256 enrage = _mm256_andnot_ps(giveUp,
+                _mm256_and_ps(chasing, _mm256_cmp_ps(distance, aggressiveRange, _CMP_LE_OQ)));
+            __m256 calmDown = _mm256_and_ps(aggressive, _mm256_and_ps(_mm256_cmp_ps(timer, zero, _CMP_LE_OQ),
+                                                                      _mm256_cmp_ps(distance, calmRange, _CMP_GT_OQ)));
+            
+            __m256 newTimer = _mm256_blendv_ps(timer, aggressionTime, enrage);
+            __m256 newState = _mm256_blendv_ps(_mm256_castsi256_ps(current), _mm256_castsi256_ps(aggressiveState), enrage);
+            newState = _mm256_blendv_ps(newState, _mm256_castsi256_ps(patrolState), giveUp);
+            newState = _mm256_blendv_ps(newState, _mm256_castsi256_ps(chaseState), _mm256_or_ps(startChase, calmDown));
+            
+            _mm256_storeu_ps(batch.aggressionTimers + i, newTimer);
+            _mm256_storeu_si256((__m256i*)(batch.states + i), _mm256_castps_si256(newState));
+        }
+        updateScalar(batch, i, targetX, targetY);
+    }
+#endif
+    
+    BehaviorKernel::Path detectBestPath() {
+#if BEHAVIOR_KERNEL_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return BehaviorKernel::AVX2;
+        }
+#endif
+#if BEHAVIOR_KERNEL_SSE2
+        return BehaviorKernel::SSE2;
+#else
+        return BehaviorKernel::SCALAR;
+#endif
+    }
+}
+
+BehaviorKernel::Path BehaviorKernel::getBestPath() {
+    static const Path best = detectBestPath();
+    return best;
+}
+
+const char* BehaviorKernel::getPathName(Path path) {
+    switch (path) {
+        case SSE2: return "sse2";
+        case AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+void BehaviorKernel::updateStates(const Batch& batch, int targetX, int targetY) {
+    updateStates(getBestPath(), batch, targetX, targetY);
+}
+
+void BehaviorKernel::updateStates(Path path, const Batch& batch, int targetX, int targetY) {
+    // Never run a path the CPU lacks, whatever was asked for
+    if (path > getBestPath()) {
+        path = getBestPath();
+    }
+    
+    switch (path) {
+#if BEHAVIOR_KERNEL_AVX2
+        case AVX2:
+            updateAvx2(batch, targetX, targetY);
+            return;
+#endif
+#if BEHAVIOR_KERNEL_SSE2
+        case SSE2:
+            updateSse2(batch, targetX, targetY);
+            return;
+#endif
+        default:
+            updateScalar(batch, 0, targetX, targetY);
+            return;
+    }
+}
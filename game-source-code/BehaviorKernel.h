@@ -0,0 +1,82 @@
+#ifndef BEHAVIORKERNEL_H
+#define BEHAVIORKERNEL_H
+
+#include <cstdint>
+
+/**
+ * @brief Batch monster behaviour-state transitions on squared distances
+ *
+ * Evaluates Monster::updateBehaviorState for a whole array of monsters: the
+ * squared distance to the target is tested against the detection range, 1.5x
+ * the detection range, 5 and 8 tiles, and the state and aggression timer are
+ * updated with selects instead of branches. The aggression timer runs on
+ * simulated time, so counting it down is left to the caller's update. There is a scalar version, an
+ * SSE2 version (4 monsters per step) and an AVX2 version (8 per step); the
+ * AVX2 code is compiled for that target only and picked at run time when
+ * the CPU supports it, so no special build flags are needed.
+ *
+ * Every path squares in float, as squaredDistance() does: an int32 square
+ * overflows once an offset passes 46340 tiles, well inside the largest
+ * grid. Below 2^24 the squares are exact integers, and so are the squared
+ * thresholds, so the results match the sqrt-based per-object code exactly;
+ * further out the rounding is the same on every path and far past every
+ * threshold.
+ */
+class BehaviorKernel {
+public:
+    enum Path {
+        SCALAR,
+        SSE2,
+        AVX2
+    };
+    
+    static constexpr float AGGRESSIVE_RANGE_SQ = 5.0f * 5.0f;   // CHASING -> AGGRESSIVE within this
+    static constexpr float CALM_DOWN_RANGE_SQ = 8.0f * 8.0f;    // AGGRESSIVE -> CHASING beyond this
+    static constexpr float AGGRESSION_TIME = 5.0f;              // seconds; counted down by the caller
+    
+    /**
+     * @brief Monster arrays the kernel reads and updates, all with count entries
+     */
+    struct Batch {
+        const int32_t* x;
+        const int32_t* y;
+        int32_t* states;            // Monster::BehaviorState
+        float* aggressionTimers;
+        const float* detectRangeSq; // PATROLLING -> CHASING within this
+        const float* loseRangeSq;   // CHASING -> PATROLLING beyond this
+        int count;
+    };
+    
+    /**
+     * @brief Update every monster's state with the fastest path this CPU supports
+     * @param batch Monsters to update
+     * @param targetX Target tile column
+     * @param targetY Target tile row
+     */
+    static void updateStates(const Batch& batch, int targetX, int targetY);
+    
+    /**
+     * @brief Update with a specific path, for tests and benchmarks
+     *
+     * A path the CPU or build does not support falls back to the next best one.
+     */
+    static void updateStates(Path path, const Batch& batch, int targetX, int targetY);
+    
+    /**
+     * @brief The path updateStates uses on this machine
+     */
+    static Path getBestPath();
+    
+    static const char* getPathName(Path path);
+    
+    /**
+     * @brief Squared length of a tile offset, rounded exactly as the kernels round it
+     */
+    static float squaredDistance(int32_t deltaX, int32_t deltaY) {
+        float x = (float)deltaX;
+        float y = (float)deltaY;
+        return x * x + y * y;
+    }
+};
+
+#endif // BEHAVIORKERNEL_H
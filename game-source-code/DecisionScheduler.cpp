@@ -0,0 +1,62 @@
+#include "DecisionScheduler.h"
+#include <algorithm>
+
+DecisionScheduler::DecisionScheduler() : budget(DEFAULT_BUDGET), cursor(0), lastDecided(0), lastDeferred(0) {
+}
+
+float DecisionScheduler::getPhase(int index) {
+    // Fractional parts of multiples of the golden ratio never bunch up
+    const double goldenRatio = 0.6180339887498949;
+    double phase = index * goldenRatio;
+    return (float)(phase - (int64_t)phase);
+}
+
+void DecisionScheduler::select(uint8_t* due, float* timers, const float* intervals, int count) {
+    int dueCount = 0;
+    for (int i = 0; i < count; i++) {
+        dueCount += due[i];
+    }
+    
+    if (budget <= 0 || dueCount <= budget) {
+        for (int i = 0; i < count; i++) {
+            timers[i] = due[i] ? std::min(timers[i] - intervals[i], intervals[i]) : timers[i];
+        }
+        lastDecided = dueCount;
+        lastDeferred = 0;
+        return;
+    }
+    
+    // Over budget: hand out slots round-robin from where the last scan stopped
+    if (cursor >= count) {
+        cursor = 0;
+    }
+    int decided = 0;
+    int next = cursor;
+    auto scan = [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            if (!due[i]) {
+                continue;
+            }
+            if (decided < budget) {
+                // A monster deferred for several intervals catches up once, not once per interval
+                timers[i] = std::min(timers[i] - intervals[i], intervals[i]);
+                decided++;
+                next = i + 1;
+            } else {
+                due[i] = 0;
+            }
+        }
+    };
+    scan(cursor, count);
+    scan(0, cursor);
+    
+    cursor = next;
+    lastDecided = decided;
+    lastDeferred = dueCount - decided;
+}
+
+void DecisionScheduler::reset() {
+    cursor = 0;
+    lastDecided = 0;
+    lastDeferred = 0;
+}
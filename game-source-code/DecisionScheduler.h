@@ -0,0 +1,74 @@
+#ifndef DECISIONSCHEDULER_H
+#define DECISIONSCHEDULER_H
+
+#include <cstdint>
+
+/**
+ * @brief Spreads monster AI decisions over ticks and caps how many run per tick
+ *
+ * Every monster decides once per decision interval. If they all start with the
+ * same timer they all decide on the same tick, and that tick spikes. Two
+ * things fix that:
+ *
+ * - getPhase() gives each new monster its own starting point in the interval
+ *   (golden-ratio spacing, so any number of monsters comes out evenly spread).
+ * - select() lets at most a budget of due monsters decide per tick. The rest
+ *   keep their expired timers and go first next tick: the scan is round-robin
+ *   and resumes after the last monster that got a slot.
+ *
+ * The budget is a number of decisions rather than a wall-clock time, so a
+ * seeded run or a replay does the same thing on any machine.
+ */
+class DecisionScheduler {
+public:
+    static const int DEFAULT_BUDGET = 512;  // decisions per tick, 0 = unlimited
+
+private:
+    int budget;
+    int cursor;          // where the next round-robin scan starts
+    int lastDecided;
+    int lastDeferred;
+
+public:
+    DecisionScheduler();
+    
+    /**
+     * @brief Starting point in the decision interval for the index-th monster
+     * @param index Spawn order
+     * @return Fraction of the interval, in [0, 1)
+     */
+    static float getPhase(int index);
+    
+    /**
+     * @brief Decide which due monsters run this tick
+     *
+     * Monsters left out have their due flag cleared and their timer kept, so
+     * they come up again next tick; the chosen ones have one interval taken
+     * off their timer, keeping the overshoot up to one interval as Monster does.
+     * @param due In: timer expired; out: decides this tick (1) or not (0)
+     * @param timers Decision timers
+     * @param intervals Decision intervals
+     * @param count Number of monsters
+     */
+    void select(uint8_t* due, float* timers, const float* intervals, int count);
+    
+    void setBudget(int decisionsPerTick) { budget = decisionsPerTick; }
+    int getBudget() const { return budget; }
+    
+    /**
+     * @brief Monsters that decided on the last tick
+     */
+    int getLastDecided() const { return lastDecided; }
+    
+    /**
+     * @brief Due monsters pushed to the next tick on the last tick
+     */
+    int getLastDeferred() const { return lastDeferred; }
+    
+    /**
+     * @brief Forget the round-robin position (e.g. when the monsters are replaced)
+     */
+    void reset();
+};
+
+#endif // DECISIONSCHEDULER_H
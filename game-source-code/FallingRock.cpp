@@ -1,6 +1,6 @@
 #include "FallingRock.h"
 #include "TerrainGrid.h"
-#include <iostream>
+#include "Logger.h"
 
 FallingRock::FallingRock() 
     : GameThing(Position(0, 0)), fallSpeed(30.0f), fallTimer(0.0f), 
@@ -11,7 +11,22 @@ FallingRock::FallingRock(const Position& startPos, TerrainGrid* terrainRef)
     : GameThing(startPos), fallSpeed(30.0f), fallTimer(0.0f), 
       fallInterval(0.5f), hasLanded(false), isStable(false), terrain(terrainRef) {
     
-    std::cout << "Falling rock created at (" << startPos.x << ", " << startPos.y << ")" << std::endl;
+    GAME_LOG_DEBUG("Falling rock created at (%d, %d)", startPos.x, startPos.y);
+}
+
+FallingRock::SavedState FallingRock::getSavedState() const {
+    return SavedState{ location, previousLocation, isActive, fallSpeed, fallTimer, fallInterval, hasLanded, isStable };
+}
+
+void FallingRock::setSavedState(const SavedState& saved) {
+    location = saved.location;
+    previousLocation = saved.previousLocation;
+    isActive = saved.isActive;
+    fallSpeed = saved.fallSpeed;
+    fallTimer = saved.fallTimer;
+    fallInterval = saved.fallInterval;
+    hasLanded = saved.hasLanded;
+    isStable = saved.isStable;
 }
 
 raylib::Rectangle FallingRock::getBounds() const {
@@ -43,7 +58,7 @@ void FallingRock::update(float deltaTime) {
             
             if (terrain) {
                 terrain->setBlock(location, BlockType::ROCK);
-                std::cout << "Rock landed at (" << location.x << ", " << location.y << ")" << std::endl;
+                GAME_LOG_DEBUG("Rock landed at (%d, %d)", location.x, location.y);
             }
         }
     }
@@ -90,13 +105,8 @@ void FallingRock::draw() const {
 }
 
 bool FallingRock::canFallTo(const Position& pos) const {
-    if (!pos.isValid()) {
-        return false;
-    }
-    
-    // FIXED: Can fall to the very bottom row (WORLD_HEIGHT - 1)
-    // Only stop if trying to go BEYOND the bottom
-    if (pos.y >= Position::WORLD_HEIGHT) {
+    // Can fall to the very bottom row of the grid, but not beyond it
+    if (!TerrainGrid::isInside(terrain, pos)) {
         return false;
     }
     
@@ -115,7 +125,7 @@ bool FallingRock::hasSupport() const {
     belowPos.y++;
     
     // Has support if there's something solid below OR at the very bottom of world
-    return !terrain->isBlockEmpty(belowPos) || !belowPos.isValid() || belowPos.y >= Position::WORLD_HEIGHT;
+    return !terrain->isBlockEmpty(belowPos) || !terrain->isValidPosition(belowPos);
 }
 
 void FallingRock::checkStability() {
@@ -17,6 +17,20 @@ private:
     TerrainGrid* terrain;
     
 public:
+    /**
+     * @brief Plain-data copy of a rock, for GameSnapshot (no terrain pointer)
+     */
+    struct SavedState {
+        Position location;
+        Position previousLocation;
+        bool isActive;
+        float fallSpeed;
+        float fallTimer;
+        float fallInterval;
+        bool hasLanded;
+        bool isStable;
+    };
+    
     FallingRock(); // Default constructor
     FallingRock(const Position& startPos, TerrainGrid* terrainRef = nullptr);
     
@@ -25,6 +39,13 @@ public:
     void land() { hasLanded = true; fallSpeed = 0.0f; }
     void setTerrain(TerrainGrid* terrainRef) { terrain = terrainRef; }
     
+    SavedState getSavedState() const;
+    
+    /**
+     * @brief Put the rock back into a saved state; the terrain stays as set
+     */
+    void setSavedState(const SavedState& saved);
+    
     // CanCollide interface
     raylib::Rectangle getBounds() const override;
     void onCollision(const CanCollide& other) override;
@@ -0,0 +1,53 @@
+#include "FixedTimestep.h"
+#include <algorithm>
+#include <cmath>
+
+FixedTimestep::FixedTimestep(float ticksPerSecond, int maxSteps)
+    : tickRate(60.0f), stepSeconds(1.0 / 60.0), timeScale(1.0f), accumulator(0.0),
+      maxStepsPerFrame(std::max(1, maxSteps)), tickCount(0) {
+    setTickRate(ticksPerSecond);
+}
+
+void FixedTimestep::setTickRate(float ticksPerSecond) {
+    if (ticksPerSecond > 0.0f) {
+        tickRate = ticksPerSecond;
+        stepSeconds = 1.0 / ticksPerSecond;
+    }
+}
+
+void FixedTimestep::setTimeScale(float scale) {
+    if (scale > 0.0f) {
+        timeScale = scale;
+    }
+}
+
+int FixedTimestep::advance(float frameTime) {
+    if (frameTime > 0.0f) {
+        accumulator += (double)frameTime * timeScale;
+    }
+    
+    int steps = (int)(accumulator / stepSeconds);
+    
+    // A long hitch would otherwise ask for more ticks than we can run in one
+    // frame and fall further behind every frame; drop the excess time instead.
+    int stepLimit = maxStepsPerFrame * std::max(1, (int)std::ceil(timeScale));
+    if (steps > stepLimit) {
+        steps = stepLimit;
+        accumulator = 0.0;
+    } else {
+        accumulator -= steps * stepSeconds;
+    }
+    
+    tickCount += steps;
+    return steps;
+}
+
+float FixedTimestep::getInterpolationAlpha() const {
+    float alpha = (float)(accumulator / stepSeconds);
+    return std::clamp(alpha, 0.0f, 1.0f);
+}
+
+void FixedTimestep::reset() {
+    accumulator = 0.0;
+    tickCount = 0;
+}
@@ -0,0 +1,65 @@
+#ifndef FIXEDTIMESTEP_H
+#define FIXEDTIMESTEP_H
+
+/**
+ * @brief Accumulator that turns variable frame times into fixed simulation ticks
+ *
+ * Each frame the elapsed time is added to an accumulator and whole ticks are
+ * taken out of it, so the game always advances by the same step no matter how
+ * fast it is rendered. The remainder gives the interpolation factor used when
+ * drawing between two ticks.
+ */
+class FixedTimestep {
+private:
+    float tickRate;
+    double stepSeconds;
+    float timeScale;
+    double accumulator;
+    int maxStepsPerFrame;
+    long long tickCount;
+
+public:
+    /**
+     * @brief Construct a fixed timestep clock
+     * @param ticksPerSecond Simulation tick rate (default 60)
+     * @param maxSteps Most ticks run for one frame before dropping time (default 8)
+     */
+    FixedTimestep(float ticksPerSecond = 60.0f, int maxSteps = 8);
+    
+    /**
+     * @brief Change the simulation tick rate
+     * @param ticksPerSecond New tick rate, must be positive
+     */
+    void setTickRate(float ticksPerSecond);
+    
+    /**
+     * @brief Run the simulation faster or slower than wall-clock time
+     * @param scale Simulated seconds per real second (1 = real time)
+     */
+    void setTimeScale(float scale);
+    
+    /**
+     * @brief Add a frame's worth of time and work out how many ticks to run
+     * @param frameTime Real time since the last frame in seconds
+     * @return Number of fixed ticks the caller should simulate
+     */
+    int advance(float frameTime);
+    
+    /**
+     * @brief How far between the last two ticks the next render is
+     * @return Interpolation factor in [0, 1)
+     */
+    float getInterpolationAlpha() const;
+    
+    float getTickRate() const { return tickRate; }
+    float getStepSeconds() const { return (float)stepSeconds; }
+    float getTimeScale() const { return timeScale; }
+    long long getTickCount() const { return tickCount; }
+    
+    /**
+     * @brief Clear accumulated time and the tick counter
+     */
+    void reset();
+};
+
+#endif // FIXEDTIMESTEP_H
@@ -0,0 +1,109 @@
+#include "FlowField.h"
+#include "TerrainGrid.h"
+
+FlowField::FlowField()
+    : width(0), height(0), target(0, 0), terrainRevision(0), valid(false),
+      rebuildCount(0), currentStamp(0) {
+}
+
+bool FlowField::update(const TerrainGrid& terrain, const Position& targetPos) {
+    if (valid && targetPos == target && terrain.getRevision() == terrainRevision &&
+        terrain.getWidth() == width && terrain.getHeight() == height) {
+        return false;
+    }
+    
+    target = targetPos;
+    terrainRevision = terrain.getRevision();
+    rebuild(terrain);
+    valid = true;
+    rebuildCount++;
+    return true;
+}
+
+void FlowField::rebuild(const TerrainGrid& terrain) {
+    if (terrain.getWidth() != width || terrain.getHeight() != height) {
+        width = terrain.getWidth();
+        height = terrain.getHeight();
+        size_t cells = (size_t)width * height;
+        stamps.assign(cells, 0);
+        distances.assign(cells, 0);
+        steps.assign(cells, NONE);
+        currentStamp = 0;
+    }
+    
+    // Stamps avoid clearing the whole grid, so a rebuild only touches the tunnels
+    currentStamp++;
+    if (currentStamp == 0) {
+        stamps.assign(stamps.size(), 0);
+        currentStamp = 1;
+    }
+    
+    queue.clear();
+    if (!terrain.isValidPosition(target)) {
+        return;
+    }
+    
+    int start = target.y * width + target.x;
+    stamps[start] = currentStamp;
+    distances[start] = 0;
+    steps[start] = NONE;
+    queue.push_back(start);
+    
+    // Each neighbour stores the step that leads back towards the cell it was reached from
+    static const int offsetX[4] = {0, 0, -1, 1};
+    static const int offsetY[4] = {-1, 1, 0, 0};
+    static const uint8_t stepBack[4] = {DOWN, UP, RIGHT, LEFT};
+    
+    for (size_t head = 0; head < queue.size(); head++) {
+        int cell = queue[head];
+        int x = cell % width;
+        int y = cell / width;
+        
+        for (int dir = 0; dir < 4; dir++) {
+            Position neighbour(x + offsetX[dir], y + offsetY[dir]);
+            if (!terrain.isBlockEmpty(neighbour)) {
+                continue;
+            }
+            
+            int index = neighbour.y * width + neighbour.x;
+            if (stamps[index] == currentStamp) {
+                continue;
+            }
+            
+            stamps[index] = currentStamp;
+            distances[index] = distances[cell] + 1;
+            steps[index] = stepBack[dir];
+            queue.push_back(index);
+        }
+    }
+}
+
+bool FlowField::isReached(const Position& pos) const {
+    if (!valid || pos.x < 0 || pos.x >= width || pos.y < 0 || pos.y >= height) {
+        return false;
+    }
+    return stamps[(size_t)pos.y * width + pos.x] == currentStamp;
+}
+
+bool FlowField::getNextStep(const Position& from, Position& next) const {
+    if (!isReached(from)) {
+        return false;
+    }
+    
+    next = from;
+    switch (steps[(size_t)from.y * width + from.x]) {
+        case UP:    next.y--; break;
+        case DOWN:  next.y++; break;
+        case LEFT:  next.x--; break;
+        case RIGHT: next.x++; break;
+        default: return false;
+    }
+    return true;
+}
+
+int FlowField::getDistance(const Position& from) const {
+    if (!isReached(from)) {
+        return -1;
+    }
+    return distances[(size_t)from.y * width + from.x];
+}
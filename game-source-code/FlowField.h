@@ -0,0 +1,83 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include "Position.h"
+#include <cstdint>
+#include <vector>
+
+class TerrainGrid; // Forward declaration
+
+/**
+ * @brief Shared breadth-first flow field leading every monster to the player
+ *
+ * One BFS from the player's tile over the empty cells of the terrain stores,
+ * for each reachable cell, its distance to the player and the step that gets
+ * closer. Monsters then read their next move in O(1), so the pathfinding cost
+ * does not grow with the number of monsters. The field is only rebuilt when
+ * the player moves to another tile or the terrain changes.
+ */
+class FlowField {
+public:
+    enum Step {
+        NONE,
+        UP,
+        DOWN,
+        LEFT,
+        RIGHT
+    };
+
+private:
+    int width;
+    int height;
+    Position target;
+    unsigned long long terrainRevision;
+    bool valid;
+    int rebuildCount;
+    
+    // Row-major per-cell data; a cell is reached only if its stamp is current
+    std::vector<uint32_t> stamps;
+    std::vector<int> distances;
+    std::vector<uint8_t> steps;
+    std::vector<int> queue;
+    uint32_t currentStamp;
+
+public:
+    FlowField();
+    
+    /**
+     * @brief Rebuild the field if the target tile or the terrain has changed
+     * @param terrain Terrain whose empty cells can be walked through
+     * @param targetPos Tile the monsters are heading for (the player)
+     * @return True if the field was rebuilt
+     */
+    bool update(const TerrainGrid& terrain, const Position& targetPos);
+    
+    /**
+     * @brief Force a rebuild on the next update (e.g. after a new level is loaded)
+     */
+    void invalidate() { valid = false; }
+    
+    /**
+     * @brief Next tile on a shortest tunnel path to the target
+     * @param from Current tile
+     * @param next Receives the next tile when a path exists
+     * @return False if from is the target or cannot reach it through tunnels
+     */
+    bool getNextStep(const Position& from, Position& next) const;
+    
+    /**
+     * @brief Tunnel distance from a tile to the target
+     * @param from Tile to measure from
+     * @return Number of steps, or -1 if the target cannot be reached
+     */
+    int getDistance(const Position& from) const;
+    
+    Position getTarget() const { return target; }
+    int getRebuildCount() const { return rebuildCount; }
+
+private:
+    void rebuild(const TerrainGrid& terrain);
+    bool isReached(const Position& pos) const;
+};
+
+#endif // FLOWFIELD_H
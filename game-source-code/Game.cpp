@@ -2,47 +2,83 @@
 
 // Static member definition for SpriteManager
 SpriteManager* SpriteManager::instance = nullptr;
-#include <iostream>
+#include "Logger.h"
+#include "Profiler.h"
+#include "WorkerPool.h"
 #include <cstdlib>
 
-Game::Game() : showSplashScreen(true), splashTimer(0.0f), 
-               player(Position(10, 10)), terrain(1), gameOver(false), playerWon(false),
+Game::Game(InputProvider* inputSource, bool headlessMode, uint64_t runSeed)
+             : showSplashScreen(true), splashTimer(0.0f), 
+               player(Position(10, 10)), terrain(1),
+               seed(runSeed), random(runSeed, Random::GAME_STREAM),
+               gameOver(false), playerWon(false),
                score(0), level(1), monstersKilled(0), gameTime(0.0f), isPaused(false),
                explosionTimer(0.0f), powerUpSpawnTimer(0.0f), rockFallCheckTimer(0.0f),
-               totalMonstersKilled(0), totalScore(0), totalGameTime(0.0f) {
+               totalMonstersKilled(0), totalScore(0), totalGameTime(0.0f),
+               audioManager(nullptr), spriteManager(nullptr),
+               inputProvider(inputSource), headless(headlessMode), showProfiler(false),
+               restoredTerrain(1, 1) {
+    
+    if (!inputProvider) {
+        ownedInput = std::make_unique<KeyboardInput>();
+        inputProvider = ownedInput.get();
+    }
     
+    // Owner handle 0 in every snapshot, whichever Game restores it
+    projectiles.addOwner(&player);
+    restoredProjectiles.addOwner(&player);
     setupLevel();
-    audioManager = AudioManager::getInstance();
-    spriteManager = SpriteManager::getInstance();
-    spriteManager->loadSprites();
-    std::cout << "Dig Dug game initialized" << std::endl;
+    
+    // Headless runs have no window or audio device, so leave both managers alone
+    if (!headless) {
+        audioManager = AudioManager::getInstance();
+        spriteManager = SpriteManager::getInstance();
+        spriteManager->loadSprites();
+    }
+    GAME_LOG_INFO("Dig Dug game initialized%s", headless ? " (headless)" : "");
 }
 
 void Game::setupLevel() {
-    terrain = TerrainGrid(level);
+    GAME_PROFILE_SCOPE("load level");
+    std::unique_ptr<TerrainGrid> preloaded = levelLoader.take(level);
+    if (preloaded) {
+        terrain = std::move(*preloaded);
+    } else {
+        terrain = TerrainGrid(level);
+    }
     Position startPos = terrain.getPlayerStartPosition();
     player = Player(startPos);
     player.setTerrain(&terrain);
     
-    std::cout << "=== LEVEL " << level << " START ===" << std::endl;
-    std::cout << "Player spawned at: (" << startPos.x << ", " << startPos.y << ")" << std::endl;
+    GAME_LOG_INFO("=== LEVEL %d START ===", level);
+    GAME_LOG_INFO("Player spawned at: (%d, %d)", startPos.x, startPos.y);
     
     monsters.clear();
+    monsters.setTerrain(&terrain);
+    monsters.setFlowField(&flowField);
+    monsters.setWorkerPool(WorkerPool::getInstance());
     const auto& monsterPositions = terrain.getMonsterPositions();
+    monsters.reserve((int)monsterPositions.size());
     for (size_t i = 0; i < monsterPositions.size(); i++) {
         Monster::MonsterType type = (i % 3 == 0) ? Monster::GREEN_DRAGON : Monster::RED_MONSTER;
-        monsters.emplace_back(monsterPositions[i], type);
-        std::cout << "Monster spawned at: (" << monsterPositions[i].x << ", " << monsterPositions[i].y << ")" << std::endl;
+        Monster monster(monsterPositions[i], type, &terrain);
+        monster.seedRandom(seed, Random::MONSTER_STREAM_BASE + ((uint64_t)level << 20) + i);
+        monster.setDecisionPhase(DecisionScheduler::getPhase((int)i));
+        monsters.add(monster);
+        GAME_LOG_DEBUG("Monster spawned at: (%d, %d)", monsterPositions[i].x, monsterPositions[i].y);
     }
+    rebuildMonsterIndex();
     
     fallingRocks.clear();
     powerUps.clear();
+    flowField.invalidate();
+    terrainRenderer.invalidate();
     
     // Only check rock stability ONCE at level start
     terrain.checkAllRocksForFalling();
     checkForTriggeredRockFalls();
     
-    std::cout << "Level " << level << " ready: " << monsters.size() << " monsters" << std::endl;
+    GAME_LOG_INFO("Level %d ready: %d monsters", level, (int)monsters.size());
 }
 
 void Game::addScore(int points) {
@@ -58,7 +94,7 @@ void Game::createExplosion(const Position& pos) {
     
     animationManager.addExplosion(pos);
     animationManager.addScreenShake(3.0f, 0.3f);
-    audioManager->playMonsterDestroy();
+    if (audioManager) audioManager->playMonsterDestroy();
 }
 
 void Game::nextLevel() {
@@ -82,63 +118,199 @@ void Game::nextLevel() {
     playerWon = false;
     gameTime = 0.0f;
     
-    audioManager->playLevelComplete();
-    std::cout << "Advanced to level " << level << std::endl;
+    if (audioManager) audioManager->playLevelComplete();
+    GAME_LOG_INFO("Advanced to level %d", level);
 }
 
 void Game::pauseToggle() {
     isPaused = !isPaused;
 }
 
+void Game::startLevel(int levelNumber) {
+    level = levelNumber;
+    score = 0;
+    monstersKilled = 0;
+    totalScore = 0;
+    totalMonstersKilled = 0;
+    totalGameTime = 0.0f;
+    showSplashScreen = false;
+    isPaused = false;
+    gameOver = false;
+    playerWon = false;
+    gameTime = 0.0f;
+    powerUpSpawnTimer = 0.0f;
+    rockFallCheckTimer = 0.0f;
+    projectiles.clear();
+    powerUps.clear();
+    fallingRocks.clear();
+    explosionEffects.clear();
+    setupLevel();
+}
+
+void Game::saveSnapshot(GameSnapshot& snapshot) const {
+    GAME_PROFILE_SCOPE("save snapshot");
+    snapshot.beginWrite();
+    snapshot.write(seed);
+    snapshot.write(random);
+    snapshot.write(showSplashScreen);
+    snapshot.write(splashTimer);
+    snapshot.write(gameOver);
+    snapshot.write(playerWon);
+    snapshot.write(isPaused);
+    snapshot.write(score);
+    snapshot.write(level);
+    snapshot.write(monstersKilled);
+    snapshot.write(gameTime);
+    snapshot.write(totalScore);
+    snapshot.write(totalMonstersKilled);
+    snapshot.write(totalGameTime);
+    snapshot.write(powerUpSpawnTimer);
+    snapshot.write(rockFallCheckTimer);
+    snapshot.write(explosionTimer);
+    snapshot.writeVector(explosionEffects);
+    
+    snapshot.write(player.getSavedState());
+    terrain.saveState(snapshot);
+    monsters.saveState(snapshot);
+    // Saved rather than rebuilt on restore: when a rock lands on several
+    // monsters, checkFallingRockCollisions removes them in tile-list order,
+    // and each swap-and-pop renumbers the store, so a rebuilt list order
+    // would leave the survivors in a different order
+    monsterIndex.saveState(snapshot);
+    projectiles.saveState(snapshot);
+    snapshot.writeStates(powerUps);
+    snapshot.writeStates(fallingRocks);
+    snapshot.endWrite();
+}
+
+bool Game::restoreSnapshot(const GameSnapshot& snapshot) {
+    GAME_PROFILE_SCOPE("restore snapshot");
+    GameSnapshot::Reader in(snapshot);
+    if (!in.isValid()) {
+        GAME_LOG_ERROR("Snapshot is empty or from another version, not restored");
+        return false;
+    }
+    
+    // Read into locals and the scratch members first, so a snapshot that
+    // turns out to be damaged halfway through leaves the game as it was
+    struct {
+        uint64_t seed;
+        Random random;
+        bool showSplashScreen;
+        float splashTimer;
+        bool gameOver;
+        bool playerWon;
+        bool isPaused;
+        int score;
+        int level;
+        int monstersKilled;
+        float gameTime;
+        int totalScore;
+        int totalMonstersKilled;
+        float totalGameTime;
+        float powerUpSpawnTimer;
+        float rockFallCheckTimer;
+        float explosionTimer;
+    } saved;
+    Player::SavedState playerState;
+    bool restored = in.read(saved.seed) && in.read(saved.random) && in.read(saved.showSplashScreen) &&
+                    in.read(saved.splashTimer) && in.read(saved.gameOver) && in.read(saved.playerWon) &&
+                    in.read(saved.isPaused) && in.read(saved.score) && in.read(saved.level) &&
+                    in.read(saved.monstersKilled) && in.read(saved.gameTime) && in.read(saved.totalScore) &&
+                    in.read(saved.totalMonstersKilled) && in.read(saved.totalGameTime) &&
+                    in.read(saved.powerUpSpawnTimer) && in.read(saved.rockFallCheckTimer) &&
+                    in.read(saved.explosionTimer) && in.readVector(restoredExplosions) && in.read(playerState) &&
+                    playerState.isValid() && restoredTerrain.restoreState(in) && restoredMonsters.restoreState(in) &&
+                    restoredMonsterIndex.restoreState(in, restoredTerrain.getWidth(), restoredTerrain.getHeight(),
+                                                      restoredMonsters.size()) &&
+                    restoredProjectiles.restoreState(in) && in.readStates(restoredPowerUps) &&
+                    in.readStates(restoredFallingRocks) && in.isFinished();
+    if (!restored) {
+        GAME_LOG_ERROR("Snapshot is corrupt, game left unchanged");
+        return false;
+    }
+    
+    seed = saved.seed;
+    random = saved.random;
+    showSplashScreen = saved.showSplashScreen;
+    splashTimer = saved.splashTimer;
+    gameOver = saved.gameOver;
+    playerWon = saved.playerWon;
+    isPaused = saved.isPaused;
+    score = saved.score;
+    level = saved.level;
+    monstersKilled = saved.monstersKilled;
+    gameTime = saved.gameTime;
+    totalScore = saved.totalScore;
+    totalMonstersKilled = saved.totalMonstersKilled;
+    totalGameTime = saved.totalGameTime;
+    powerUpSpawnTimer = saved.powerUpSpawnTimer;
+    rockFallCheckTimer = saved.rockFallCheckTimer;
+    explosionTimer = saved.explosionTimer;
+    explosionEffects.swap(restoredExplosions);
+    player.setSavedState(playerState);
+    
+    // Swapping keeps every object's address, so pointers into the game stay valid
+    terrain.swapState(restoredTerrain);
+    monsters.swapState(restoredMonsters);
+    std::swap(monsterIndex, restoredMonsterIndex);
+    projectiles.swapState(restoredProjectiles);
+    powerUps.swap(restoredPowerUps);
+    fallingRocks.swap(restoredFallingRocks);
+    for (auto& rock : fallingRocks) {
+        rock.setTerrain(&terrain);
+    }
+    flowField.invalidate();
+    terrainRenderer.invalidate();
+    return true;
+}
+
+void Game::beginFrame() {
+    GAME_PROFILE_FRAME();
+    inputProvider->beginFrame();
+}
+
 void Game::update(float deltaTime) {
-    animationManager.update(deltaTime);
+    GAME_PROFILE_SCOPE("update");
+    input = inputProvider->poll();
+    if (input.isPressed(InputState::TOGGLE_PROFILER)) {
+        showProfiler = !showProfiler;
+    }
+    {
+        GAME_PROFILE_SCOPE("animations");
+        animationManager.update(deltaTime);
+    }
     
     if (showSplashScreen) {
         splashTimer += deltaTime;
         
-        if (splashTimer > 10.0f || IsKeyPressed(KEY_SPACE) || IsKeyPressed(KEY_ENTER)) {
+        if (splashTimer > 10.0f || input.isPressed(InputState::FIRE) || input.isPressed(InputState::CONFIRM)) {
             showSplashScreen = false;
         }
-    } else if (IsKeyPressed(KEY_P)) {
+    } else if (input.isPressed(InputState::PAUSE)) {
         pauseToggle();
-    } else if (IsKeyPressed(KEY_M) && isPaused) {
-        audioManager->toggleSound();
+    } else if (input.isPressed(InputState::TOGGLE_SOUND) && isPaused) {
+        if (audioManager) audioManager->toggleSound();
     } else if (isPaused) {
         return;
     } else if (!gameOver) {
         gameTime += deltaTime;
         totalGameTime += deltaTime;
         
-        player.update(deltaTime);
+        storePreviousPositions();
+        player.setInput(input);
+        {
+            GAME_PROFILE_SCOPE("player");
+            player.update(deltaTime);
+        }
         updateMonsters(deltaTime);
         updateProjectiles(deltaTime);
         updateExplosions(deltaTime);
         updatePowerUps(deltaTime);
         updateFallingRocks(deltaTime);
         
-        if (IsKeyPressed(KEY_SPACE)) {
-            if (!player.isReloading()) {
-                int playerFacing = static_cast<int>(player.getFacingDirection());
-                Projectile::Direction projDir;
-                
-                switch (playerFacing) {
-                    case 1: projDir = Projectile::UP; break;
-                    case 2: projDir = Projectile::DOWN; break;
-                    case 3: projDir = Projectile::LEFT; break;
-                    case 4: projDir = Projectile::RIGHT; break;
-                    default: projDir = Projectile::RIGHT; break;
-                }
-                
-                int range = player.getCurrentHarpoonRange();
-                Projectile* newProjectile = new Projectile(&player, projDir, range);
-                
-                if (newProjectile) {
-                    projectiles.emplace_back(std::unique_ptr<Projectile>(newProjectile));
-                    player.fireWeapon();
-                    audioManager->playHarpoonFire();
-                    std::cout << "Harpoon fired" << std::endl;
-                }
-            }
+        if (input.isPressed(InputState::FIRE)) {
+            fireHarpoon();
         }
         
         float spawnInterval = std::max(15.0f, 35.0f - (level * 3.0f));
@@ -168,7 +340,10 @@ void Game::update(float deltaTime) {
             addScore(calculateLevelScore());
         }
     } else {
-        if (IsKeyPressed(KEY_R)) {
+        // Whatever key comes next, N or R, its level is loading already
+        levelLoader.preload((playerWon && level < 5) ? level + 1 : 1);
+        
+        if (input.isPressed(InputState::RESTART)) {
             level = 1;
             score = 0;
             monstersKilled = 0;
@@ -185,9 +360,9 @@ void Game::update(float deltaTime) {
             fallingRocks.clear();
             explosionEffects.clear();
             setupLevel();
-        } else if (IsKeyPressed(KEY_N) && playerWon) {
+        } else if (input.isPressed(InputState::NEXT_LEVEL) && playerWon) {
             if (level >= 5) {
-                std::cout << "All levels completed!" << std::endl;
+                GAME_LOG_INFO("All levels completed!");
             } else {
                 nextLevel();
             }
@@ -195,7 +370,46 @@ void Game::update(float deltaTime) {
     }
 }
 
-void Game::draw() const {
+void Game::fireHarpoon() {
+    if (player.isReloading()) {
+        return;
+    }
+    
+    int playerFacing = static_cast<int>(player.getFacingDirection());
+    Projectile::Direction projDir;
+    
+    switch (playerFacing) {
+        case 1: projDir = Projectile::UP; break;
+        case 2: projDir = Projectile::DOWN; break;
+        case 3: projDir = Projectile::LEFT; break;
+        case 4: projDir = Projectile::RIGHT; break;
+        default: projDir = Projectile::RIGHT; break;
+    }
+    
+    int range = player.getCurrentHarpoonRange();
+    ProjectileHandle newProjectile = projectiles.spawn(&player, projDir, range);
+    
+    if (newProjectile.isValid()) {
+        player.fireWeapon();
+        if (audioManager) audioManager->playHarpoonFire();
+        GAME_LOG_DEBUG("Harpoon fired");
+    } else {
+        GAME_LOG_DEBUG("No free harpoon slot, shot skipped");
+    }
+}
+
+void Game::draw(float interpolation) const {
+    GAME_PROFILE_SCOPE("draw");
+    if (headless) {
+        return;
+    }
+    
+    // Texture mode resets the matrix stack, so refresh the cache before the shake offset
+    {
+        GAME_PROFILE_SCOPE("terrain cache");
+        terrainRenderer.update(terrain);
+    }
+    
     Position shakeOffset = animationManager.getShakeOffset();
     
     if (showSplashScreen) {
@@ -210,14 +424,21 @@ void Game::draw() const {
             rlTranslatef(shakeOffset.x, shakeOffset.y, 0);
         }
         
-        drawGameplay();
+        drawGameplay(interpolation);
         
         if (shakeOffset.x != 0 || shakeOffset.y != 0) {
             rlPopMatrix();
         }
     }
     
-    animationManager.drawAnimations();
+    {
+        GAME_PROFILE_SCOPE("draw animations");
+        animationManager.drawAnimations();
+    }
+    
+    if (showProfiler) {
+        drawProfiler();
+    }
 }
 
 void Game::drawSplashScreen() const {
@@ -255,43 +476,95 @@ void Game::drawSplashScreen() const {
     }
 }
 
-void Game::drawGameplay() const {
-    terrain.draw();
+void Game::drawGameplay(float interpolation) const {
+    {
+        GAME_PROFILE_SCOPE("draw terrain");
+        terrainRenderer.draw(terrain);
+    }
     
-    for (const auto& rock : fallingRocks) {
-        rock.draw();
+    {
+        GAME_PROFILE_SCOPE("draw rocks");
+        for (const auto& rock : fallingRocks) {
+            drawInterpolated(rock, interpolation);
+        }
     }
     
-    for (const auto& powerUp : powerUps) {
-        powerUp.draw();
+    {
+        GAME_PROFILE_SCOPE("draw power-ups");
+        for (const auto& powerUp : powerUps) {
+            powerUp.draw();
+        }
     }
     
-    for (const auto& monster : monsters) {
-        monster.draw();
+    {
+        GAME_PROFILE_SCOPE("draw monsters");
+        for (int i = 0; i < monsters.size(); i++) {
+            drawInterpolatedMonster(i, interpolation);
+        }
     }
     
-    for (const auto& projectile : projectiles) {
-        projectile->draw();
+    {
+        GAME_PROFILE_SCOPE("draw harpoons");
+        for (const auto& projectile : projectiles) {
+            drawInterpolated(projectile, interpolation);
+        }
     }
     
     drawExplosions();
-    player.draw();
+    drawInterpolated(player, interpolation);
     drawHUD();
 }
 
+void Game::drawInterpolated(const GameThing& thing, float interpolation) const {
+    Vector2 offset = thing.getRenderOffset(interpolation);
+    if (offset.x == 0.0f && offset.y == 0.0f) {
+        thing.draw();
+        return;
+    }
+    
+    rlPushMatrix();
+    rlTranslatef(offset.x, offset.y, 0);
+    thing.draw();
+    rlPopMatrix();
+}
+
+void Game::drawInterpolatedMonster(int index, float interpolation) const {
+    Vector2 offset = monsters.getRenderOffset(index, interpolation);
+    if (offset.x == 0.0f && offset.y == 0.0f) {
+        monsters.draw(index);
+        return;
+    }
+    
+    rlPushMatrix();
+    rlTranslatef(offset.x, offset.y, 0);
+    monsters.draw(index);
+    rlPopMatrix();
+}
+
+void Game::storePreviousPositions() {
+    player.storePreviousPosition();
+    monsters.storePreviousPositions();
+    for (auto& projectile : projectiles) {
+        projectile.storePreviousPosition();
+    }
+    for (auto& rock : fallingRocks) {
+        rock.storePreviousPosition();
+    }
+}
+
 void Game::drawPauseScreen() const {
-    terrain.draw();
+    terrainRenderer.draw(terrain);
     for (const auto& rock : fallingRocks) {
         rock.draw();
     }
     for (const auto& powerUp : powerUps) {
         powerUp.draw();
     }
-    for (const auto& monster : monsters) {
-        monster.draw();
+    for (int i = 0; i < monsters.size(); i++) {
+        monsters.draw(i);
     }
     for (const auto& projectile : projectiles) {
-        projectile->draw();
+        projectile.draw();
     }
     player.draw();
     
@@ -300,7 +573,7 @@ void Game::drawPauseScreen() const {
     const char* pausedText = "PAUSED";
     const char* continueText = "Press P to continue";
     const char* soundText = "Press M to toggle sound";
-    const char* soundStatus = audioManager->isSoundEnabled() ? "Sound: ON" : "Sound: OFF";
+    const char* soundStatus = (audioManager && audioManager->isSoundEnabled()) ? "Sound: ON" : "Sound: OFF";
     
     DrawText(pausedText, 400 - MeasureText(pausedText, 48)/2, 250, 48, WHITE);
     DrawText(continueText, 400 - MeasureText(continueText, 24)/2, 320, 24, YELLOW);
@@ -309,18 +582,18 @@ void Game::drawPauseScreen() const {
 }
 
 void Game::drawGameOver() const {
-    terrain.draw();
+    terrainRenderer.draw(terrain);
     for (const auto& rock : fallingRocks) {
         rock.draw();
     }
     for (const auto& powerUp : powerUps) {
         powerUp.draw();
     }
-    for (const auto& monster : monsters) {
-        monster.draw();
+    for (int i = 0; i < monsters.size(); i++) {
+        monsters.draw(i);
     }
     for (const auto& projectile : projectiles) {
-        projectile->draw();
+        projectile.draw();
     }
     drawExplosions();
     player.draw();
@@ -390,6 +663,7 @@ void Game::drawGameOver() const {
 }
 
 void Game::drawHUD() const {
+    GAME_PROFILE_SCOPE("draw HUD");
     DrawRectangle(0, 0, 800, 50, ColorAlpha(BLACK, 0.9f));
     
     DrawText(TextFormat("Score: %d", score), 10, 5, 16, getScoreColor());
@@ -397,18 +671,18 @@ void Game::drawHUD() const {
     DrawText(TextFormat("Time: %.1fs", gameTime), 250, 5, 16, WHITE);
     DrawText(TextFormat("Killed: %d", monstersKilled), 370, 5, 16, RED);
     
-    DrawText(TextFormat("Harpoons: %d", (int)projectiles.size()), 10, 25, 16, LIME);
+    DrawText(TextFormat("Harpoons: %d", projectiles.size()), 10, 25, 16, LIME);
     DrawText(TextFormat("PowerUps: %d", (int)powerUps.size()), 150, 25, 16, PURPLE);
     DrawText(TextFormat("Rocks: %d", (int)fallingRocks.size()), 250, 25, 16, YELLOW);
-    DrawText(TextFormat("Monsters: %d", (int)monsters.size()), 370, 25, 16, ORANGE);
+    DrawText(TextFormat("Monsters: %d", monsters.size()), 370, 25, 16, ORANGE);
     
     if (!monsters.empty()) {
         DrawRectangle(0, 560, 800, 40, ColorAlpha(BLACK, 0.9f));
         int xOffset = 10;
-        for (size_t i = 0; i < monsters.size() && i < 5; ++i) {
+        for (int i = 0; i < monsters.size() && i < 5; ++i) {
             const char* stateText = "";
             Color stateColor = WHITE;
-            switch (monsters[i].getBehaviorState()) {
+            switch (monsters.getBehaviorState(i)) {
                 case Monster::PATROLLING: 
                     stateText = "Patrol"; 
                     stateColor = GREEN;
@@ -422,15 +696,51 @@ void Game::drawHUD() const {
                     stateColor = RED;
                     break;
             }
-            const char* typeText = (monsters[i].getType() == Monster::RED_MONSTER) ? "Red" : "Dragon";
-            DrawText(TextFormat("%s %d:", typeText, (int)i+1), xOffset, 565, 12, WHITE);
+            const char* typeText = (monsters.getType(i) == Monster::RED_MONSTER) ? "Red" : "Dragon";
+            DrawText(TextFormat("%s %d:", typeText, i+1), xOffset, 565, 12, WHITE);
             DrawText(stateText, xOffset, 580, 12, stateColor);
             xOffset += 150;
         }
     }
 }
 
+void Game::drawProfiler() const {
+    const int panelX = 480;
+    const int panelY = 55;
+    const int lineHeight = 14;
+
+#if GAME_PROFILE
+    Profiler* profiler = Profiler::getInstance();
+    std::vector<Profiler::SectionStats> sections = profiler->summarize();
+    int frameTotal = profiler->getFinishedFrameCount();
+    double frameMs = 0.0;
+    for (int age = 0; age < frameTotal; age++) {
+        frameMs += profiler->getFinishedFrame(age).durationNs / 1.0e6;
+    }
+    frameMs /= std::max(1, frameTotal);
+    
+    int rows = std::min((int)sections.size(), 30);
+    DrawRectangle(panelX, panelY, 315, (rows + 2) * lineHeight + 8, ColorAlpha(BLACK, 0.8f));
+    DrawText(TextFormat("Profiler (F3)  frame %.2f ms avg", frameMs), panelX + 5, panelY + 4, 12, YELLOW);
+    DrawText("section", panelX + 5, panelY + 4 + lineHeight, 12, GRAY);
+    DrawText("last     avg     max", panelX + 175, panelY + 4 + lineHeight, 12, GRAY);
+    
+    for (int i = 0; i < rows; i++) {
+        const Profiler::SectionStats& section = sections[i];
+        int y = panelY + 4 + (i + 2) * lineHeight;
+        Color color = (section.averageMs > 1.0) ? RED : (section.averageMs > 0.25) ? ORANGE : WHITE;
+        DrawText(section.name, panelX + 5 + section.depth * 10, y, 12, color);
+        DrawText(TextFormat("%6.3f  %6.3f  %6.3f", section.lastMs, section.averageMs, section.maxMs),
+                 panelX + 175, y, 12, color);
+    }
+#else
+    DrawRectangle(panelX, panelY, 315, lineHeight + 8, ColorAlpha(BLACK, 0.8f));
+    DrawText("Profiler compiled out (GAME_PROFILE=0)", panelX + 5, panelY + 4, 12, GRAY);
+#endif
+}
+
 void Game::drawExplosions() const {
+    GAME_PROFILE_SCOPE("draw explosions");
     for (const auto& pos : explosionEffects) {
         Position pixelPos = pos.toPixels();
         
@@ -448,27 +758,28 @@ void Game::drawExplosions() const {
 }
 
 void Game::updateMonsters(float deltaTime) {
+    GAME_PROFILE_SCOPE("monsters");
     Position playerPos = player.getPosition();
     
-    for (auto& monster : monsters) {
-        monster.setTarget(playerPos);
-        monster.update(deltaTime);
+    // One BFS serves every monster, and only when the player or the tunnels changed
+    flowField.update(terrain, playerPos);
+    
+    monsters.update(deltaTime, playerPos);
+    
+    // Only monsters that changed tile touch the index
+    for (int i = 0; i < monsters.size(); i++) {
+        monsterIndex.update(i, monsters.getPosition(i));
     }
 }
 
 void Game::updateProjectiles(float deltaTime) {
-    for (auto& projectile : projectiles) {
-        projectile->update(deltaTime);
-    }
-    
-    auto it = std::remove_if(projectiles.begin(), projectiles.end(),
-        [](const std::unique_ptr<Projectile>& p) { 
-            return p->isFinished(); 
-        });
-    projectiles.erase(it, projectiles.end());
+    GAME_PROFILE_SCOPE("projectiles");
+    projectiles.update(deltaTime);
+    projectiles.retireFinished();
 }
 
 void Game::updateExplosions(float deltaTime) {
+    GAME_PROFILE_SCOPE("explosions");
     if (explosionTimer > 0.0f) {
         explosionTimer -= deltaTime;
         if (explosionTimer <= 0.0f) {
@@ -478,81 +789,78 @@ void Game::updateExplosions(float deltaTime) {
 }
 
 void Game::updatePowerUps(float deltaTime) {
+    GAME_PROFILE_SCOPE("power-ups");
     for (auto& powerUp : powerUps) {
         powerUp.update(deltaTime);
     }
 }
 
 void Game::updateFallingRocks(float deltaTime) {
+    GAME_PROFILE_SCOPE("falling rocks");
     for (auto& rock : fallingRocks) {
         rock.update(deltaTime);
     }
     
     auto it = std::remove_if(fallingRocks.begin(), fallingRocks.end(),
-        [this](const FallingRock& rock) { 
-            if (rock.isLanded()) {
-                checkForCascadingRockFalls();
-                return true;
-            }
-            return false;
-        });
-    fallingRocks.erase(it, fallingRocks.end());
+        [](const FallingRock& rock) { return rock.isLanded(); });
+    
+    // Landing only changes the cells the landed rocks touched, so a single
+    // incremental check covers all of them
+    if (it != fallingRocks.end()) {
+        fallingRocks.erase(it, fallingRocks.end());
+        checkForCascadingRockFalls();
+    }
 }
 
 void Game::checkCollisions() {
+    GAME_PROFILE_SCOPE("player collisions");
     Position playerPos = player.getPosition();
     
-    for (auto it = monsters.begin(); it != monsters.end(); ) {
-        if (it->getPosition() == playerPos && !player.isInvulnerable()) {
-            gameOver = true;
-            playerWon = false;
-            audioManager->playPlayerHit();
-            animationManager.addScreenShake(5.0f, 0.5f);
-            std::cout << "Player caught!" << std::endl;
-            return;
-        }
-        ++it;
+    if (monsterIndex.firstAt(playerPos) != SpatialIndex::NONE && !player.isInvulnerable()) {
+        gameOver = true;
+        playerWon = false;
+        if (audioManager) audioManager->playPlayerHit();
+        animationManager.addScreenShake(5.0f, 0.5f);
+        GAME_LOG_INFO("Player caught!");
     }
 }
 
 void Game::checkProjectileCollisions() {
-    for (auto projIt = projectiles.begin(); projIt != projectiles.end(); ) {
+    GAME_PROFILE_SCOPE("harpoon collisions");
+    for (int projIndex = 0; projIndex < projectiles.size(); ) {
         bool projectileHit = false;
-        Position projPos = (*projIt)->getPosition();
+        Position projPos = projectiles.at(projIndex).getPosition();
         
-        for (auto monsterIt = monsters.begin(); monsterIt != monsters.end(); ) {
-            if (monsterIt->getPosition() == projPos) {
-                createExplosion(projPos);
-                audioManager->playHarpoonHit();
-                animationManager.addHarpoonImpact(projPos);
-                
-                int basePoints = (monsterIt->getType() == Monster::GREEN_DRAGON) ? 200 : 100;
-                int points = basePoints + (level * 50);
-                addScore(points);
-                monstersKilled++;
-                totalMonstersKilled++;
-                
-                if (rand() % 4 == 0) {
-                    spawnRandomPowerUp(projPos);
-                }
-                
-                monsterIt = monsters.erase(monsterIt);
-                projectileHit = true;
-                break;
-            } else {
-                ++monsterIt;
+        int monsterId = findMonsterAt(projPos);
+        if (monsterId != SpatialIndex::NONE) {
+            createExplosion(projPos);
+            if (audioManager) audioManager->playHarpoonHit();
+            animationManager.addHarpoonImpact(projPos);
+            
+            int basePoints = (monsters.getType(monsterId) == Monster::GREEN_DRAGON) ? 200 : 100;
+            int points = basePoints + (level * 50);
+            addScore(points);
+            monstersKilled++;
+            totalMonstersKilled++;
+            
+            if (random.oneIn(4)) {
+                spawnRandomPowerUp(projPos);
             }
+            
+            removeMonster(monsterId);
+            projectileHit = true;
         }
         
         if (projectileHit) {
-            projIt = projectiles.erase(projIt);
+            projectiles.releaseAt(projIndex);
         } else {
-            ++projIt;
+            ++projIndex;
         }
     }
 }
 
 void Game::checkPowerUpCollisions() {
+    GAME_PROFILE_SCOPE("power-up collisions");
     Position playerPos = player.getPosition();
     
     for (auto it = powerUps.begin(); it != powerUps.end(); ) {
@@ -572,7 +880,7 @@ void Game::checkPowerUpCollisions() {
                 case PowerUp::INVULNERABILITY: powerUpName = "Invulnerability"; break;
             }
             
-            std::cout << powerUpName << " power-up collected!" << std::endl;
+            GAME_LOG_INFO("%s power-up collected!", powerUpName);
             it = powerUps.erase(it);
         } else {
             ++it;
@@ -581,6 +889,7 @@ void Game::checkPowerUpCollisions() {
 }
 
 void Game::checkFallingRockCollisions() {
+    GAME_PROFILE_SCOPE("rock collisions");
     Position playerPos = player.getPosition();
     
     for (auto& rock : fallingRocks) {
@@ -589,26 +898,49 @@ void Game::checkFallingRockCollisions() {
         if (rockPos == playerPos && !player.isInvulnerable()) {
             gameOver = true;
             playerWon = false;
-            std::cout << "Player crushed by rock!" << std::endl;
+            GAME_LOG_INFO("Player crushed by rock!");
             return;
         }
         
-        for (auto monsterIt = monsters.begin(); monsterIt != monsters.end(); ) {
-            if (monsterIt->getPosition() == rockPos) {
-                createExplosion(rockPos);
-                addScore(150 + (level * 75));
-                monstersKilled++;
-                totalMonstersKilled++;
-                monsterIt = monsters.erase(monsterIt);
-                std::cout << "Monster crushed by rock!" << std::endl;
-            } else {
-                ++monsterIt;
-            }
+        int monsterId;
+        while ((monsterId = monsterIndex.firstAt(rockPos)) != SpatialIndex::NONE) {
+            createExplosion(rockPos);
+            addScore(150 + (level * 75));
+            monstersKilled++;
+            totalMonstersKilled++;
+            removeMonster(monsterId);
+            GAME_LOG_INFO("Monster crushed by rock!");
+        }
+    }
+}
+
+void Game::rebuildMonsterIndex() {
+    monsterIndex.reset(terrain.getWidth(), terrain.getHeight());
+    for (int i = 0; i < monsters.size(); i++) {
+        monsterIndex.insert(monsters.getPosition(i));
+    }
+}
+
+int Game::findMonsterAt(const Position& pos) const {
+    // Several monsters can share a tile; the harpoon hits the lowest monster index,
+    // as the old linear scan over `monsters` did
+    int found = SpatialIndex::NONE;
+    for (int id = monsterIndex.firstAt(pos); id != SpatialIndex::NONE; id = monsterIndex.nextAt(id)) {
+        if (found == SpatialIndex::NONE || id < found) {
+            found = id;
         }
     }
+    return found;
+}
+
+void Game::removeMonster(int index) {
+    // Swap-and-pop keeps removal O(1); the index renumbers the moved monster
+    monsterIndex.removeSwapLast(index);
+    monsters.remove(index);
 }
 
 void Game::checkForTriggeredRockFalls() {
+    GAME_PROFILE_SCOPE("rock falls");
     std::vector<Position> triggeredFalls = terrain.getTriggeredRockFalls();
     
     for (const auto& rockPos : triggeredFalls) {
@@ -623,13 +955,14 @@ void Game::checkForTriggeredRockFalls() {
         if (!alreadyFalling) {
             terrain.removeRockAt(rockPos);
             fallingRocks.emplace_back(rockPos, &terrain);
-            std::cout << "Rock starts falling at (" << rockPos.x << ", " << rockPos.y << ")" << std::endl;
+            GAME_LOG_DEBUG("Rock starts falling at (%d, %d)", rockPos.x, rockPos.y);
         }
     }
 }
 
 void Game::checkForCascadingRockFalls() {
-    terrain.checkAllRocksForFalling();
+    GAME_PROFILE_SCOPE("rock stability");
+    terrain.checkDirtyRocksForFalling();
     checkForTriggeredRockFalls();
 }
 
@@ -644,7 +977,8 @@ void Game::spawnPowerUp() {
     Position spawnPos;
     int attempts = 0;
     do {
-        spawnPos = Position(8 + rand() % 25, 8 + rand() % 15);
+        spawnPos = Position(8 + random.nextInt(std::max(1, terrain.getWidth() - 15)),
+                            8 + random.nextInt(std::max(1, terrain.getHeight() - 15)));
         attempts++;
     } while (!terrain.isBlockEmpty(spawnPos) && attempts < 20);
     
@@ -654,9 +988,9 @@ void Game::spawnPowerUp() {
 }
 
 void Game::spawnRandomPowerUp(const Position& pos) {
-    PowerUp::PowerUpType type = static_cast<PowerUp::PowerUpType>(rand() % 4);
+    PowerUp::PowerUpType type = static_cast<PowerUp::PowerUpType>(random.nextInt(4));
     powerUps.emplace_back(pos, type);
-    std::cout << "Power-up spawned at (" << pos.x << ", " << pos.y << ")" << std::endl;
+    GAME_LOG_DEBUG("Power-up spawned at (%d, %d)", pos.x, pos.y);
 }
 
 bool Game::allMonstersDestroyed() const {
@@ -8,12 +8,21 @@
 #include "Player.h"
 #include "TerrainGrid.h"
 #include "Monster.h"
+#include "MonsterStore.h"
 #include "Projectile.h"
+#include "ProjectilePool.h"
 #include "PowerUp.h"
 #include "FallingRock.h"
+#include "GameSnapshot.h"
 #include "AudioManager.h"
 #include "AnimationManager.h"
 #include "SpriteManager.h"
+#include "InputProvider.h"
+#include "FlowField.h"
+#include "SpatialIndex.h"
+#include "TerrainRenderer.h"
+#include "LevelLoader.h"
+#include "Random.h"
 
 class Game {
 private:
@@ -22,10 +31,16 @@ private:
     
     Player player;
     TerrainGrid terrain;
-    std::vector<Monster> monsters;
-    std::vector<std::unique_ptr<Projectile>> projectiles;
+    MonsterStore monsters;  // ids are indices, shared with monsterIndex
+    ProjectilePool projectiles;
     std::vector<PowerUp> powerUps;
     std::vector<FallingRock> fallingRocks;
+    FlowField flowField;
+    SpatialIndex monsterIndex;  // ids are indices into monsters
+    
+    // Every random decision comes from the seed, so a run can be repeated exactly
+    uint64_t seed;
+    Random random;
     
     bool gameOver;
     bool playerWon;
@@ -50,15 +65,70 @@ private:
     AudioManager* audioManager;
     SpriteManager* spriteManager;
     AnimationManager animationManager;
+    mutable TerrainRenderer terrainRenderer;  // render cache, refreshed by draw()
+    LevelLoader levelLoader;  // loads the next level while the between-levels screen is up
     
     // Visual effects
     std::vector<Position> explosionEffects;
     float explosionTimer;
     
+    // Input source and headless mode
+    std::unique_ptr<InputProvider> ownedInput;
+    InputProvider* inputProvider;
+    InputState input;
+    bool headless;
+    bool showProfiler;  // per-subsystem timing overlay, toggled with F3
+    
+    // restoreSnapshot reads into these and swaps them in only once the whole
+    // snapshot has checked out; the state swapped out is reused next time
+    TerrainGrid restoredTerrain;
+    MonsterStore restoredMonsters;
+    SpatialIndex restoredMonsterIndex;
+    ProjectilePool restoredProjectiles;
+    std::vector<Position> restoredExplosions;
+    std::vector<PowerUp> restoredPowerUps;
+    std::vector<FallingRock> restoredFallingRocks;
+
 public:
-    Game();
+    /**
+     * @brief Construct a game
+     * @param inputSource Where player input comes from (nullptr = keyboard)
+     * @param headlessMode Skip sprite/audio setup and all drawing, for runs without a window
+     */
+    Game(InputProvider* inputSource = nullptr, bool headlessMode = false,
+         uint64_t runSeed = Random::DEFAULT_SEED);
+    
+    /**
+     * @brief Start a rendered frame; call once per frame before its updates
+     */
+    void beginFrame();
+    
+    /**
+     * @brief Advance the simulation by one fixed tick
+     * @param deltaTime Tick length in seconds
+     */
     void update(float deltaTime);
-    void draw() const;
+    
+    /**
+     * @brief Draw the game
+     * @param interpolation How far between the last two ticks to draw moving objects (0-1)
+     */
+    void draw(float interpolation = 1.0f) const;
+    
+    // State queries for tests, bots and headless runs
+    bool isHeadless() const { return headless; }
+    bool isOnSplashScreen() const { return showSplashScreen; }
+    bool isGameOver() const { return gameOver; }
+    bool hasPlayerWon() const { return playerWon; }
+    int getScore() const { return score; }
+    int getLevel() const { return level; }
+    int getMonsterCount() const { return (int)monsters.size(); }
+    Position getMonsterPosition(int index) const { return monsters.getPosition(index); }
+    int getProjectileCount() const { return projectiles.size(); }
+    Position getPlayerPosition() const { return player.getPosition(); }
+    const TerrainGrid& getTerrain() const { return terrain; }
+    uint64_t getSeed() const { return seed; }
+    const LevelLoader& getLevelLoader() const { return levelLoader; }
     
     // Enhanced methods
     void addScore(int points);
@@ -66,14 +136,45 @@ public:
     void nextLevel();
     void pauseToggle();
     
+    /**
+     * @brief Load a level straight away, skipping the splash screen
+     * @param levelNumber Level to start (1-5); score and totals are reset
+     */
+    void startLevel(int levelNumber);
+    
+    /**
+     * @brief Copy the whole simulation state into a snapshot, reusing its buffer
+     *
+     * Updating a game restored from the snapshot with the same input gives
+     * exactly the same ticks as updating this one would have.
+     * @param snapshot Snapshot to overwrite
+     */
+    void saveSnapshot(GameSnapshot& snapshot) const;
+    
+    /**
+     * @brief Put the game back into a saved state
+     *
+     * Caches (flow field, terrain texture) are rebuilt on the next update and
+     * draw; animations already playing are left alone.
+     * @param snapshot Snapshot written by saveSnapshot, in this or another Game
+     * @return False if the snapshot is empty, from another version or
+     *         corrupt; the game is left unchanged then
+     */
+    bool restoreSnapshot(const GameSnapshot& snapshot);
+
 private:
     void setupLevel();
+    void fireHarpoon();
     
     void drawSplashScreen() const;
-    void drawGameplay() const;
+    void drawGameplay(float interpolation) const;
+    void drawInterpolated(const GameThing& thing, float interpolation) const;
+    void drawInterpolatedMonster(int index, float interpolation) const;
+    void storePreviousPositions();
     void drawGameOver() const;
     void drawPauseScreen() const;
     void drawHUD() const;
+    void drawProfiler() const;
     void drawExplosions() const;
     
     void updateMonsters(float deltaTime);
@@ -86,6 +187,9 @@ private:
     void checkProjectileCollisions();
     void checkPowerUpCollisions();
     void checkFallingRockCollisions();
+    void rebuildMonsterIndex();
+    int findMonsterAt(const Position& pos) const;
+    void removeMonster(int index);
     void checkForTriggeredRockFalls();
     void checkForCascadingRockFalls();
     void checkForRockFalls(); // Legacy method (now unused)
@@ -0,0 +1,69 @@
+#include "GameSnapshot.h"
+#include "Logger.h"
+#include <fstream>
+
+static bool isValidHeader(const std::vector<uint8_t>& bytes) {
+    if (bytes.size() < sizeof(GameSnapshot::Header)) {
+        return false;
+    }
+    GameSnapshot::Header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    return std::memcmp(header.magic, GameSnapshot::MAGIC, 4) == 0 &&
+           header.version == GameSnapshot::VERSION &&
+           header.payloadSize == bytes.size() - sizeof(header);
+}
+
+GameSnapshot::Reader::Reader(const GameSnapshot& snapshot)
+    : bytes(snapshot.bytes), offset(sizeof(Header)), failed(!isValidHeader(snapshot.bytes)) {
+    if (failed) {
+        offset = bytes.size();
+    }
+}
+
+GameSnapshot::GameSnapshot() {
+}
+
+void GameSnapshot::beginWrite() {
+    bytes.clear();
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    write(header);
+}
+
+void GameSnapshot::endWrite() {
+    uint64_t payloadSize = bytes.size() - sizeof(Header);
+    std::memcpy(bytes.data() + offsetof(Header, payloadSize), &payloadSize, sizeof(payloadSize));
+}
+
+bool GameSnapshot::save(const std::string& filename) const {
+    if (!isValidHeader(bytes)) {
+        GAME_LOG_WARNING("Not writing empty snapshot to %s", filename.c_str());
+        return false;
+    }
+    
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        GAME_LOG_WARNING("Could not create snapshot file: %s", filename.c_str());
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    return (bool)file;
+}
+
+bool GameSnapshot::load(const std::string& filename) {
+    bytes.clear();
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        GAME_LOG_WARNING("Could not open snapshot file: %s", filename.c_str());
+        return false;
+    }
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    
+    if (!isValidHeader(bytes)) {
+        GAME_LOG_WARNING("%s is not a snapshot from this version", filename.c_str());
+        bytes.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,205 @@
+#ifndef GAMESNAPSHOT_H
+#define GAMESNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief The whole simulation state of a Game, as plain data in one reusable buffer
+ *
+ * Layout (native byte order, for this build only):
+ *   Header
+ *   records  written by Game::saveSnapshot and the saveState of each subsystem:
+ *            fixed-size plain structs, and arrays as a u32 count followed by
+ *            the elements
+ *
+ * Only trivially copyable values go in, so saving is a run of memcpys and
+ * nothing in the buffer points anywhere: objects that refer to each other
+ * do so by index (a harpoon names its owner by its slot in the projectile
+ * pool's owner table, for example). Saving again into the same snapshot
+ * reuses its buffer, so a ring of snapshots stops allocating once each has
+ * held a full state. That is what rollback scrubbing, bot look-ahead and
+ * crash captures need.
+ *
+ * Caches that are derived from the state (flow field, terrain texture,
+ * render interpolation) and presentation-only effects are not stored;
+ * restoring rebuilds or drops them.
+ */
+class GameSnapshot {
+public:
+    static const uint16_t VERSION = 1;
+    static constexpr char MAGIC[4] = {'D', 'D', 'S', 'N'};
+    
+    struct Header {
+        char magic[4];
+        uint16_t version;
+        uint16_t reserved;
+        uint64_t payloadSize;  // bytes after the header
+    };
+    
+    /**
+     * @brief Read cursor over a snapshot; every read is bounds checked
+     */
+    class Reader {
+    private:
+        const std::vector<uint8_t>& bytes;
+        size_t offset;
+        bool failed;
+    
+    public:
+        /**
+         * @brief Check the header and position the cursor on the first record
+         * @param snapshot Snapshot to read
+         */
+        explicit Reader(const GameSnapshot& snapshot);
+        
+        /**
+         * @brief False if the header was bad or any read ran past the end
+         */
+        bool isValid() const { return !failed; }
+        
+        /**
+         * @brief True once every record has been read and nothing went wrong
+         */
+        bool isFinished() const { return !failed && offset == bytes.size(); }
+        
+        template <typename T>
+        bool read(T& value) {
+            return readArray(&value, 1);
+        }
+        
+        template <typename T>
+        bool readArray(T* values, size_t count) {
+            static_assert(std::is_trivially_copyable<T>::value, "snapshots only hold plain data");
+            if (failed || count > (bytes.size() - offset) / sizeof(T)) {
+                failed = true;
+                return false;
+            }
+            if (count > 0) {
+                std::memcpy(values, bytes.data() + offset, count * sizeof(T));
+            }
+            offset += count * sizeof(T);
+            return true;
+        }
+        
+        /**
+         * @brief Read an array written by writeVector, replacing the vector's contents
+         */
+        template <typename T>
+        bool readVector(std::vector<T>& values) {
+            uint32_t count = 0;
+            if (!read(count) || count > (bytes.size() - offset) / sizeof(T)) {
+                failed = true;
+                return false;
+            }
+            values.resize(count);
+            return readArray(values.data(), count);
+        }
+        
+        /**
+         * @brief Read states written by writeStates, resizing the vector to match
+         */
+        template <typename Object>
+        bool readStates(std::vector<Object>& objects) {
+            using SavedState = typename Object::SavedState;
+            uint32_t count = 0;
+            if (!read(count) || count > (bytes.size() - offset) / sizeof(SavedState)) {
+                failed = true;
+                return false;
+            }
+            objects.resize(count);
+            for (Object& object : objects) {
+                SavedState saved;
+                read(saved);
+                // Enum fields come back as raw bytes, so check them where the state says how
+                if constexpr (requires { saved.isValid(); }) {
+                    if (!saved.isValid()) {
+                        failed = true;
+                        return false;
+                    }
+                }
+                object.setSavedState(saved);
+            }
+            return true;
+        }
+    };
+
+private:
+    std::vector<uint8_t> bytes;
+
+public:
+    GameSnapshot();
+    
+    /**
+     * @brief Grow the buffer up front, so the first save doesn't allocate either
+     * @param byteCount Bytes to reserve
+     */
+    void reserve(size_t byteCount) { bytes.reserve(byteCount); }
+    
+    /**
+     * @brief Drop the current contents and write a fresh header; keeps the buffer
+     */
+    void beginWrite();
+    
+    /**
+     * @brief Record the payload size in the header once every record is written
+     */
+    void endWrite();
+    
+    template <typename T>
+    void write(const T& value) {
+        writeArray(&value, 1);
+    }
+    
+    template <typename T>
+    void writeArray(const T* values, size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshots only hold plain data");
+        const uint8_t* first = reinterpret_cast<const uint8_t*>(values);
+        bytes.insert(bytes.end(), first, first + count * sizeof(T));
+    }
+    
+    /**
+     * @brief Write a u32 element count followed by the elements
+     */
+    template <typename T>
+    void writeVector(const std::vector<T>& values) {
+        write((uint32_t)values.size());
+        writeArray(values.data(), values.size());
+    }
+    
+    /**
+     * @brief Write a u32 count followed by each object's getSavedState()
+     */
+    template <typename Object>
+    void writeStates(const std::vector<Object>& objects) {
+        write((uint32_t)objects.size());
+        for (const Object& object : objects) {
+            write(object.getSavedState());
+        }
+    }
+    
+    bool isEmpty() const { return bytes.empty(); }
+    size_t size() const { return bytes.size(); }
+    size_t capacity() const { return bytes.capacity(); }
+    
+    /**
+     * @brief Write the snapshot to a file, e.g. to capture the state of a crash
+     * @param filename File to create
+     * @return False if the snapshot is empty or the file could not be written
+     */
+    bool save(const std::string& filename) const;
+    
+    /**
+     * @brief Read a snapshot file written by save() from the same build
+     * @param filename File to read
+     * @return False if the file is missing, truncated or from another version;
+     *         the snapshot is left empty then
+     */
+    bool load(const std::string& filename);
+};
+
+#endif // GAMESNAPSHOT_H
@@ -1,7 +1,7 @@
 #include "GameThing.h"
 
 GameThing::GameThing(const Position& startPos) 
-    : location(startPos), isActive(true) {
+    : location(startPos), previousLocation(startPos), isActive(true) {
 }
 
 Position GameThing::getPosition() const {
@@ -21,3 +21,24 @@ void GameThing::setPosition(const Position& newPos) {
         location = newPos;
     }
 }
+
+void GameThing::storePreviousPosition() {
+    previousLocation = location;
+}
+
+Vector2 GameThing::getRenderOffset(float alpha) const {
+    return renderOffset(previousLocation, location, alpha);
+}
+
+Vector2 GameThing::renderOffset(const Position& previous, const Position& current, float alpha) {
+    Position delta = previous - current;
+    
+    // Only blend single-tile steps; anything bigger is a teleport or respawn
+    if (delta.x < -1 || delta.x > 1 || delta.y < -1 || delta.y > 1) {
+        return Vector2{0.0f, 0.0f};
+    }
+    
+    float remaining = 1.0f - alpha;
+    return Vector2{delta.x * remaining * Position::BLOCK_SIZE,
+                   delta.y * remaining * Position::BLOCK_SIZE};
+}
\ No newline at end of file
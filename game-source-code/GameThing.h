@@ -13,6 +13,7 @@
 class GameThing : public CanUpdate, public CanDraw {
 protected:
     Position location;
+    Position previousLocation;
     bool isActive;
     
 public:
@@ -51,6 +52,27 @@ public:
      */
     void setPosition(const Position& newPos);
     
+    /**
+     * @brief Remember where this object is before the next simulation tick
+     */
+    void storePreviousPosition();
+    
+    /**
+     * @brief Pixel offset from the current position to the interpolated draw position
+     * @param alpha How far between the previous and current tick to draw (0-1)
+     * @return Offset in pixels to apply when drawing
+     */
+    Vector2 getRenderOffset(float alpha) const;
+    
+    /**
+     * @brief Render offset for an object that moved from previous to current
+     * @param previous Position before the last tick
+     * @param current Position now
+     * @param alpha How far between the previous and current tick to draw (0-1)
+     * @return Offset in pixels to apply when drawing
+     */
+    static Vector2 renderOffset(const Position& previous, const Position& current, float alpha);
+    
     // Pure virtual functions that subclasses must implement
     void update(float deltaTime) override = 0;
     void draw() const override = 0;
@@ -0,0 +1,83 @@
+#include "InputProvider.h"
+#include <raylib-cpp.hpp>
+#include <cstdlib>
+
+namespace {
+    struct KeyBinding {
+        InputState::Action action;
+        int key;
+    };
+    
+    const KeyBinding keyBindings[] = {
+        { InputState::MOVE_UP, KEY_UP },
+        { InputState::MOVE_DOWN, KEY_DOWN },
+        { InputState::MOVE_LEFT, KEY_LEFT },
+        { InputState::MOVE_RIGHT, KEY_RIGHT },
+        { InputState::FIRE, KEY_SPACE },
+        { InputState::CONFIRM, KEY_ENTER },
+        { InputState::PAUSE, KEY_P },
+        { InputState::TOGGLE_SOUND, KEY_M },
+        { InputState::RESTART, KEY_R },
+        { InputState::NEXT_LEVEL, KEY_N },
+        { InputState::TOGGLE_PROFILER, KEY_F3 }
+    };
+}
+
+void KeyboardInput::beginFrame() {
+    for (const auto& binding : keyBindings) {
+        if (IsKeyPressed(binding.key)) {
+            pendingPresses |= InputState::bit(binding.action);
+        }
+    }
+}
+
+InputState KeyboardInput::poll() {
+    InputState state;
+    for (const auto& binding : keyBindings) {
+        if (IsKeyDown(binding.key)) {
+            state.hold(binding.action);
+        }
+    }
+    
+    // Presses are latched per frame and handed to the first update only
+    state.pressed = pendingPresses;
+    pendingPresses = 0;
+    return state;
+}
+
+InputState ScriptedInput::poll() {
+    InputState current = state;
+    state.pressed = 0; // presses are delivered exactly once
+    return current;
+}
+
+RandomBotInput::RandomBotInput(uint64_t seed)
+    : currentMove(InputState::MOVE_DOWN), ticksUntilTurn(0), tickCount(0),
+      random(seed, Random::BOT_STREAM) {
+}
+
+InputState RandomBotInput::poll() {
+    InputState state;
+    tickCount++;
+    
+    if (ticksUntilTurn <= 0) {
+        currentMove = static_cast<InputState::Action>(InputState::MOVE_UP + random.nextInt(4));
+        ticksUntilTurn = 10 + random.nextInt(50);
+    }
+    ticksUntilTurn--;
+    state.hold(currentMove);
+    
+    if (tickCount % 20 == 0) {
+        state.press(InputState::FIRE);
+    }
+    
+    // Get past the splash and level complete screens, restart less often
+    if (tickCount % 120 == 0) {
+        state.press(InputState::CONFIRM);
+        state.press(InputState::NEXT_LEVEL);
+    } else if (tickCount % 600 == 300) {
+        state.press(InputState::RESTART);
+    }
+    
+    return state;
+}
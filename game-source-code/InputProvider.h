@@ -0,0 +1,127 @@
+#ifndef INPUTPROVIDER_H
+#define INPUTPROVIDER_H
+
+#include "Random.h"
+#include <cstdint>
+
+/**
+ * @brief Snapshot of the player's controls for a single game update
+ *
+ * Stores held and newly pressed actions as bitmasks so the game logic
+ * never has to poll the keyboard directly.
+ */
+struct InputState {
+    enum Action {
+        MOVE_UP,
+        MOVE_DOWN,
+        MOVE_LEFT,
+        MOVE_RIGHT,
+        FIRE,
+        CONFIRM,
+        PAUSE,
+        TOGGLE_SOUND,
+        RESTART,
+        NEXT_LEVEL,
+        TOGGLE_PROFILER,
+        ACTION_COUNT
+    };
+    
+    uint16_t held = 0;     // actions held down during this update
+    uint16_t pressed = 0;  // actions that went down during this update
+    
+    bool isDown(Action action) const { return (held & bit(action)) != 0; }
+    bool isPressed(Action action) const { return (pressed & bit(action)) != 0; }
+    
+    void hold(Action action) { held |= bit(action); }
+    void release(Action action) { held &= ~bit(action); }
+    void press(Action action) { pressed |= bit(action); }
+    void clear() { held = 0; pressed = 0; }
+    
+    // Both masks in one word (held in the low half), as stored in replays
+    uint32_t toMask() const { return held | ((uint32_t)pressed << 16); }
+    static InputState fromMask(uint32_t mask) {
+        InputState state;
+        state.held = (uint16_t)(mask & 0xFFFFu);
+        state.pressed = (uint16_t)(mask >> 16);
+        return state;
+    }
+    
+    static uint16_t bit(Action action) { return (uint16_t)(1u << action); }
+};
+
+/**
+ * @brief Source of player input consumed by Game once per update
+ */
+class InputProvider {
+public:
+    virtual ~InputProvider() = default;
+    
+    /**
+     * @brief Called once per rendered frame, before any updates for that frame
+     *
+     * A frame can run zero or several fixed updates, so sources that see
+     * per-frame events (key presses) collect them here until the next poll.
+     */
+    virtual void beginFrame() {}
+    
+    /**
+     * @brief Capture the input for the next game update
+     * @return Held and pressed actions for this update
+     */
+    virtual InputState poll() = 0;
+};
+
+/**
+ * @brief Reads the controls from the raylib keyboard state
+ */
+class KeyboardInput : public InputProvider {
+private:
+    uint16_t pendingPresses = 0;
+    
+public:
+    void beginFrame() override;
+    InputState poll() override;
+};
+
+/**
+ * @brief Input driven by code instead of a keyboard (tests, bots, headless runs)
+ *
+ * Held actions persist between polls; pressed actions are delivered once.
+ */
+class ScriptedInput : public InputProvider {
+private:
+    InputState state;
+
+public:
+    InputState poll() override;
+    
+    void setState(const InputState& newState) { state = newState; }
+    void hold(InputState::Action action) { state.hold(action); }
+    void release(InputState::Action action) { state.release(action); }
+    void press(InputState::Action action) { state.press(action); }
+    void releaseAll() { state.clear(); }
+};
+
+/**
+ * @brief Simple random bot used to keep headless soak runs busy
+ *
+ * Wanders in random directions, fires when it can and presses through the
+ * splash, level complete and game over screens.
+ */
+class RandomBotInput : public InputProvider {
+private:
+    InputState::Action currentMove;
+    int ticksUntilTurn;
+    int tickCount;
+    Random random;
+
+public:
+    /**
+     * @brief Create a bot whose moves are reproducible from a seed
+     * @param seed Run seed (same seed, same moves)
+     */
+    RandomBotInput(uint64_t seed = Random::DEFAULT_SEED);
+    InputState poll() override;
+};
+
+#endif // INPUTPROVIDER_H
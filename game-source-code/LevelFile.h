@@ -0,0 +1,76 @@
+#ifndef LEVELFILE_H
+#define LEVELFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Binary level format: the terrain's own chunk bitplanes plus spawn tables
+ *
+ * Layout (little endian):
+ *   Header
+ *   u32      chunk table, one entry per chunk in row-major order:
+ *            0 = solid earth (not stored), n = n-th stored chunk
+ *   SpawnPoint[rockCount]     initial rocks
+ *   SpawnPoint[monsterCount]  monster spawns
+ *   padding  to an 8-byte boundary
+ *   Chunk[storedChunkCount]   rock and empty bitplanes, exactly as TerrainGrid keeps them
+ *
+ * A cell is solid earth unless its rock or empty bit is set, so a level only
+ * stores the chunks that contain tunnels or rocks, and loading a chunk is one
+ * copy with no per-cell work. Write one with game --convert-level IN.txt OUT.lvl;
+ * TerrainGrid::loadBinary checks everything before it touches the grid.
+ */
+class LevelFile {
+public:
+    static const uint16_t VERSION = 1;
+    static const int CHUNK_SIZE = 64;  // must match TerrainGrid::CHUNK_SIZE
+    static const int MAX_SIDE = 1 << 16;  // cells per side; keeps every size computation in range
+    static constexpr char MAGIC[4] = {'D', 'D', 'L', 'V'};
+    
+    struct Header {
+        char magic[4];
+        uint16_t version;
+        uint16_t reserved;
+        int32_t width;
+        int32_t height;
+        int32_t playerX;
+        int32_t playerY;
+        uint32_t rockCount;
+        uint32_t monsterCount;
+        uint32_t storedChunkCount;
+        uint32_t reserved2;
+    };
+    
+    struct SpawnPoint {
+        int32_t x;
+        int32_t y;
+    };
+    
+    struct Chunk {
+        uint64_t rockBits[CHUNK_SIZE];   // bit n of word r = column n, row r of the chunk
+        uint64_t emptyBits[CHUNK_SIZE];
+    };
+    
+    static size_t chunkCount(const Header& header) {
+        size_t wide = ((size_t)header.width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        size_t high = ((size_t)header.height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        return wide * high;
+    }
+    
+    static size_t spawnOffset(const Header& header) {
+        return sizeof(Header) + chunkCount(header) * sizeof(uint32_t);
+    }
+    
+    static size_t chunkOffset(const Header& header) {
+        size_t spawnEnd = spawnOffset(header) +
+                          ((size_t)header.rockCount + header.monsterCount) * sizeof(SpawnPoint);
+        return (spawnEnd + 7) / 8 * 8;
+    }
+    
+    static size_t fileSize(const Header& header) {
+        return chunkOffset(header) + (size_t)header.storedChunkCount * sizeof(Chunk);
+    }
+};
+
+#endif // LEVELFILE_H
@@ -0,0 +1,52 @@
+#include "LevelLoader.h"
+#include "Logger.h"
+
+LevelLoader::LevelLoader() : pendingLevel(0), ready(false) {
+}
+
+LevelLoader::~LevelLoader() {
+    discard();
+}
+
+void LevelLoader::preload(int levelNumber) {
+    if (levelNumber == pendingLevel) {
+        return;
+    }
+    discard();
+    
+    pendingLevel = levelNumber;
+    GAME_LOG_INFO("Preloading level %d in the background", levelNumber);
+    worker = std::thread([this, levelNumber]() {
+        result = std::make_unique<TerrainGrid>(levelNumber);
+        ready.store(true, std::memory_order_release);
+    });
+}
+
+bool LevelLoader::isReady(int levelNumber) const {
+    return levelNumber == pendingLevel && ready.load(std::memory_order_acquire);
+}
+
+std::unique_ptr<TerrainGrid> LevelLoader::take(int levelNumber) {
+    if (levelNumber != pendingLevel) {
+        discard();
+        return nullptr;
+    }
+    
+    if (!ready.load(std::memory_order_acquire)) {
+        GAME_LOG_DEBUG("Level %d still loading, waiting for it", levelNumber);
+    }
+    worker.join();
+    std::unique_ptr<TerrainGrid> loaded = std::move(result);
+    pendingLevel = 0;
+    ready.store(false, std::memory_order_relaxed);
+    return loaded;
+}
+
+void LevelLoader::discard() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+    result.reset();
+    pendingLevel = 0;
+    ready.store(false, std::memory_order_relaxed);
+}
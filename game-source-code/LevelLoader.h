@@ -0,0 +1,62 @@
+#ifndef LEVELLOADER_H
+#define LEVELLOADER_H
+
+#include "TerrainGrid.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/**
+ * @brief Loads a level on a worker thread while the game shows a between-levels screen
+ *
+ * The worker only builds a TerrainGrid, which touches nothing shared except
+ * the resource pack (read only once open) and the logger (thread safe). The
+ * game picks the finished grid up with take() on its own thread, so the
+ * level it plays is never visible half loaded.
+ */
+class LevelLoader {
+private:
+    std::thread worker;
+    int pendingLevel;                    // level requested last, 0 = none
+    std::unique_ptr<TerrainGrid> result; // written by the worker, read after join
+    std::atomic<bool> ready;
+
+public:
+    LevelLoader();
+    ~LevelLoader();
+    
+    LevelLoader(const LevelLoader&) = delete;
+    LevelLoader& operator=(const LevelLoader&) = delete;
+    
+    /**
+     * @brief Start loading a level in the background
+     *
+     * Does nothing if that level is already loading or loaded. A different
+     * level still in flight is waited for and thrown away first.
+     * @param levelNumber Level to load
+     */
+    void preload(int levelNumber);
+    
+    /**
+     * @brief Check whether a preloaded level is ready to take without waiting
+     * @param levelNumber Level asked for
+     */
+    bool isReady(int levelNumber) const;
+    
+    /**
+     * @brief Hand over a preloaded level
+     *
+     * Waits for the worker if the level is still loading. Any other
+     * preloaded level is discarded.
+     * @param levelNumber Level wanted
+     * @return The loaded grid, or nullptr if that level was not preloaded
+     */
+    std::unique_ptr<TerrainGrid> take(int levelNumber);
+    
+    int getPendingLevel() const { return pendingLevel; }
+
+private:
+    void discard();
+};
+
+#endif // LEVELLOADER_H
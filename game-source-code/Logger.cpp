@@ -0,0 +1,146 @@
+#include "Logger.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+Logger::Logger()
+    : ring(CAPACITY), head(0), count(0), submitted(0), written(0), dropped(0),
+      droppedReported(0), flushWaiters(0), stopping(false), minimumLevel(LEVEL_DEBUG),
+      sink(&std::cout) {
+    writer = std::thread(&Logger::writerLoop, this);
+}
+
+Logger* Logger::getInstance() {
+    // Function-local so the writer thread is joined and drained at exit
+    static Logger instance;
+    return &instance;
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    wakeWriter.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+void Logger::log(Level level, const char* format, ...) {
+    if (!isEnabled(level)) {
+        return;
+    }
+    
+    // Format outside the lock so producers only contend for the copy
+    char text[MESSAGE_SIZE];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    
+    bool wakeNow = false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (count == (size_t)CAPACITY) {
+            dropped++;
+            return;
+        }
+        
+        Entry& entry = ring[(head + count) % CAPACITY];
+        entry.level = level;
+        std::memcpy(entry.text, text, sizeof(text));
+        count++;
+        submitted++;
+        
+        // Normally the writer wakes on a timer; only hurry it when filling up
+        wakeNow = (count == (size_t)CAPACITY / 2) || level >= LEVEL_ERROR;
+    }
+    
+    if (wakeNow) {
+        wakeWriter.notify_one();
+    }
+}
+
+void Logger::flush() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    uint64_t target = submitted;
+    flushWaiters++;
+    wakeWriter.notify_one();
+    drained.wait(lock, [&] { return written >= target; });
+    flushWaiters--;
+}
+
+void Logger::setSink(std::ostream* output) {
+    flush();
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    sink = output ? output : &std::cout;
+}
+
+uint64_t Logger::getDroppedCount() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return dropped;
+}
+
+void Logger::writerLoop() {
+    std::vector<Entry> batch;
+    batch.reserve(CAPACITY);
+    std::string output;
+    
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        wakeWriter.wait_for(lock, std::chrono::milliseconds(50),
+            [&] { return stopping || flushWaiters > 0 || count >= (size_t)CAPACITY / 2; });
+        
+        batch.clear();
+        while (count > 0) {
+            batch.push_back(ring[head]);
+            head = (head + 1) % CAPACITY;
+            count--;
+        }
+        uint64_t newlyDropped = dropped - droppedReported;
+        droppedReported = dropped;
+        bool finished = stopping;
+        lock.unlock();
+        
+        if (!batch.empty() || newlyDropped > 0) {
+            output.clear();
+            if (newlyDropped > 0) {
+                output += "[WARNING] ";
+                output += std::to_string(newlyDropped);
+                output += " log messages dropped\n";
+            }
+            for (const auto& entry : batch) {
+                output += levelName(entry.level);
+                output += entry.text;
+                output += '\n';
+            }
+            
+            // One write and one flush per batch instead of one per message
+            std::lock_guard<std::mutex> sinkLock(sinkMutex);
+            sink->write(output.data(), (std::streamsize)output.size());
+            sink->flush();
+        }
+        
+        lock.lock();
+        written += batch.size();
+        drained.notify_all();
+        
+        if (finished && count == 0) {
+            break;
+        }
+    }
+}
+
+const char* Logger::levelName(Level level) {
+    switch (level) {
+        case LEVEL_DEBUG: return "[DEBUG] ";
+        case LEVEL_INFO: return "[INFO] ";
+        case LEVEL_WARNING: return "[WARNING] ";
+        case LEVEL_ERROR: return "[ERROR] ";
+        default: return "";
+    }
+}
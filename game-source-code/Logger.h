@@ -0,0 +1,123 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Leveled logger that writes on a background thread
+ *
+ * Messages are formatted into a fixed-size ring buffer and a writer thread
+ * drains them in batches, so the game loop never waits on console output.
+ * When the ring is full new messages are dropped and counted instead of
+ * blocking the caller.
+ *
+ * Use the GAME_LOG_* macros rather than calling log() directly: levels below
+ * GAME_LOG_MIN_LEVEL are removed at compile time, arguments included.
+ */
+class Logger {
+public:
+    enum Level {
+        LEVEL_DEBUG,
+        LEVEL_INFO,
+        LEVEL_WARNING,
+        LEVEL_ERROR,
+        LEVEL_NONE
+    };
+    
+    static const int CAPACITY = 1024;     // messages held before dropping
+    static const int MESSAGE_SIZE = 160;  // longer messages are truncated
+
+private:
+    struct Entry {
+        Level level;
+        char text[MESSAGE_SIZE];
+    };
+    
+    std::vector<Entry> ring;
+    size_t head;
+    size_t count;
+    uint64_t submitted;
+    uint64_t written;
+    uint64_t dropped;
+    uint64_t droppedReported;
+    int flushWaiters;
+    bool stopping;
+    std::atomic<int> minimumLevel;
+    
+    std::ostream* sink;
+    std::mutex queueMutex;
+    std::mutex sinkMutex;
+    std::condition_variable wakeWriter;
+    std::condition_variable drained;
+    std::thread writer;
+    
+    Logger();
+
+public:
+    static Logger* getInstance();
+    ~Logger();
+    
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    
+    /**
+     * @brief Queue a printf-style message
+     * @param level Severity of the message
+     * @param format printf format string
+     */
+#if defined(__GNUC__)
+    void log(Level level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+#else
+    void log(Level level, const char* format, ...);
+#endif
+    
+    /**
+     * @brief Block until every queued message has been written
+     */
+    void flush();
+    
+    /**
+     * @brief Set the runtime level filter (on top of the compile-time one)
+     * @param level Messages below this level are ignored
+     */
+    void setLevel(Level level) { minimumLevel.store(level, std::memory_order_relaxed); }
+    Level getLevel() const { return (Level)minimumLevel.load(std::memory_order_relaxed); }
+    bool isEnabled(Level level) const { return level >= minimumLevel.load(std::memory_order_relaxed); }
+    
+    /**
+     * @brief Redirect output (default std::cout); queued messages are flushed first
+     * @param output Stream to write to
+     */
+    void setSink(std::ostream* output);
+    
+    uint64_t getDroppedCount();
+
+private:
+    void writerLoop();
+    static const char* levelName(Level level);
+};
+
+// Compile-time filter: 0 = debug, 1 = info, 2 = warning, 3 = error, 4 = none
+#ifndef GAME_LOG_MIN_LEVEL
+#define GAME_LOG_MIN_LEVEL 1
+#endif
+
+#define GAME_LOG(level, ...) \
+    do { \
+        if constexpr ((int)(level) >= GAME_LOG_MIN_LEVEL) { \
+            Logger::getInstance()->log(level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define GAME_LOG_DEBUG(...) GAME_LOG(Logger::LEVEL_DEBUG, __VA_ARGS__)
+#define GAME_LOG_INFO(...) GAME_LOG(Logger::LEVEL_INFO, __VA_ARGS__)
+#define GAME_LOG_WARNING(...) GAME_LOG(Logger::LEVEL_WARNING, __VA_ARGS__)
+#define GAME_LOG_ERROR(...) GAME_LOG(Logger::LEVEL_ERROR, __VA_ARGS__)
+
+#endif // LOGGER_H
@@ -0,0 +1,45 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * The contents are paged in by the OS on first touch and stay valid until the
+ * mapping is closed, so callers can point straight into them instead of
+ * reading into their own buffers.
+ */
+class MappedFile {
+private:
+    const uint8_t* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    /**
+     * @brief Map a file, closing any file mapped before
+     * @param filename File to map
+     * @return False if the file is missing, empty or cannot be mapped
+     */
+    bool open(const std::string& filename);
+    
+    void close();
+    
+    bool isOpen() const { return data != nullptr; }
+    const uint8_t* getData() const { return data; }
+    size_t getSize() const { return size; }
+};
+
+#endif // MAPPEDFILE_H
@@ -1,12 +1,16 @@
 #include "Monster.h"
 #include "SpriteManager.h"
+#include "TerrainGrid.h"
+#include "FlowField.h"
+#include <algorithm>
 #include <cmath>
 
-Monster::Monster(const Position& startPos, MonsterType monsterType) 
+Monster::Monster(const Position& startPos, MonsterType monsterType, TerrainGrid* terrainRef) 
     : GameThing(startPos), type(monsterType), currentState(PATROLLING),
       baseSpeed(0.30f), moveSpeed(baseSpeed), targetPosition(startPos), 
       decisionTimer(0.0f), decisionInterval(0.30f), aggressionTimer(0.0f),
-      detectionRange(10.0f), fireBreathCooldown(0.0f), canBreatheFire(false) {
+      detectionRange(10.0f), fireBreathCooldown(0.0f), canBreatheFire(false),
+      terrain(terrainRef), flowField(nullptr), random(Random::DEFAULT_SEED, Random::MONSTER_STREAM_BASE) {
     
     // Set type-specific properties but keep same base speed as player
     switch (type) {
@@ -47,7 +51,7 @@ void Monster::fireBreath() {
 void Monster::moveUp() {
     Position newPos = location;
     newPos.y--;
-    if (newPos.isValid()) {
+    if (TerrainGrid::isInside(terrain, newPos)) {
         location = newPos;
     }
 }
@@ -55,7 +59,7 @@ void Monster::moveUp() {
 void Monster::moveDown() {
     Position newPos = location;
     newPos.y++;
-    if (newPos.isValid()) {
+    if (TerrainGrid::isInside(terrain, newPos)) {
         location = newPos;
     }
 }
@@ -63,7 +67,7 @@ void Monster::moveDown() {
 void Monster::moveLeft() {
     Position newPos = location;
     newPos.x--;
-    if (newPos.isValid()) {
+    if (TerrainGrid::isInside(terrain, newPos)) {
         location = newPos;
     }
 }
@@ -71,7 +75,7 @@ void Monster::moveLeft() {
 void Monster::moveRight() {
     Position newPos = location;
     newPos.x++;
-    if (newPos.isValid()) {
+    if (TerrainGrid::isInside(terrain, newPos)) {
         location = newPos;
     }
 }
@@ -99,7 +103,10 @@ void Monster::updateAI(float deltaTime) {
     decisionTimer += deltaTime;
     
     if (decisionTimer >= decisionInterval) {
-        decisionTimer = 0.0f;
+        // Keep the overshoot, so decisions come every decisionInterval seconds
+        // on average whatever the tick length. Cap it at one interval: after a
+        // long stall the monster makes one catch-up decision, not a burst
+        decisionTimer = std::min(decisionTimer - decisionInterval, decisionInterval);
         
         switch (currentState) {
             case PATROLLING:
@@ -136,7 +143,7 @@ void Monster::updateBehaviorState(const Position& playerPos) {
             break;
             
         case AGGRESSIVE:
-            aggressionTimer -= 0.1f;
+            // aggressionTimer counts down in update(), in simulated seconds
             if (aggressionTimer <= 0.0f && distanceToPlayer > 8.0f) {
                 currentState = CHASING;
             }
@@ -147,6 +154,16 @@ void Monster::updateBehaviorState(const Position& playerPos) {
 void Monster::moveTowardsTarget() {
     int deltaX = targetPosition.x - location.x;
     int deltaY = targetPosition.y - location.y;
+    bool wander = (currentState == PATROLLING) && random.oneIn(4);
+    
+    // Follow the shared flow field through the tunnels when the player can be
+    // reached that way; otherwise fall back to heading straight for the target,
+    // the only move that goes through earth
+    Position next;
+    if (!wander && flowField && flowField->getNextStep(location, next)) {
+        location = next;
+        return;
+    }
     
     // Enhanced movement logic based on behavior state
     if (currentState == AGGRESSIVE && type == RED_MONSTER) {
@@ -160,15 +177,9 @@ void Monster::moveTowardsTarget() {
         }
     } else {
         // Normal movement with some randomness for patrolling
-        if (currentState == PATROLLING && (rand() % 4 == 0)) {
+        if (wander) {
             // 25% chance of random movement when patrolling
-            int randomDir = rand() % 4;
-            switch (randomDir) {
-                case 0: moveUp(); break;
-                case 1: moveDown(); break;
-                case 2: moveLeft(); break;
-                case 3: moveRight(); break;
-            }
+            wanderStep();
         } else {
             // Standard movement towards target
             if (abs(deltaX) > abs(deltaY)) {
@@ -182,6 +193,20 @@ void Monster::moveTowardsTarget() {
     }
 }
 
+void Monster::wanderStep() {
+    // A random step along the tunnels; into earth it is no step at all
+    Position next = location;
+    switch (random.nextInt(4)) {
+        case 0: next.y--; break;
+        case 1: next.y++; break;
+        case 2: next.x--; break;
+        case 3: next.x++; break;
+    }
+    if (TerrainGrid::isOpen(terrain, next)) {
+        location = next;
+    }
+}
+
 void Monster::patrolBehavior() {
     // Patrol with occasional random movement
     moveTowardsTarget();
@@ -208,9 +233,16 @@ void Monster::updateSpecialAbilities(float deltaTime) {
             fireBreathCooldown = 0.0f;
         }
     }
+    
+    if (aggressionTimer > 0.0f) {
+        aggressionTimer -= deltaTime;
+        if (aggressionTimer < 0.0f) {
+            aggressionTimer = 0.0f;
+        }
+    }
 }
 
-raylib::Color Monster::getMonsterColor() const {
+raylib::Color Monster::getMonsterColor(MonsterType type, BehaviorState currentState) {
     raylib::Color baseColor;
     
     switch (type) {
@@ -242,6 +274,11 @@ float Monster::getDistanceToPlayer(const Position& playerPos) const {
     return location.distanceTo(playerPos);
 }
 void Monster::draw() const {
+    drawAt(location, type, currentState, canFireBreath(), targetPosition.x < location.x);
+}
+
+void Monster::drawAt(const Position& location, MonsterType type, BehaviorState currentState,
+                     bool breathReady, bool facingLeft) {
     Position pixelPos = location.toPixels();
     
     // Try to use sprites first
@@ -256,7 +293,7 @@ void Monster::draw() const {
             default: spriteType = SpriteManager::RED_MONSTER_IDLE; break;
         }
     } else { // GREEN_DRAGON
-        if (canFireBreath()) {
+        if (breathReady) {
             spriteType = SpriteManager::GREEN_DRAGON_BREATHING;
         } else if (currentState == CHASING || currentState == AGGRESSIVE) {
             spriteType = SpriteManager::GREEN_DRAGON_WALKING;
@@ -266,16 +303,8 @@ void Monster::draw() const {
     }
     
     if (spriteManager->isSpriteLoaded(spriteType)) {
-        // Determine if monster should be flipped based on movement direction
-        bool shouldFlip = false;
-        
-        // Check if monster is moving toward target (left direction)
-        if (targetPosition.x < location.x) {
-            shouldFlip = true; // Monster is moving left, so flip the right-facing sprite
-        }
-        
-        // Draw sprite with or without flipping
-        if (shouldFlip) {
+        // Sprites face right; flip them when the monster heads left
+        if (facingLeft) {
             spriteManager->drawSpriteFlipped(spriteType, location);
         } else {
             spriteManager->drawSprite(spriteType, location);
@@ -292,14 +321,14 @@ void Monster::draw() const {
         }
         
         // Show fire breath indicator for green dragons
-        if (canFireBreath()) {
+        if (breathReady) {
             DrawRectangle(pixelPos.x + 2, pixelPos.y - 2, 6, 2, ORANGE);
         }
         return; // Sprite drawing complete
     }
     
     // Fallback to original rectangle drawing if sprites not available
-    raylib::Color color = getMonsterColor();
+    raylib::Color color = getMonsterColor(type, currentState);
     
     // Draw monster with behavior state indication
     DrawRectangle(pixelPos.x + 1, pixelPos.y + 1, 
@@ -317,7 +346,7 @@ void Monster::draw() const {
     }
     
     // Show fire breath indicator for green dragons
-    if (canFireBreath()) {
+    if (breathReady) {
         DrawRectangle(pixelPos.x + 2, pixelPos.y - 2, 6, 2, ORANGE);
     }
 }
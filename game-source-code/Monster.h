@@ -3,8 +3,12 @@
 
 #include "GameThing.h"
 #include "Interfaces.h"
+#include "Random.h"
 #include <raylib-cpp.hpp>
 
+class TerrainGrid; // Forward declaration
+class FlowField;
+
 class Monster : public GameThing, public CanMove, public CanCollide {
 public:
     enum MonsterType {
@@ -33,12 +37,32 @@ private:
     float fireBreathCooldown;
     bool canBreatheFire;
     
+    TerrainGrid* terrain;
+    const FlowField* flowField;
+    Random random;  // own stream, so monsters never share RNG state
+    
 public:
-    Monster(const Position& startPos, MonsterType monsterType);
+    Monster(const Position& startPos, MonsterType monsterType, TerrainGrid* terrainRef = nullptr);
     
     MonsterType getType() const { return type; }
     BehaviorState getBehaviorState() const { return currentState; }
+    float getDecisionTimer() const { return decisionTimer; }
+    float getDecisionInterval() const { return decisionInterval; }
+    float getAggressionTimer() const { return aggressionTimer; }
+    float getDetectionRange() const { return detectionRange; }
+    float getFireBreathCooldown() const { return fireBreathCooldown; }
+    bool hasFireBreath() const { return canBreatheFire; }
+    const Random& getRandom() const { return random; }
     void setTarget(const Position& target);
+    void setTerrain(TerrainGrid* terrainRef) { terrain = terrainRef; }
+    void setFlowField(const FlowField* field) { flowField = field; }
+    void seedRandom(uint64_t seed, uint64_t stream) { random.reseed(seed, stream); }
+    
+    /**
+     * @brief Start part way into the decision interval, so monsters don't all decide on the same tick
+     * @param fraction Fraction of the interval already elapsed, 0-1
+     */
+    void setDecisionPhase(float fraction) { decisionTimer = fraction * decisionInterval; }
     bool isInRange(const Position& position, float range) const;
     
     // Special abilities
@@ -60,15 +84,27 @@ public:
     void update(float deltaTime) override;
     void draw() const override;
     
+    /**
+     * @brief Draw a monster from its parts, for storage that keeps no Monster objects
+     * @param location Tile to draw at
+     * @param type Red monster or dragon
+     * @param currentState Behaviour state (picks the sprite and outline)
+     * @param breathReady True if the monster could breathe fire right now
+     * @param facingLeft Flip the sprite to face left
+     */
+    static void drawAt(const Position& location, MonsterType type, BehaviorState currentState,
+                       bool breathReady, bool facingLeft);
+    
 private:
     void updateAI(float deltaTime);
     void updateBehaviorState(const Position& playerPos);
     void moveTowardsTarget();
+    void wanderStep();
     void patrolBehavior();
     void chaseBehavior();
     void aggressiveBehavior();
     void updateSpecialAbilities(float deltaTime);
-    raylib::Color getMonsterColor() const;
+    static raylib::Color getMonsterColor(MonsterType type, BehaviorState currentState);
     float getDistanceToPlayer(const Position& playerPos) const;
 };
 
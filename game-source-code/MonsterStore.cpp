@@ -0,0 +1,432 @@
+#include "MonsterStore.h"
+#include "BehaviorKernel.h"
+#include "FlowField.h"
+#include "GameThing.h"
+#include "TerrainGrid.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    // Squared like the BehaviorKernel thresholds: exact for whole-tile distances
+    const float FIRE_BREATH_RANGE_SQ = 6.0f * 6.0f;
+    const float FIRE_BREATH_COOLDOWN = 3.0f;
+}
+
+MonsterStore::MonsterStore()
+    : target(0, 0), terrain(nullptr), flowField(nullptr), workerPool(nullptr),
+      lodDistanceSq(DEFAULT_LOD_DISTANCE * DEFAULT_LOD_DISTANCE), tickCount(0) {
+}
+
+int MonsterStore::add(const Monster& monster) {
+    Position pos = monster.getPosition();
+    float range = monster.getDetectionRange();
+    float loseRange = range * 1.5f;
+    
+    posX.push_back(pos.x);
+    posY.push_back(pos.y);
+    state.push_back(monster.getBehaviorState());
+    decisionTimer.push_back(monster.getDecisionTimer());
+    decisionInterval.push_back(monster.getDecisionInterval());
+    aggressionTimer.push_back(monster.getAggressionTimer());
+    fireBreathCooldown.push_back(monster.getFireBreathCooldown());
+    detectRangeSq.push_back(range * range);
+    loseRangeSq.push_back(loseRange * loseRange);
+    decisionDue.push_back(0);
+    nextX.push_back(pos.x);
+    nextY.push_back(pos.y);
+    levelOfDetail.push_back(LOD_FULL);
+    previousX.push_back(pos.x);
+    previousY.push_back(pos.y);
+    type.push_back(monster.getType());
+    canBreatheFire.push_back(monster.hasFireBreath() ? 1 : 0);
+    random.push_back(monster.getRandom());
+    return size() - 1;
+}
+
+void MonsterStore::remove(int index) {
+    int last = size() - 1;
+    if (index != last) {
+        posX[index] = posX[last];
+        posY[index] = posY[last];
+        state[index] = state[last];
+        decisionTimer[index] = decisionTimer[last];
+        decisionInterval[index] = decisionInterval[last];
+        aggressionTimer[index] = aggressionTimer[last];
+        fireBreathCooldown[index] = fireBreathCooldown[last];
+        detectRangeSq[index] = detectRangeSq[last];
+        loseRangeSq[index] = loseRangeSq[last];
+        levelOfDetail[index] = levelOfDetail[last];
+        previousX[index] = previousX[last];
+        previousY[index] = previousY[last];
+        type[index] = type[last];
+        canBreatheFire[index] = canBreatheFire[last];
+        random[index] = random[last];
+    }
+    
+    posX.pop_back();
+    posY.pop_back();
+    state.pop_back();
+    decisionTimer.pop_back();
+    decisionInterval.pop_back();
+    aggressionTimer.pop_back();
+    fireBreathCooldown.pop_back();
+    detectRangeSq.pop_back();
+    loseRangeSq.pop_back();
+    decisionDue.pop_back();
+    nextX.pop_back();
+    nextY.pop_back();
+    levelOfDetail.pop_back();
+    previousX.pop_back();
+    previousY.pop_back();
+    type.pop_back();
+    canBreatheFire.pop_back();
+    random.pop_back();
+}
+
+void MonsterStore::clear() {
+    posX.clear();
+    posY.clear();
+    state.clear();
+    decisionTimer.clear();
+    decisionInterval.clear();
+    aggressionTimer.clear();
+    fireBreathCooldown.clear();
+    detectRangeSq.clear();
+    loseRangeSq.clear();
+    decisionDue.clear();
+    nextX.clear();
+    nextY.clear();
+    levelOfDetail.clear();
+    previousX.clear();
+    previousY.clear();
+    type.clear();
+    canBreatheFire.clear();
+    random.clear();
+    scheduler.reset();
+}
+
+void MonsterStore::reserve(int count) {
+    posX.reserve(count);
+    posY.reserve(count);
+    state.reserve(count);
+    decisionTimer.reserve(count);
+    decisionInterval.reserve(count);
+    aggressionTimer.reserve(count);
+    fireBreathCooldown.reserve(count);
+    detectRangeSq.reserve(count);
+    loseRangeSq.reserve(count);
+    decisionDue.reserve(count);
+    nextX.reserve(count);
+    nextY.reserve(count);
+    levelOfDetail.reserve(count);
+    previousX.reserve(count);
+    previousY.reserve(count);
+    type.reserve(count);
+    canBreatheFire.reserve(count);
+    random.reserve(count);
+}
+
+void MonsterStore::saveState(GameSnapshot& out) const {
+    out.write(target);
+    out.write(tickCount);
+    out.write(scheduler);
+    out.writeVector(posX);
+    out.writeVector(posY);
+    out.writeVector(state);
+    out.writeVector(decisionTimer);
+    out.writeVector(decisionInterval);
+    out.writeVector(aggressionTimer);
+    out.writeVector(fireBreathCooldown);
+    out.writeVector(detectRangeSq);
+    out.writeVector(loseRangeSq);
+    out.writeVector(levelOfDetail);
+    out.writeVector(previousX);
+    out.writeVector(previousY);
+    out.writeVector(type);
+    out.writeVector(canBreatheFire);
+    out.writeVector(random);
+}
+
+bool MonsterStore::restoreState(GameSnapshot::Reader& in) {
+    if (!in.read(target) || !in.read(tickCount) || !in.read(scheduler) ||
+        !in.readVector(posX) || !in.readVector(posY) || !in.readVector(state) ||
+        !in.readVector(decisionTimer) || !in.readVector(decisionInterval) ||
+        !in.readVector(aggressionTimer) || !in.readVector(fireBreathCooldown) ||
+        !in.readVector(detectRangeSq) || !in.readVector(loseRangeSq) || !in.readVector(levelOfDetail) ||
+        !in.readVector(previousX) || !in.readVector(previousY) || !in.readVector(type) ||
+        !in.readVector(canBreatheFire) || !in.readVector(random)) {
+        return false;
+    }
+    
+    const size_t count = posX.size();
+    bool sameLength = posY.size() == count && state.size() == count && decisionTimer.size() == count &&
+                      decisionInterval.size() == count && aggressionTimer.size() == count &&
+                      fireBreathCooldown.size() == count && detectRangeSq.size() == count &&
+                      loseRangeSq.size() == count && levelOfDetail.size() == count &&
+                      previousX.size() == count && previousY.size() == count && type.size() == count &&
+                      canBreatheFire.size() == count && random.size() == count;
+    
+    // Enum values are switched on and used as indices, so none may be out of range
+    bool inRange = true;
+    for (size_t i = 0; sameLength && i < count; i++) {
+        inRange = inRange && (uint32_t)state[i] <= Monster::AGGRESSIVE &&
+                  (uint32_t)type[i] <= Monster::GREEN_DRAGON && levelOfDetail[i] <= LOD_DISTANT;
+    }
+    
+    // Scratch arrays are rewritten every tick before they are read
+    decisionDue.assign(count, 0);
+    nextX = posX;
+    nextY = posY;
+    return sameLength && inRange;
+}
+
+void MonsterStore::swapState(MonsterStore& other) {
+    posX.swap(other.posX);
+    posY.swap(other.posY);
+    state.swap(other.state);
+    decisionTimer.swap(other.decisionTimer);
+    decisionInterval.swap(other.decisionInterval);
+    aggressionTimer.swap(other.aggressionTimer);
+    fireBreathCooldown.swap(other.fireBreathCooldown);
+    detectRangeSq.swap(other.detectRangeSq);
+    loseRangeSq.swap(other.loseRangeSq);
+    decisionDue.swap(other.decisionDue);
+    nextX.swap(other.nextX);
+    nextY.swap(other.nextY);
+    levelOfDetail.swap(other.levelOfDetail);
+    previousX.swap(other.previousX);
+    previousY.swap(other.previousY);
+    type.swap(other.type);
+    canBreatheFire.swap(other.canBreatheFire);
+    random.swap(other.random);
+    std::swap(target, other.target);
+    std::swap(scheduler, other.scheduler);
+    std::swap(tickCount, other.tickCount);
+}
+
+void MonsterStore::update(float deltaTime, const Position& targetPos) {
+    target = targetPos;
+    const int count = size();
+    const int targetX = targetPos.x;
+    const int targetY = targetPos.y;
+    
+    // Monster::updateBehaviorState for everyone at once, several monsters per instruction
+    BehaviorKernel::Batch batch = {
+        posX.data(), posY.data(), state.data(), aggressionTimer.data(),
+        detectRangeSq.data(), loseRangeSq.data(), count
+    };
+    BehaviorKernel::updateStates(batch, targetX, targetY);
+    
+    updateLevelsOfDetail();
+    
+    // Raw pointers so the loops below are plainly independent per element
+    const int32_t* states = state.data();
+    float* timers = decisionTimer.data();
+    const float* intervals = decisionInterval.data();
+    uint8_t* lod = levelOfDetail.data();
+    uint8_t* due = decisionDue.data();
+    
+    // Distant monsters only tick on one tick in LOD_TICK_DIVISOR, staggered by index
+    const uint32_t slot = tickCount;
+    for (int i = 0; i < count; i++) {
+        int ticks = (lod[i] == LOD_FULL) | ((slot + (uint32_t)i) % LOD_TICK_DIVISOR == 0);
+        float timer = timers[i] + (ticks ? deltaTime : 0.0f);
+        timers[i] = timer;
+        due[i] = (uint8_t)(ticks & (timer >= intervals[i]));
+    }
+    tickCount++;
+    
+    // Over budget, some due monsters wait a tick with their timers still expired
+    scheduler.select(due, timers, intervals, count);
+    
+    // Decide: each monster whose timer fired picks its next tile. Reads shared
+    // state only and writes only its own slots (next tile, random stream), so
+    // chunks of monsters can run on any thread in any order
+    auto decideRange = [this, due, lod](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            if (!due[i]) {
+                continue;
+            }
+            if (lod[i] == LOD_DISTANT) {
+                decideWander(i);
+            } else {
+                decideMove(i);
+            }
+        }
+    };
+    if (workerPool && count >= PARALLEL_MIN_MONSTERS) {
+        workerPool->parallelFor(count, PARALLEL_CHUNK_SIZE, decideRange);
+    } else {
+        decideRange(0, count);
+    }
+    
+    // Commit, serially and in index order. Monsters may share a tile, so no
+    // two moves can conflict; anything that reads other monsters goes here
+    for (int i = 0; i < count; i++) {
+        if (!due[i]) {
+            continue;
+        }
+        posX[i] = nextX[i];
+        posY[i] = nextY[i];
+        
+        if (states[i] == Monster::AGGRESSIVE && canFireBreath(i)) {
+            if (BehaviorKernel::squaredDistance(posX[i] - targetX, posY[i] - targetY) <= FIRE_BREATH_RANGE_SQ) {
+                fireBreathCooldown[i] = FIRE_BREATH_COOLDOWN;
+            }
+        }
+    }
+    
+    // Monster::updateSpecialAbilities: both timers count down in simulated seconds
+    float* cooldowns = fireBreathCooldown.data();
+    float* aggression = aggressionTimer.data();
+    for (int i = 0; i < count; i++) {
+        float cooldown = cooldowns[i];
+        float reduced = cooldown - deltaTime;
+        cooldowns[i] = cooldown > 0.0f ? (reduced < 0.0f ? 0.0f : reduced) : cooldown;
+        
+        float timer = aggression[i];
+        float calmer = timer - deltaTime;
+        aggression[i] = timer > 0.0f ? (calmer < 0.0f ? 0.0f : calmer) : timer;
+    }
+}
+
+void MonsterStore::setLodDistance(float tiles) {
+    if (tiles <= 0.0f) {
+        lodDistanceSq = 0.0f;
+        std::fill(levelOfDetail.begin(), levelOfDetail.end(), (uint8_t)LOD_FULL);
+        return;
+    }
+    // Any closer and a monster the flow field promotes would be demoted again straight away
+    tiles = std::max(tiles, (float)LOD_FLOW_DISTANCE);
+    lodDistanceSq = tiles * tiles;
+}
+
+int MonsterStore::countDistant() const {
+    int distant = 0;
+    for (uint8_t lod : levelOfDetail) {
+        distant += lod == LOD_DISTANT;
+    }
+    return distant;
+}
+
+void MonsterStore::updateLevelsOfDetail() {
+    if (lodDistanceSq <= 0.0f) {
+        return;
+    }
+    
+    const int count = size();
+    const int targetX = target.x;
+    const int targetY = target.y;
+    const float demoteSq = lodDistanceSq;
+    const int32_t* x = posX.data();
+    const int32_t* y = posY.data();
+    const int32_t* states = state.data();
+    const float* lose = loseRangeSq.data();
+    uint8_t* lod = levelOfDetail.data();
+    
+    // By straight-line distance, every tick so a closing player is noticed at
+    // once. Bitwise instead of && and ?: on purpose: those branch, and a loop
+    // that branches isn't vectorized
+    for (int i = 0; i < count; i++) {
+        float distance = BehaviorKernel::squaredDistance(x[i] - targetX, y[i] - targetY);
+        int patrolling = states[i] == Monster::PATROLLING;
+        int stayDistant = patrolling & (distance > lose[i]);
+        int goDistant = patrolling & (distance > demoteSq);
+        int distant = lod[i];  // LOD_FULL = 0, LOD_DISTANT = 1
+        lod[i] = (uint8_t)((distant & stayDistant) | ((distant ^ 1) & goDistant));
+    }
+    
+    // By tunnel distance, a lookup per monster, so only for the distant
+    // monsters whose LOD tick this is. A path is never shorter than the
+    // straight line, so anything further than that is skipped unlooked
+    if (!flowField) {
+        return;
+    }
+    const float flowReachSq = (float)(LOD_FLOW_DISTANCE * LOD_FLOW_DISTANCE);
+    int first = (int)((LOD_TICK_DIVISOR - tickCount % LOD_TICK_DIVISOR) % LOD_TICK_DIVISOR);
+    for (int i = first; i < count; i += LOD_TICK_DIVISOR) {
+        if (lod[i] != LOD_DISTANT || BehaviorKernel::squaredDistance(x[i] - targetX, y[i] - targetY) > flowReachSq) {
+            continue;
+        }
+        int steps = flowField->getDistance(getPosition(i));
+        if (steps >= 0 && steps <= LOD_FLOW_DISTANCE) {
+            lod[i] = LOD_FULL;
+        }
+    }
+}
+
+void MonsterStore::decideWander(int index) {
+    // Distant model: one random step, no flow field and no chasing
+    nextX[index] = posX[index];
+    nextY[index] = posY[index];
+    wanderStep(index);
+}
+
+void MonsterStore::decideMove(int index) {
+    // Same decisions, and the same random draws, as Monster::moveTowardsTarget
+    int deltaX = target.x - posX[index];
+    int deltaY = target.y - posY[index];
+    bool wander = (state[index] == Monster::PATROLLING) && random[index].oneIn(4);
+    nextX[index] = posX[index];
+    nextY[index] = posY[index];
+    
+    Position next;
+    if (!wander && flowField && flowField->getNextStep(getPosition(index), next)) {
+        nextX[index] = next.x;
+        nextY[index] = next.y;
+        return;
+    }
+    
+    // Only patrolling monsters wander, so an aggressive red monster always heads straight in
+    if (wander) {
+        wanderStep(index);
+    } else if (abs(deltaX) > abs(deltaY)) {
+        if (deltaX > 0) step(index, 1, 0);
+        else if (deltaX < 0) step(index, -1, 0);
+    } else {
+        if (deltaY > 0) step(index, 0, 1);
+        else if (deltaY < 0) step(index, 0, -1);
+    }
+}
+
+void MonsterStore::wanderStep(int index) {
+    // Same draw and the same tunnels-only rule as Monster::wanderStep
+    Position next = getPosition(index);
+    switch (random[index].nextInt(4)) {
+        case 0: next.y--; break;
+        case 1: next.y++; break;
+        case 2: next.x--; break;
+        case 3: next.x++; break;
+    }
+    if (TerrainGrid::isOpen(terrain, next)) {
+        nextX[index] = next.x;
+        nextY[index] = next.y;
+    }
+}
+
+void MonsterStore::step(int index, int deltaX, int deltaY) {
+    Position next(posX[index] + deltaX, posY[index] + deltaY);
+    if (TerrainGrid::isInside(terrain, next)) {
+        nextX[index] = next.x;
+        nextY[index] = next.y;
+    }
+}
+
+void MonsterStore::storePreviousPositions() {
+    previousX = posX;
+    previousY = posY;
+}
+
+bool MonsterStore::canFireBreath(int index) const {
+    return canBreatheFire[index] && fireBreathCooldown[index] <= 0.0f && state[index] == Monster::AGGRESSIVE;
+}
+
+Vector2 MonsterStore::getRenderOffset(int index, float alpha) const {
+    return GameThing::renderOffset(Position(previousX[index], previousY[index]), getPosition(index), alpha);
+}
+
+void MonsterStore::draw(int index) const {
+    Monster::drawAt(getPosition(index), getType(index), getBehaviorState(index), canFireBreath(index),
+                    target.x < posX[index]);
+}
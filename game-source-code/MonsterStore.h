@@ -0,0 +1,190 @@
+#ifndef MONSTERSTORE_H
+#define MONSTERSTORE_H
+
+#include "DecisionScheduler.h"
+#include "GameSnapshot.h"
+#include "Monster.h"
+#include "Position.h"
+#include "Random.h"
+#include <cstdint>
+#include <vector>
+
+class TerrainGrid;
+class FlowField;
+class WorkerPool;
+
+/**
+ * @brief Every monster of a level, stored as parallel arrays (structure of arrays)
+ *
+ * Behaves exactly like a std::vector<Monster> whose elements each get
+ * setTarget() and update() every tick, but the per-tick work runs as a few
+ * passes over plain int and float arrays: behaviour state transitions run
+ * through the SIMD BehaviorKernel, decision timers are a branch-free loop
+ * the compiler can vectorize, and only the monsters whose decision timer fired take the
+ * scalar path (flow field, random wander, terrain bounds). A
+ * DecisionScheduler caps how many of them do so in one tick.
+ *
+ * That scalar path is split in two: a decide phase that only writes each
+ * monster's own next tile and random stream, spread over a WorkerPool when
+ * there are enough monsters, and a serial commit phase that applies the
+ * moves in index order. Every monster draws from its own random stream, so
+ * the result is the same whatever the thread count.
+ *
+ * Monsters far from the target run a cheaper AI (level of detail). A
+ * patrolling monster further than the LOD distance drops to DISTANT: its
+ * decision timer only advances on one tick in LOD_TICK_DIVISOR, so it
+ * decides that many times less often, and its decision is a plain random
+ * step with no flow field. It is promoted back to full AI as soon as the
+ * target comes within 1.5x its detection range (the range at which a chase
+ * is given up), or on its next LOD tick if the target is within
+ * LOD_FLOW_DISTANCE steps through the tunnels.
+ *
+ * A monster is identified by its index; remove() swaps the last monster into
+ * the freed slot, the same as Game's spatial index expects.
+ */
+class MonsterStore {
+public:
+    static const int PARALLEL_MIN_MONSTERS = 256;  // fewer are decided on the calling thread
+    static const int PARALLEL_CHUNK_SIZE = 64;
+    
+    enum LevelOfDetail {
+        LOD_FULL = 0,
+        LOD_DISTANT = 1
+    };
+    
+    static constexpr float DEFAULT_LOD_DISTANCE = 24.0f;  // tiles; 0 turns LOD off
+    static const int LOD_TICK_DIVISOR = 8;                // distant monsters tick this much less often
+    static const int LOD_FLOW_DISTANCE = 20;              // promote within this many steps by flow field
+
+private:
+    // Hot data, touched every tick by every monster
+    std::vector<int32_t> posX;
+    std::vector<int32_t> posY;
+    std::vector<int32_t> state;            // Monster::BehaviorState
+    std::vector<float> decisionTimer;
+    std::vector<float> decisionInterval;
+    std::vector<float> aggressionTimer;
+    std::vector<float> fireBreathCooldown;
+    std::vector<float> detectRangeSq;      // PATROLLING -> CHASING within this
+    std::vector<float> loseRangeSq;        // CHASING -> PATROLLING beyond this
+    std::vector<uint8_t> decisionDue;      // scratch: decision timer fired this tick
+    std::vector<int32_t> nextX;            // scratch: tile picked by the decide phase
+    std::vector<int32_t> nextY;
+    std::vector<uint8_t> levelOfDetail;    // LevelOfDetail
+    
+    // Cold data, only read when a monster moves or is drawn
+    std::vector<int32_t> previousX;
+    std::vector<int32_t> previousY;
+    std::vector<int32_t> type;             // Monster::MonsterType
+    std::vector<uint8_t> canBreatheFire;
+    std::vector<Random> random;
+    
+    Position target;
+    const TerrainGrid* terrain;
+    const FlowField* flowField;
+    WorkerPool* workerPool;
+    DecisionScheduler scheduler;
+    float lodDistanceSq;
+    uint32_t tickCount;                    // picks which distant monsters tick this time
+
+public:
+    MonsterStore();
+    
+    void setTerrain(const TerrainGrid* terrainRef) { terrain = terrainRef; }
+    void setFlowField(const FlowField* field) { flowField = field; }
+    
+    /**
+     * @brief Threads for the decide phase; nullptr keeps everything on the calling thread
+     */
+    void setWorkerPool(WorkerPool* pool) { workerPool = pool; }
+    
+    /**
+     * @brief Per-tick decision budget and its statistics
+     */
+    DecisionScheduler& getScheduler() { return scheduler; }
+    const DecisionScheduler& getScheduler() const { return scheduler; }
+    
+    /**
+     * @brief Distance beyond which patrolling monsters drop to the cheap distant AI
+     * @param tiles Distance in tiles, at least LOD_FLOW_DISTANCE; 0 keeps every monster on full AI
+     */
+    void setLodDistance(float tiles);
+    
+    /**
+     * @brief Add a monster, copying all of its state
+     * @param monster Monster to copy (type, position, timers, state, random stream)
+     * @return Index of the new monster
+     */
+    int add(const Monster& monster);
+    
+    /**
+     * @brief Remove a monster; the last monster takes its index
+     * @param index Monster to remove
+     */
+    void remove(int index);
+    
+    void clear();
+    void reserve(int count);
+    int size() const { return (int)posX.size(); }
+    bool empty() const { return posX.empty(); }
+    
+    /**
+     * @brief One simulation tick for every monster, as Monster::setTarget + Monster::update
+     * @param deltaTime Tick length in seconds
+     * @param targetPos Tile every monster is after (the player)
+     */
+    void update(float deltaTime, const Position& targetPos);
+    
+    void storePreviousPositions();
+    
+    Position getPosition(int index) const { return Position(posX[index], posY[index]); }
+    Monster::MonsterType getType(int index) const { return static_cast<Monster::MonsterType>(type[index]); }
+    Monster::BehaviorState getBehaviorState(int index) const { return static_cast<Monster::BehaviorState>(state[index]); }
+    float getAggressionTimer(int index) const { return aggressionTimer[index]; }
+    float getFireBreathCooldown(int index) const { return fireBreathCooldown[index]; }
+    bool canFireBreath(int index) const;
+    LevelOfDetail getLevelOfDetail(int index) const { return static_cast<LevelOfDetail>(levelOfDetail[index]); }
+    
+    /**
+     * @brief Number of monsters on the distant AI
+     */
+    int countDistant() const;
+    
+    /**
+     * @brief Pixel offset for drawing a monster between its last two tiles
+     * @param index Monster
+     * @param alpha How far between the previous and current tick to draw (0-1)
+     */
+    Vector2 getRenderOffset(int index, float alpha) const;
+    
+    void draw(int index) const;
+    
+    /**
+     * @brief Append every monster and the scheduler to a snapshot
+     *
+     * Wiring (terrain, flow field, worker pool) and the LOD distance are
+     * settings, not state, and are left as they are.
+     */
+    void saveState(GameSnapshot& out) const;
+    
+    /**
+     * @brief Read back what saveState wrote, replacing every monster
+     * @return False if the data is truncated or the arrays disagree in length
+     */
+    bool restoreState(GameSnapshot::Reader& in);
+    
+    /**
+     * @brief Exchange every monster and the scheduler with another store; wiring stays put
+     * @param other Store to swap with
+     */
+    void swapState(MonsterStore& other);
+
+private:
+    void updateLevelsOfDetail();
+    void decideMove(int index);
+    void decideWander(int index);
+    void wanderStep(int index);
+    void step(int index, int deltaX, int deltaY);
+};
+
+#endif // MONSTERSTORE_H
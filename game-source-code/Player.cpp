@@ -1,7 +1,7 @@
 #include "Player.h"
 #include "SpriteManager.h"
 #include "TerrainGrid.h"
-#include <iostream>
+#include "Logger.h"
 
 Player::Player(const Position& startPos) 
     : GameThing(startPos), facingDirection(RIGHT), movingDirection(NONE),
@@ -20,6 +20,50 @@ Player::Player(const Position& startPos)
     powerUps.invulnerableTimer = 0.0f;
 }
 
+bool Player::SavedState::isValid() const {
+    return (unsigned)facingDirection <= RIGHT && (unsigned)movingDirection <= RIGHT;
+}
+
+Player::SavedState Player::getSavedState() const {
+    SavedState saved;
+    saved.location = location;
+    saved.previousLocation = previousLocation;
+    saved.isActive = isActive;
+    saved.facingDirection = facingDirection;
+    saved.movingDirection = movingDirection;
+    saved.moveSpeed = moveSpeed;
+    saved.baseMoveSpeed = baseMoveSpeed;
+    saved.isMoving = isMoving;
+    saved.shootCooldown = shootCooldown;
+    saved.baseShootCooldown = baseShootCooldown;
+    saved.harpoonRange = harpoonRange;
+    saved.baseHarpoonRange = baseHarpoonRange;
+    saved.moveTimer = moveTimer;
+    saved.moveInterval = moveInterval;
+    saved.powerUps = powerUps;
+    saved.currentInput = currentInput;
+    return saved;
+}
+
+void Player::setSavedState(const SavedState& saved) {
+    location = saved.location;
+    previousLocation = saved.previousLocation;
+    isActive = saved.isActive;
+    facingDirection = saved.facingDirection;
+    movingDirection = saved.movingDirection;
+    moveSpeed = saved.moveSpeed;
+    baseMoveSpeed = saved.baseMoveSpeed;
+    isMoving = saved.isMoving;
+    shootCooldown = saved.shootCooldown;
+    baseShootCooldown = saved.baseShootCooldown;
+    harpoonRange = saved.harpoonRange;
+    baseHarpoonRange = saved.baseHarpoonRange;
+    moveTimer = saved.moveTimer;
+    moveInterval = saved.moveInterval;
+    powerUps = saved.powerUps;
+    currentInput = saved.currentInput;
+}
+
 void Player::setTerrain(TerrainGrid* terrain) {
     worldTerrain = terrain;
 }
@@ -28,16 +72,16 @@ void Player::handleInput() {
     if (moveTimer <= 0.0f) {
         movingDirection = NONE;
         
-        if (IsKeyDown(KEY_UP)) {
+        if (currentInput.isDown(InputState::MOVE_UP)) {
             moveUp();
             moveTimer = moveInterval;
-        } else if (IsKeyDown(KEY_DOWN)) {
+        } else if (currentInput.isDown(InputState::MOVE_DOWN)) {
             moveDown();
             moveTimer = moveInterval;
-        } else if (IsKeyDown(KEY_LEFT)) {
+        } else if (currentInput.isDown(InputState::MOVE_LEFT)) {
             moveLeft();
             moveTimer = moveInterval;
-        } else if (IsKeyDown(KEY_RIGHT)) {
+        } else if (currentInput.isDown(InputState::MOVE_RIGHT)) {
             moveRight();
             moveTimer = moveInterval;
         }
@@ -50,27 +94,27 @@ void Player::applyPowerUp(PowerUp::PowerUpType type, float duration) {
             powerUps.speedBoost = true;
             powerUps.speedBoostTimer = duration;
             moveInterval = 0.08f;
-            std::cout << "Speed boost activated!" << std::endl;
+            GAME_LOG_INFO("Speed boost activated!");
             break;
             
         case PowerUp::EXTENDED_RANGE:
             powerUps.extendedRange = true;
             powerUps.extendedRangeTimer = duration;
             harpoonRange = baseHarpoonRange * 2;
-            std::cout << "Extended range activated!" << std::endl;
+            GAME_LOG_INFO("Extended range activated!");
             break;
             
         case PowerUp::RAPID_FIRE:
             powerUps.rapidFire = true;
             powerUps.rapidFireTimer = duration;
             baseShootCooldown = 0.3f;
-            std::cout << "Rapid fire activated!" << std::endl;
+            GAME_LOG_INFO("Rapid fire activated!");
             break;
             
         case PowerUp::INVULNERABILITY:
             powerUps.invulnerable = true;
             powerUps.invulnerableTimer = duration;
-            std::cout << "Invulnerability activated!" << std::endl;
+            GAME_LOG_INFO("Invulnerability activated!");
             break;
     }
 }
@@ -100,14 +144,14 @@ bool Player::canDigAt(Position spot) const {
 void Player::digAt(Position spot) {
     if (canDigAt(spot)) {
         worldTerrain->digTunnelAt(spot);
-        std::cout << "Dug tunnel at (" << spot.x << ", " << spot.y << ")" << std::endl;
+        GAME_LOG_DEBUG("Dug tunnel at (%d, %d)", spot.x, spot.y);
         
         // Check for rocks above - but don't spam rock stability checks
         Position abovePos = spot;
         abovePos.y--;
         if (worldTerrain->isBlockRock(abovePos)) {
             worldTerrain->triggerRockFall(abovePos);
-            std::cout << "Rock triggered above dig site!" << std::endl;
+            GAME_LOG_DEBUG("Rock triggered above dig site!");
         }
     }
 }
@@ -151,12 +195,12 @@ void Player::moveInDirection(Direction dir) {
         default: return;
     }
     
-    if (!newPos.isValid()) {
+    if (!TerrainGrid::isInside(worldTerrain, newPos)) {
         return;
     }
     
     if (newPos.y < 3) {
-        std::cout << "Cannot go above ground level!" << std::endl;
+        GAME_LOG_DEBUG("Cannot go above ground level!");
         return;
     }
     
@@ -168,7 +212,7 @@ void Player::moveInDirection(Direction dir) {
             digAt(newPos);
             location = newPos;
             movingDirection = dir;
-            std::cout << "Dug and moved to (" << newPos.x << ", " << newPos.y << ")" << std::endl;
+            GAME_LOG_DEBUG("Dug and moved to (%d, %d)", newPos.x, newPos.y);
         }
     } else {
         location = newPos;
@@ -197,7 +241,7 @@ void Player::updatePowerUps(float deltaTime) {
         if (powerUps.speedBoostTimer <= 0.0f) {
             powerUps.speedBoost = false;
             moveInterval = 0.15f;
-            std::cout << "Speed boost expired" << std::endl;
+            GAME_LOG_INFO("Speed boost expired");
         }
     }
     
@@ -206,7 +250,7 @@ void Player::updatePowerUps(float deltaTime) {
         if (powerUps.extendedRangeTimer <= 0.0f) {
             powerUps.extendedRange = false;
             harpoonRange = baseHarpoonRange;
-            std::cout << "Extended range expired" << std::endl;
+            GAME_LOG_INFO("Extended range expired");
         }
     }
     
@@ -215,7 +259,7 @@ void Player::updatePowerUps(float deltaTime) {
         if (powerUps.rapidFireTimer <= 0.0f) {
             powerUps.rapidFire = false;
             baseShootCooldown = 1.0f;
-            std::cout << "Rapid fire expired" << std::endl;
+            GAME_LOG_INFO("Rapid fire expired");
         }
     }
     
@@ -223,7 +267,7 @@ void Player::updatePowerUps(float deltaTime) {
         powerUps.invulnerableTimer -= deltaTime;
         if (powerUps.invulnerableTimer <= 0.0f) {
             powerUps.invulnerable = false;
-            std::cout << "Invulnerability expired" << std::endl;
+            GAME_LOG_INFO("Invulnerability expired");
         }
     }
 }
@@ -4,6 +4,7 @@
 #include "GameThing.h"
 #include "Interfaces.h"
 #include "PowerUp.h"
+#include "InputProvider.h"
 #include <raylib-cpp.hpp>
 
 class Player : public GameThing, public CanMove, public CanCollide, public CanDig, public CanShoot {
@@ -43,11 +44,48 @@ private:
     } powerUps;
     
     class TerrainGrid* worldTerrain;
+    InputState currentInput;
     
 public:
+    /**
+     * @brief Everything update() depends on, as plain data for GameSnapshot (no terrain pointer)
+     */
+    struct SavedState {
+        Position location;
+        Position previousLocation;
+        bool isActive;
+        Direction facingDirection;
+        Direction movingDirection;
+        float moveSpeed;
+        float baseMoveSpeed;
+        bool isMoving;
+        float shootCooldown;
+        float baseShootCooldown;
+        int harpoonRange;
+        int baseHarpoonRange;
+        float moveTimer;
+        float moveInterval;
+        PowerUpEffects powerUps;
+        InputState currentInput;
+        
+        /**
+         * @brief False if the facing or moving direction is not one of Direction's values
+         */
+        bool isValid() const;
+    };
+    
     Player(const Position& startPos = Position(10, 10));
     
+    SavedState getSavedState() const;
+    
+    /**
+     * @brief Put the player back into a saved state; the terrain stays as set
+     */
+    void setSavedState(const SavedState& saved);
+    
     void setTerrain(class TerrainGrid* terrain);
+    class TerrainGrid* getTerrain() const { return worldTerrain; }
+    void setInput(const InputState& input) { currentInput = input; }
     void handleInput();
     
     Direction getFacingDirection() const { return facingDirection; }
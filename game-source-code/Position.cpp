@@ -21,8 +21,9 @@ bool Position::isValid() const {
 }
 
 float Position::distanceTo(const Position& other) const {
-    int deltaX = x - other.x;
-    int deltaY = y - other.y;
+    // In float: an int square overflows on the largest grids
+    float deltaX = (float)(x - other.x);
+    float deltaY = (float)(y - other.y);
     return std::sqrt(deltaX * deltaX + deltaY * deltaY);
 }
 
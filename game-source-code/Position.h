@@ -11,7 +11,8 @@ class Position {
 public:
     int x, y;
     
-    // World size constants
+    // Size of the classic 40x30 world; levels can be larger, so game code
+    // should check bounds against its TerrainGrid instead
     static const int WORLD_WIDTH = 40;
     static const int WORLD_HEIGHT = 30;
     static const int BLOCK_SIZE = 20; // pixels per world unit
@@ -45,7 +46,7 @@ public:
     bool operator==(const Position& other) const;
     
     /**
-     * @brief Check if this position is within valid world bounds
+     * @brief Check if this position is within the classic world bounds
      * @return True if position is valid
      */
     bool isValid() const;
@@ -25,6 +25,24 @@ PowerUp::PowerUp(const Position& pos, PowerUpType powerType)
     }
 }
 
+bool PowerUp::SavedState::isValid() const {
+    return (unsigned)type <= INVULNERABILITY;
+}
+
+PowerUp::SavedState PowerUp::getSavedState() const {
+    return SavedState{ location, previousLocation, isActive, type, duration, pulseTimer, collected };
+}
+
+void PowerUp::setSavedState(const SavedState& saved) {
+    location = saved.location;
+    previousLocation = saved.previousLocation;
+    isActive = saved.isActive;
+    type = saved.type;
+    duration = saved.duration;
+    pulseTimer = saved.pulseTimer;
+    collected = saved.collected;
+}
+
 raylib::Rectangle PowerUp::getBounds() const {
     Position pixelPos = location.toPixels();
     return raylib::Rectangle(pixelPos.x, pixelPos.y, Position::BLOCK_SIZE, Position::BLOCK_SIZE);
@@ -21,6 +21,24 @@ private:
     bool collected;
     
 public:
+    /**
+     * @brief Plain-data copy of a power-up, for GameSnapshot
+     */
+    struct SavedState {
+        Position location;
+        Position previousLocation;
+        bool isActive;
+        PowerUpType type;
+        float duration;
+        float pulseTimer;
+        bool collected;
+        
+        /**
+         * @brief False if type is not one of the four power-ups
+         */
+        bool isValid() const;
+    };
+    
     PowerUp(); // Default constructor
     PowerUp(const Position& pos, PowerUpType powerType);
     
@@ -29,6 +47,9 @@ public:
     bool isCollected() const { return collected; }
     void collect() { collected = true; setActive(false); }
     
+    SavedState getSavedState() const;
+    void setSavedState(const SavedState& saved);
+    
     // CanCollide interface
     raylib::Rectangle getBounds() const override;
     void onCollision(const CanCollide& other) override;
@@ -0,0 +1,199 @@
+#include "Profiler.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+bool Profiler::enabled = true;
+
+Profiler::Profiler() : frames(FRAME_HISTORY), frameCount(1), depth(0), epoch(std::chrono::steady_clock::now()) {
+    Frame& first = frames[0];
+    first.index = 0;
+    first.startNs = 0;
+    first.durationNs = 0;
+    first.sampleCount = 0;
+    first.droppedCount = 0;
+}
+
+Profiler* Profiler::getInstance() {
+    static Profiler instance;
+    return &instance;
+}
+
+int64_t Profiler::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::setEnabled(bool on) {
+    if (on && !enabled) {
+        // Don't count the time spent switched off towards the current frame
+        frames[(frameCount.load(std::memory_order_relaxed) - 1) % FRAME_HISTORY].startNs = now();
+    }
+    enabled = on;
+}
+
+void Profiler::beginFrame() {
+    if (!enabled) {
+        return;
+    }
+    
+    uint64_t current = frameCount.load(std::memory_order_relaxed) - 1;
+    int64_t timestamp = now();
+    Frame& finished = frames[current % FRAME_HISTORY];
+    finished.durationNs = timestamp - finished.startNs;
+    
+    // Publish before reusing the next slot: once readers see the new count,
+    // that slot is no longer one of the finished frames they may read
+    uint64_t next = current + 1;
+    frameCount.store(next + 1, std::memory_order_release);
+    
+    Frame& frame = frames[next % FRAME_HISTORY];
+    frame.index = next;
+    frame.startNs = timestamp;
+    frame.durationNs = 0;
+    frame.sampleCount = 0;
+    frame.droppedCount = 0;
+    depth = 0;
+}
+
+int Profiler::beginSample(const char* name) {
+    if (!enabled) {
+        return DISABLED_SLOT;
+    }
+    
+    Frame& frame = frames[(frameCount.load(std::memory_order_relaxed) - 1) % FRAME_HISTORY];
+    depth++;
+    if (frame.sampleCount >= MAX_SAMPLES_PER_FRAME) {
+        frame.droppedCount++;
+        return DROPPED_SLOT;
+    }
+    
+    int slot = frame.sampleCount++;
+    Sample& sample = frame.samples[slot];
+    sample.name = name;
+    sample.depth = depth - 1;
+    sample.durationNs = 0;
+    sample.startNs = now();
+    return slot;
+}
+
+void Profiler::endSample(int slot) {
+    if (slot == DISABLED_SLOT) {
+        return;
+    }
+    depth--;
+    if (slot == DROPPED_SLOT) {
+        return;
+    }
+    Frame& frame = frames[(frameCount.load(std::memory_order_relaxed) - 1) % FRAME_HISTORY];
+    Sample& sample = frame.samples[slot];
+    sample.durationNs = now() - sample.startNs;
+}
+
+int Profiler::getFinishedFrameCount() const {
+    uint64_t count = frameCount.load(std::memory_order_acquire) - 1;
+    return (int)std::min<uint64_t>(count, FRAME_HISTORY - 1);
+}
+
+const Profiler::Frame& Profiler::getFinishedFrame(int age) const {
+    uint64_t current = frameCount.load(std::memory_order_acquire) - 1;
+    return frames[(current - 1 - age) % FRAME_HISTORY];
+}
+
+std::vector<Profiler::SectionStats> Profiler::summarize() const {
+    std::vector<SectionStats> sections;
+    std::vector<double> frameTotals;
+    int frameTotal = getFinishedFrameCount();
+    
+    for (int age = 0; age < frameTotal; age++) {
+        const Frame& frame = getFinishedFrame(age);
+        std::fill(frameTotals.begin(), frameTotals.end(), 0.0);
+        
+        for (int i = 0; i < frame.sampleCount; i++) {
+            const Sample& sample = frame.samples[i];
+            size_t section = 0;
+            while (section < sections.size() && std::strcmp(sections[section].name, sample.name) != 0) {
+                section++;
+            }
+            if (section == sections.size()) {
+                sections.push_back({ sample.name, sample.depth, 0.0, 0.0, 0.0 });
+                frameTotals.push_back(0.0);
+            }
+            frameTotals[section] += sample.durationNs / 1.0e6;
+        }
+        
+        for (size_t section = 0; section < sections.size(); section++) {
+            if (age == 0) {
+                sections[section].lastMs = frameTotals[section];
+            }
+            sections[section].averageMs += frameTotals[section];
+            sections[section].maxMs = std::max(sections[section].maxMs, frameTotals[section]);
+        }
+    }
+    
+    for (auto& section : sections) {
+        section.averageMs /= std::max(1, frameTotal);
+    }
+    return sections;
+}
+
+// Section names are string literals, but keep the JSON valid whatever they hold
+static void writeJsonString(std::ostream& output, const char* text) {
+    output << '"';
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            output << '\\' << *c;
+        } else if ((unsigned char)*c < 0x20) {
+            output << ' ';
+        } else {
+            output << *c;
+        }
+    }
+    output << '"';
+}
+
+void Profiler::writeChromeTrace(std::ostream& output) const {
+    // Complete ("X") events with microsecond timestamps, oldest frame first
+    output << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    output << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (int age = getFinishedFrameCount() - 1; age >= 0; age--) {
+        const Frame& frame = getFinishedFrame(age);
+        output << (first ? "" : ",\n") << "{\"name\": \"frame\", \"cat\": \"frame\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": "
+               << frame.startNs / 1000.0 << ", \"dur\": " << frame.durationNs / 1000.0
+               << ", \"args\": {\"index\": " << frame.index << ", \"dropped\": " << frame.droppedCount << "}}";
+        first = false;
+        
+        for (int i = 0; i < frame.sampleCount; i++) {
+            const Sample& sample = frame.samples[i];
+            output << ",\n{\"name\": ";
+            writeJsonString(output, sample.name);
+            output << ", \"cat\": \"game\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": " << sample.startNs / 1000.0
+                   << ", \"dur\": " << sample.durationNs / 1000.0 << "}";
+        }
+    }
+    output << "\n]}\n";
+}
+
+bool Profiler::saveChromeTrace(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        GAME_LOG_ERROR("Could not write profiler trace %s", filename.c_str());
+        return false;
+    }
+    writeChromeTrace(file);
+    GAME_LOG_INFO("Profiler trace written to %s (%d frames)", filename.c_str(), getFinishedFrameCount());
+    return file.good();
+}
+
+void Profiler::reset() {
+    frameCount.store(1, std::memory_order_release);
+    Frame& first = frames[0];
+    first.index = 0;
+    first.startNs = now();
+    first.durationNs = 0;
+    first.sampleCount = 0;
+    first.droppedCount = 0;
+    depth = 0;
+}
@@ -0,0 +1,176 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Per-subsystem frame timer
+ *
+ * Code is timed with GAME_PROFILE_SCOPE("name") probes. Each frame's samples
+ * go into one slot of a ring of FRAME_HISTORY fixed-size frames, so recording
+ * never allocates or locks. The game thread is the only writer; a frame is
+ * published with a release store of the frame counter when the next one
+ * begins, so readers only ever look at finished frames.
+ *
+ * Recording can also be switched off at runtime (headless runs do, unless a
+ * trace was asked for); a disabled probe costs a branch and no clock reads.
+ * Build with GAME_PROFILE=0 to compile every probe out.
+ */
+class Profiler {
+public:
+    static const int FRAME_HISTORY = 120;          // two seconds at 60 fps
+    static const int MAX_SAMPLES_PER_FRAME = 256;  // further probes in a frame are dropped
+    static const int DROPPED_SLOT = -1;            // beginSample results that record nothing
+    static const int DISABLED_SLOT = -2;
+    
+    struct Sample {
+        const char* name;  // string literal; also the section key
+        int depth;         // nesting level, 0 = outermost
+        int64_t startNs;   // since the profiler was created
+        int64_t durationNs;
+    };
+    
+    struct Frame {
+        uint64_t index;
+        int64_t startNs;
+        int64_t durationNs;
+        int sampleCount;
+        int droppedCount;
+        Sample samples[MAX_SAMPLES_PER_FRAME];
+    };
+    
+    /**
+     * @brief Time spent in one named section, summed per frame
+     */
+    struct SectionStats {
+        const char* name;
+        int depth;
+        double lastMs;     // most recent finished frame
+        double averageMs;  // over the frames in the ring
+        double maxMs;
+    };
+
+private:
+    std::vector<Frame> frames;
+    std::atomic<uint64_t> frameCount;  // frames begun; frame n lives in slot n % FRAME_HISTORY
+    int depth;
+    static bool enabled;  // static so a disabled probe is one load and a branch
+    std::chrono::steady_clock::time_point epoch;
+    
+    Profiler();
+
+public:
+    static Profiler* getInstance();
+    
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+    
+    /**
+     * @brief Close the current frame and start recording the next one
+     */
+    void beginFrame();
+    
+    /**
+     * @brief Open a sample; use GAME_PROFILE_SCOPE instead of calling this directly
+     * @param name Section name, must outlive the profiler (a string literal)
+     * @return Slot to pass to endSample, DROPPED_SLOT if the frame is full or DISABLED_SLOT
+     */
+    int beginSample(const char* name);
+    
+    /**
+     * @brief Close a sample opened by beginSample
+     * @param slot Value returned by beginSample
+     */
+    void endSample(int slot);
+    
+    /**
+     * @brief Turn recording on or off; no frames are recorded while it is off
+     * @param on True to record samples
+     */
+    void setEnabled(bool on);
+    static bool isEnabled() { return enabled; }
+    
+    /**
+     * @brief Number of frames that have finished and can be read
+     */
+    int getFinishedFrameCount() const;
+    
+    /**
+     * @brief Read a finished frame
+     * @param age 0 = most recent finished frame, up to getFinishedFrameCount() - 1
+     * @return The frame
+     */
+    const Frame& getFinishedFrame(int age) const;
+    
+    /**
+     * @brief Per-section totals over the finished frames, in first-seen order
+     * @return One entry per distinct section name
+     */
+    std::vector<SectionStats> summarize() const;
+    
+    /**
+     * @brief Write the finished frames as Chrome trace-event JSON
+     *
+     * Open the result in chrome://tracing or https://ui.perfetto.dev.
+     * @param output Stream to write to
+     */
+    void writeChromeTrace(std::ostream& output) const;
+    
+    /**
+     * @brief Write the finished frames to a Chrome trace file
+     * @param filename File to create
+     * @return False if the file could not be written
+     */
+    bool saveChromeTrace(const std::string& filename) const;
+    
+    /**
+     * @brief Forget all recorded frames
+     */
+    void reset();
+
+private:
+    int64_t now() const;
+};
+
+/**
+ * @brief Times the enclosing scope as one profiler sample
+ */
+class ProfileScope {
+private:
+    int slot;
+
+public:
+    explicit ProfileScope(const char* name)
+        : slot(Profiler::isEnabled() ? Profiler::getInstance()->beginSample(name) : Profiler::DISABLED_SLOT) {}
+    ~ProfileScope() {
+        if (slot != Profiler::DISABLED_SLOT) {
+            Profiler::getInstance()->endSample(slot);
+        }
+    }
+    
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+// Compile-time switch: 0 removes every probe
+#ifndef GAME_PROFILE
+#define GAME_PROFILE 1
+#endif
+
+#define GAME_PROFILE_JOIN_INNER(a, b) a##b
+#define GAME_PROFILE_JOIN(a, b) GAME_PROFILE_JOIN_INNER(a, b)
+
+#if GAME_PROFILE
+#define GAME_PROFILE_SCOPE(name) ProfileScope GAME_PROFILE_JOIN(profileScope, __LINE__)(name)
+#define GAME_PROFILE_FRAME() Profiler::getInstance()->beginFrame()
+#else
+#define GAME_PROFILE_SCOPE(name) ((void)0)
+#define GAME_PROFILE_FRAME() ((void)0)
+#endif
+
+#endif // PROFILER_H
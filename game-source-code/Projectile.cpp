@@ -1,29 +1,49 @@
 #include "Projectile.h"
 #include "Player.h"
-#include <iostream>
+#include "TerrainGrid.h"
+#include "Logger.h"
 
-Projectile::Projectile(Player* player, Direction dir, int range) 
-    : GameThing(Position(0, 0)), ownerPlayer(player), direction(dir), state(EXTENDING), 
+Projectile::Projectile(const Player* player, Direction dir, int range, uint32_t ownerHandle) 
+    : GameThing(Position(0, 0)), direction(dir), state(EXTENDING), owner(ownerHandle),
+      ownerPosition(player ? player->getPosition() : Position(0, 0)),
       relativeOffset(0, 0), maxRange(range), currentLength(0), 
-      moveTimer(0.0f), hitSomething(false) {
+      moveTimer(0.0f), hitSomething(false), terrain(player ? player->getTerrain() : nullptr) {
     
     // Start with no offset - tip is at player position
-    relativeOffset = Position(0, 0);
-    location = getPlayerPosition();
+    location = ownerPosition;
     
-    std::cout << "Player-relative harpoon created, range: " << range << std::endl;
+    GAME_LOG_DEBUG("Player-relative harpoon created, range: %d", range);
 }
 
-Position Projectile::getPlayerPosition() const {
-    if (ownerPlayer) {
-        return ownerPlayer->getPosition();
-    }
-    return Position(0, 0);
+Projectile::Projectile(const SavedState& saved, const TerrainGrid* world)
+    : GameThing(saved.location), direction(saved.direction), state(saved.state), owner(saved.owner),
+      ownerPosition(saved.ownerPosition), relativeOffset(saved.relativeOffset), maxRange(saved.maxRange),
+      currentLength(saved.currentLength), moveTimer(saved.moveTimer), hitSomething(saved.hitSomething),
+      terrain(world) {
+    previousLocation = saved.previousLocation;
+    isActive = saved.isActive;
+}
+
+bool Projectile::SavedState::isValid() const {
+    return (unsigned)direction <= RIGHT && (unsigned)state <= FINISHED;
+}
+
+Projectile::SavedState Projectile::getSavedState() const {
+    return SavedState{ location, previousLocation, isActive, direction, state, owner, ownerPosition,
+                            relativeOffset, maxRange, currentLength, moveTimer, hitSomething };
+}
+
+void Projectile::follow(const Position& ownerPos) {
+    ownerPosition = ownerPos;
+    location = getTipPosition();
+}
+
+bool Projectile::isInsideWorld(const Position& pos) const {
+    return TerrainGrid::isInside(terrain, pos);
 }
 
 Position Projectile::getTipPosition() const {
-    Position playerPos = getPlayerPosition();
-    return Position(playerPos.x + relativeOffset.x, playerPos.y + relativeOffset.y);
+    return Position(ownerPosition.x + relativeOffset.x, ownerPosition.y + relativeOffset.y);
 }
 
 Position Projectile::getPosition() const {
@@ -36,7 +56,7 @@ void Projectile::moveUp() {
         currentLength++;
         location = getTipPosition();
         
-        if (!location.isValid() || currentLength >= maxRange) {
+        if (!isInsideWorld(location) || currentLength >= maxRange) {
             startRetracting();
         }
     }
@@ -48,7 +68,7 @@ void Projectile::moveDown() {
         currentLength++;
         location = getTipPosition();
         
-        if (!location.isValid() || currentLength >= maxRange) {
+        if (!isInsideWorld(location) || currentLength >= maxRange) {
             startRetracting();
         }
     }
@@ -60,7 +80,7 @@ void Projectile::moveLeft() {
         currentLength++;
         location = getTipPosition();
         
-        if (!location.isValid() || currentLength >= maxRange) {
+        if (!isInsideWorld(location) || currentLength >= maxRange) {
             startRetracting();
         }
     }
@@ -72,7 +92,7 @@ void Projectile::moveRight() {
         currentLength++;
         location = getTipPosition();
         
-        if (!location.isValid() || currentLength >= maxRange) {
+        if (!isInsideWorld(location) || currentLength >= maxRange) {
             startRetracting();
         }
     }
@@ -115,12 +135,12 @@ void Projectile::update(float deltaTime) {
         }
     }
     
-    // Always update location to follow player
+    // Tip = owner's tile as of the last follow(), plus the tether
     location = getTipPosition();
 }
 
 void Projectile::draw() const {
-    Position playerPos = getPlayerPosition();
+    Position playerPos = ownerPosition;
     Position tipPos = getTipPosition();
     Position playerPixel = playerPos.toPixels();
     Position tipPixel = tipPos.toPixels();
@@ -4,9 +4,22 @@
 #include "GameThing.h"
 #include "Interfaces.h"
 #include <raylib-cpp.hpp>
+#include <cstdint>
 
 class Player; // Forward declaration
+class TerrainGrid;
 
+/**
+ * @brief A harpoon on a tether, anchored at the tile of the player who fired it
+ *
+ * The owner is kept as a handle (an index into ProjectilePool's owner
+ * table) together with the owner's tile as of the last follow(), so a
+ * harpoon holds no pointer to its player and getSavedState() is plain data.
+ * A harpoon does not track its player by itself: it only moves with them
+ * when follow() is called, which ProjectilePool::update does before each
+ * update(). Code that updates a harpoon outside the pool has to call
+ * follow() first, or the tether stays where the player was.
+ */
 class Projectile : public GameThing, public CanMove, public CanCollide {
 public:
     enum Direction { UP, DOWN, LEFT, RIGHT };
@@ -15,15 +28,64 @@ public:
 private:
     Direction direction;
     HarpoonState state;
-    Player* ownerPlayer;  // Reference to the player who fired this
+    uint32_t owner;          // handle of the player who fired this
+    Position ownerPosition;  // owner's tile, refreshed by follow()
     Position relativeOffset; // Offset from player's current position
     int maxRange;
     int currentLength;
     float moveTimer;
     bool hitSomething;
+    const TerrainGrid* terrain;  // world bounds, taken from the owner
     
 public:
-    Projectile(Player* player, Direction dir, int range = 8);
+    /**
+     * @brief Plain-data copy of a harpoon, for GameSnapshot
+     */
+    struct SavedState {
+        Position location;
+        Position previousLocation;
+        bool isActive;
+        Direction direction;
+        HarpoonState state;
+        uint32_t owner;
+        Position ownerPosition;
+        Position relativeOffset;
+        int maxRange;
+        int currentLength;
+        float moveTimer;
+        bool hitSomething;
+        
+        /**
+         * @brief False if direction or state holds a value no harpoon ever has (a damaged snapshot)
+         */
+        bool isValid() const;
+    };
+    
+    /**
+     * @brief Fire a harpoon from a player's current tile
+     * @param player Player who fired it; only read here, not kept
+     * @param dir Direction of travel
+     * @param range Maximum length in tiles
+     * @param ownerHandle Handle the player is known by (see ProjectilePool::addOwner)
+     */
+    Projectile(const Player* player, Direction dir, int range = 8, uint32_t ownerHandle = 0);
+    
+    /**
+     * @brief Rebuild a harpoon from a saved state
+     * @param saved State returned by getSavedState
+     * @param world Terrain the owner is in
+     */
+    Projectile(const SavedState& saved, const TerrainGrid* world);
+    
+    SavedState getSavedState() const;
+    uint32_t getOwner() const { return owner; }
+    
+    /**
+     * @brief Move with the owner; call before update() whenever the owner may have moved
+     * @param ownerPos Owner's current tile
+     */
+    void follow(const Position& ownerPos);
+    
     Direction getDirection() const { return direction; }
     HarpoonState getState() const { return state; }
     bool isFinished() const { return state == FINISHED; }
@@ -39,6 +101,9 @@ public:
     raylib::Rectangle getBounds() const override;
     void onCollision(const CanCollide& other) override;
     
+    /**
+     * @brief Extend or retract the tether; the anchor is the tile given to the last follow()
+     */
     void update(float deltaTime) override;
     void draw() const override;
     
@@ -48,8 +113,8 @@ public:
 private:
     void extendHarpoon();
     void retractHarpoon();
-    Position getPlayerPosition() const;
     Position getTipPosition() const;
+    bool isInsideWorld(const Position& pos) const;
 };
 
 #endif // PROJECTILE_H
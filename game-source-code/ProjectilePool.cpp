@@ -0,0 +1,172 @@
+#include "ProjectilePool.h"
+#include "Player.h"
+#include <algorithm>
+
+ProjectilePool::ProjectilePool(int slotCount) {
+    int count = std::max(1, slotCount);
+    slots.resize(count);
+    freeSlots.reserve(count);
+    activeSlots.reserve(count);
+    
+    // Lowest slot on top of the stack so the first shots use the first slots
+    for (int i = count - 1; i >= 0; i--) {
+        freeSlots.push_back((uint32_t)i);
+    }
+}
+
+uint32_t ProjectilePool::addOwner(Player* player) {
+    auto it = std::find(owners.begin(), owners.end(), player);
+    if (it != owners.end()) {
+        return (uint32_t)(it - owners.begin());
+    }
+    owners.push_back(player);
+    return (uint32_t)owners.size() - 1;
+}
+
+ProjectileHandle ProjectilePool::spawn(Player* player, Projectile::Direction dir, int range) {
+    ProjectileHandle handle;
+    if (freeSlots.empty()) {
+        return handle;
+    }
+    
+    uint32_t owner = addOwner(player);
+    uint32_t index = freeSlots.back();
+    freeSlots.pop_back();
+    
+    Slot& slot = slots[index];
+    slot.projectile.emplace(player, dir, range, owner);
+    activeSlots.push_back(index);
+    
+    handle.index = index;
+    handle.generation = slot.generation;
+    return handle;
+}
+
+Projectile* ProjectilePool::get(ProjectileHandle handle) {
+    if (handle.index >= slots.size()) {
+        return nullptr;
+    }
+    Slot& slot = slots[handle.index];
+    if (slot.generation != handle.generation || !slot.projectile) {
+        return nullptr;
+    }
+    return &*slot.projectile;
+}
+
+const Projectile* ProjectilePool::get(ProjectileHandle handle) const {
+    return const_cast<ProjectilePool*>(this)->get(handle);
+}
+
+bool ProjectilePool::release(ProjectileHandle handle) {
+    if (!get(handle)) {
+        return false;
+    }
+    
+    auto it = std::find(activeSlots.begin(), activeSlots.end(), handle.index);
+    releaseAt((int)(it - activeSlots.begin()));
+    return true;
+}
+
+void ProjectilePool::releaseAt(int activeIndex) {
+    uint32_t index = activeSlots[activeIndex];
+    Slot& slot = slots[index];
+    slot.projectile.reset();
+    slot.generation++;
+    freeSlots.push_back(index);
+    
+    // Keep firing order; the active list is short and never reallocates
+    activeSlots.erase(activeSlots.begin() + activeIndex);
+}
+
+int ProjectilePool::retireFinished() {
+    int retired = 0;
+    for (int i = size() - 1; i >= 0; i--) {
+        if (at(i).isFinished()) {
+            releaseAt(i);
+            retired++;
+        }
+    }
+    return retired;
+}
+
+void ProjectilePool::update(float deltaTime) {
+    for (auto& projectile : *this) {
+        projectile.follow(owners[projectile.getOwner()]->getPosition());
+        projectile.update(deltaTime);
+    }
+}
+
+void ProjectilePool::clear() {
+    while (!activeSlots.empty()) {
+        releaseAt(size() - 1);
+    }
+}
+
+ProjectileHandle ProjectilePool::handleAt(int activeIndex) const {
+    ProjectileHandle handle;
+    handle.index = activeSlots[activeIndex];
+    handle.generation = slots[handle.index].generation;
+    return handle;
+}
+
+void ProjectilePool::saveState(GameSnapshot& out) const {
+    out.write((uint32_t)slots.size());
+    for (const Slot& slot : slots) {
+        out.write(slot.generation);
+        out.write((uint8_t)(slot.projectile ? 1 : 0));
+        if (slot.projectile) {
+            out.write(slot.projectile->getSavedState());
+        }
+    }
+    out.writeVector(freeSlots);
+    out.writeVector(activeSlots);
+}
+
+void ProjectilePool::swapState(ProjectilePool& other) {
+    slots.swap(other.slots);
+    freeSlots.swap(other.freeSlots);
+    activeSlots.swap(other.activeSlots);
+}
+
+bool ProjectilePool::restoreState(GameSnapshot::Reader& in) {
+    uint32_t slotCount = 0;
+    if (!in.read(slotCount) || slotCount != slots.size()) {
+        return false;
+    }
+    
+    for (Slot& slot : slots) {
+        uint8_t occupied = 0;
+        if (!in.read(slot.generation) || !in.read(occupied)) {
+            return false;
+        }
+        slot.projectile.reset();
+        if (occupied) {
+            Projectile::SavedState saved;
+            if (!in.read(saved) || !saved.isValid() || saved.owner >= owners.size()) {
+                return false;
+            }
+            slot.projectile.emplace(saved, owners[saved.owner]->getTerrain());
+        }
+    }
+    
+    // A corrupt list would hand out an occupied slot or read an empty one, and
+    // an index listed twice would hand the same slot out twice
+    if (!in.readVector(freeSlots) || !in.readVector(activeSlots) ||
+        freeSlots.size() + activeSlots.size() != slots.size()) {
+        return false;
+    }
+    std::vector<uint8_t> seen(slots.size(), 0);
+    for (uint32_t index : freeSlots) {
+        if (index >= slots.size() || seen[index] || slots[index].projectile) {
+            return false;
+        }
+        seen[index] = 1;
+    }
+    for (uint32_t index : activeSlots) {
+        if (index >= slots.size() || seen[index] || !slots[index].projectile) {
+            return false;
+        }
+        seen[index] = 1;
+    }
+    return true;
+}
@@ -0,0 +1,161 @@
+#ifndef PROJECTILEPOOL_H
+#define PROJECTILEPOOL_H
+
+#include "GameSnapshot.h"
+#include "Projectile.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Stable reference to a pooled projectile
+ *
+ * The generation changes every time a slot is reused, so a handle to a
+ * harpoon that has since been retired no longer resolves.
+ */
+struct ProjectileHandle {
+    static const uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+    
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+    
+    bool isValid() const { return index != INVALID_INDEX; }
+    bool operator==(const ProjectileHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+};
+
+/**
+ * @brief Fixed-capacity storage for harpoons with free-list reuse
+ *
+ * All slots are allocated up front, so firing and retiring a harpoon never
+ * touches the heap. Active projectiles are kept in firing order and can be
+ * iterated with a range-based for loop.
+ *
+ * Harpoons refer to the player who fired them by owner handle, an index
+ * into the pool's owner table; update() moves each one with its owner.
+ */
+class ProjectilePool {
+public:
+    static const int DEFAULT_CAPACITY = 32;
+
+private:
+    struct Slot {
+        std::optional<Projectile> projectile;
+        uint32_t generation = 0;
+    };
+    
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;    // used as a stack
+    std::vector<uint32_t> activeSlots;  // firing order
+    std::vector<Player*> owners;        // indexed by owner handle
+
+public:
+    template <typename PoolType, typename ValueType>
+    class ActiveIterator {
+    private:
+        PoolType* pool;
+        int position;
+    
+    public:
+        ActiveIterator(PoolType* owner, int start) : pool(owner), position(start) {}
+        ValueType& operator*() const { return pool->at(position); }
+        ValueType* operator->() const { return &pool->at(position); }
+        ActiveIterator& operator++() { position++; return *this; }
+        bool operator!=(const ActiveIterator& other) const { return position != other.position; }
+    };
+    
+    using iterator = ActiveIterator<ProjectilePool, Projectile>;
+    using const_iterator = ActiveIterator<const ProjectilePool, const Projectile>;
+    
+    /**
+     * @brief Allocate every slot up front
+     * @param slotCount Most harpoons that can be in flight at once
+     */
+    explicit ProjectilePool(int slotCount = DEFAULT_CAPACITY);
+    
+    /**
+     * @brief Give a player an owner handle; a player that already has one keeps it
+     * @param player Player that may fire harpoons, must outlive the pool
+     * @return Owner handle stored in that player's harpoons
+     */
+    uint32_t addOwner(Player* player);
+    
+    /**
+     * @brief Construct a harpoon in a free slot
+     * @param player Player who fired it (given an owner handle if it has none)
+     * @param dir Direction of travel
+     * @param range Maximum length in tiles
+     * @return Handle to the new harpoon, invalid if the pool is full
+     */
+    ProjectileHandle spawn(Player* player, Projectile::Direction dir, int range);
+    
+    /**
+     * @brief Look up a harpoon by handle
+     * @param handle Handle returned by spawn
+     * @return The harpoon, or nullptr if it has been retired
+     */
+    Projectile* get(ProjectileHandle handle);
+    const Projectile* get(ProjectileHandle handle) const;
+    
+    /**
+     * @brief Retire a harpoon and return its slot to the free list
+     * @param handle Handle returned by spawn
+     * @return False if the handle was already stale
+     */
+    bool release(ProjectileHandle handle);
+    
+    /**
+     * @brief Retire the harpoon at a position in the active list
+     * @param activeIndex Index in [0, size())
+     */
+    void releaseAt(int activeIndex);
+    
+    /**
+     * @brief Retire every harpoon that has finished retracting
+     * @return Number of harpoons retired
+     */
+    int retireFinished();
+    
+    /**
+     * @brief Move every harpoon with its owner, then advance it one tick
+     * @param deltaTime Tick length in seconds
+     */
+    void update(float deltaTime);
+    
+    void clear();
+    
+    /**
+     * @brief Append every slot, the free list and the firing order to a snapshot
+     */
+    void saveState(GameSnapshot& out) const;
+    
+    /**
+     * @brief Read back what saveState wrote; owner handles resolve against this pool's owners
+     * @return False if the data doesn't fit this pool's capacity or owners
+     */
+    bool restoreState(GameSnapshot::Reader& in);
+    
+    /**
+     * @brief Exchange every slot and both lists with another pool
+     *
+     * Owners stay put, so both pools must know the same players by the same handles.
+     * @param other Pool to swap with
+     */
+    void swapState(ProjectilePool& other);
+    
+    int size() const { return (int)activeSlots.size(); }
+    int capacity() const { return (int)slots.size(); }
+    bool isFull() const { return freeSlots.empty(); }
+    
+    Projectile& at(int activeIndex) { return *slots[activeSlots[activeIndex]].projectile; }
+    const Projectile& at(int activeIndex) const { return *slots[activeSlots[activeIndex]].projectile; }
+    ProjectileHandle handleAt(int activeIndex) const;
+    
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+};
+
+#endif // PROJECTILEPOOL_H
@@ -0,0 +1,42 @@
+#include "Random.h"
+
+Random::Random(uint64_t seed, uint64_t stream) : state(0), increment(1) {
+    reseed(seed, stream);
+}
+
+void Random::reseed(uint64_t seed, uint64_t stream) {
+    // Standard PCG32 initialisation; the increment must be odd
+    state = 0;
+    increment = (stream << 1) | 1u;
+    next();
+    state += seed;
+    next();
+}
+
+uint32_t Random::next() {
+    uint64_t oldState = state;
+    state = oldState * 6364136223846793005ULL + increment;
+    uint32_t xorShifted = (uint32_t)(((oldState >> 18) ^ oldState) >> 27);
+    uint32_t rotation = (uint32_t)(oldState >> 59);
+    return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+}
+
+int Random::nextInt(int bound) {
+    if (bound <= 0) {
+        return 0;
+    }
+    
+    // Reject the top sliver of values so every result is equally likely
+    uint32_t range = (uint32_t)bound;
+    uint32_t threshold = (0u - range) % range;
+    while (true) {
+        uint32_t value = next();
+        if (value >= threshold) {
+            return (int)(value % range);
+        }
+    }
+}
+
+float Random::nextFloat() {
+    return (next() >> 8) * (1.0f / 16777216.0f);
+}
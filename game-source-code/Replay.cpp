@@ -0,0 +1,165 @@
+#include "Replay.h"
+#include "Logger.h"
+#include <cstring>
+#include <fstream>
+
+namespace {
+    const char MAGIC[4] = {'D', 'D', 'R', 'P'};
+    const size_t HEADER_SIZE = 4 + 2 + 2 + 8 + 4 + 8;
+    
+    template <typename T>
+    void writeValue(std::vector<uint8_t>& out, T value) {
+        for (size_t i = 0; i < sizeof(T); i++) {
+            out.push_back((uint8_t)(value >> (8 * i)));
+        }
+    }
+    
+    template <typename T>
+    T readValue(const std::vector<uint8_t>& in, size_t offset) {
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            value |= (T)in[offset + i] << (8 * i);
+        }
+        return value;
+    }
+}
+
+Replay::Replay() : seed(0), tickRate(60.0f), tickCount(0) {
+}
+
+void Replay::writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+bool Replay::readVarint(const std::vector<uint8_t>& in, size_t& offset, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && offset < in.size(); shift += 7) {
+        uint8_t byte = in[offset++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Replay::save(const std::string& filename) const {
+    std::vector<uint8_t> data;
+    data.reserve(HEADER_SIZE + runs.size());
+    data.insert(data.end(), MAGIC, MAGIC + 4);
+    writeValue<uint16_t>(data, VERSION);
+    writeValue<uint16_t>(data, 0);
+    writeValue<uint64_t>(data, seed);
+    uint32_t rateBits;
+    std::memcpy(&rateBits, &tickRate, sizeof(rateBits));
+    writeValue<uint32_t>(data, rateBits);
+    writeValue<uint64_t>(data, tickCount);
+    data.insert(data.end(), runs.begin(), runs.end());
+    
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        GAME_LOG_WARNING("Could not create replay file: %s", filename.c_str());
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+    return (bool)file;
+}
+
+bool Replay::load(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        GAME_LOG_WARNING("Could not open replay file: %s", filename.c_str());
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    if (data.size() < HEADER_SIZE || std::memcmp(data.data(), MAGIC, 4) != 0) {
+        GAME_LOG_WARNING("Not a replay file: %s", filename.c_str());
+        return false;
+    }
+    if (readValue<uint16_t>(data, 4) != VERSION) {
+        GAME_LOG_WARNING("Unsupported replay version %d in %s", readValue<uint16_t>(data, 4), filename.c_str());
+        return false;
+    }
+    
+    seed = readValue<uint64_t>(data, 8);
+    uint32_t rateBits = readValue<uint32_t>(data, 16);
+    std::memcpy(&tickRate, &rateBits, sizeof(tickRate));
+    tickCount = readValue<uint64_t>(data, 20);
+    runs.assign(data.begin() + HEADER_SIZE, data.end());
+    return true;
+}
+
+ReplayRecorder::ReplayRecorder(InputProvider* inputSource, uint64_t seed, float tickRate)
+    : source(inputSource), previousMask(0), currentMask(0), currentRun(0) {
+    replay.seed = seed;
+    replay.tickRate = tickRate;
+}
+
+InputState ReplayRecorder::poll() {
+    InputState state = source->poll();
+    uint32_t mask = state.toMask();
+    
+    // Extend the current run, or close it and start a new one
+    if (currentRun > 0 && mask != currentMask) {
+        Replay::writeVarint(replay.runs, currentMask ^ previousMask);
+        Replay::writeVarint(replay.runs, currentRun);
+        previousMask = currentMask;
+        currentRun = 0;
+    }
+    currentMask = mask;
+    currentRun++;
+    replay.tickCount++;
+    return state;
+}
+
+Replay ReplayRecorder::finished() const {
+    Replay result = replay;
+    if (currentRun > 0) {
+        Replay::writeVarint(result.runs, currentMask ^ previousMask);
+        Replay::writeVarint(result.runs, currentRun);
+    }
+    return result;
+}
+
+bool ReplayRecorder::save(const std::string& filename) const {
+    return finished().save(filename);
+}
+
+ReplayInput::ReplayInput()
+    : offset(0), mask(0), runRemaining(0), ticksPlayed(0), corrupt(false) {
+}
+
+bool ReplayInput::load(const std::string& filename) {
+    offset = 0;
+    mask = 0;
+    runRemaining = 0;
+    ticksPlayed = 0;
+    corrupt = false;
+    return replay.load(filename);
+}
+
+InputState ReplayInput::poll() {
+    if (isFinished()) {
+        return InputState();
+    }
+    
+    if (runRemaining == 0) {
+        uint64_t delta = 0;
+        if (!Replay::readVarint(replay.runs, offset, delta) ||
+            !Replay::readVarint(replay.runs, offset, runRemaining) || runRemaining == 0) {
+            GAME_LOG_ERROR("Replay data ends early at tick %llu", (unsigned long long)ticksPlayed);
+            corrupt = true;
+            return InputState();
+        }
+        mask ^= (uint32_t)delta;
+    }
+    
+    runRemaining--;
+    ticksPlayed++;
+    return InputState::fromMask(mask);
+}
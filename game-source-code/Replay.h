@@ -0,0 +1,109 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "InputProvider.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Binary replay file: a seed plus the input of every simulation tick
+ *
+ * Layout (little endian):
+ *   "DDRP"  magic
+ *   u16     format version
+ *   u16     reserved (0)
+ *   u64     seed
+ *   f32     tick rate in Hz
+ *   u64     tick count
+ *   runs    until the tick count is covered: varint (mask XOR previous mask),
+ *           varint run length in ticks
+ *
+ * Input only changes when a key goes up or down, so a whole session is a
+ * short list of runs; half an hour of play is typically a few KB.
+ */
+class Replay {
+public:
+    static const uint16_t VERSION = 1;
+    
+    uint64_t seed;
+    float tickRate;
+    uint64_t tickCount;
+    std::vector<uint8_t> runs;  // encoded run data following the header
+    
+    Replay();
+    
+    bool save(const std::string& filename) const;
+    bool load(const std::string& filename);
+    
+    static void writeVarint(std::vector<uint8_t>& out, uint64_t value);
+    static bool readVarint(const std::vector<uint8_t>& in, size_t& offset, uint64_t& value);
+};
+
+/**
+ * @brief Input provider that passes another source through and records it
+ */
+class ReplayRecorder : public InputProvider {
+private:
+    InputProvider* source;
+    Replay replay;
+    uint32_t previousMask;  // mask of the last finished run
+    uint32_t currentMask;
+    uint64_t currentRun;
+
+public:
+    /**
+     * @brief Record everything a source produces
+     * @param inputSource Provider the game would otherwise use directly
+     * @param seed Seed the game was started with
+     * @param tickRate Simulation tick rate in Hz
+     */
+    ReplayRecorder(InputProvider* inputSource, uint64_t seed, float tickRate);
+    
+    void beginFrame() override { source->beginFrame(); }
+    InputState poll() override;
+    
+    /**
+     * @brief Write everything recorded so far
+     * @param filename Replay file to create
+     * @return True on success
+     */
+    bool save(const std::string& filename) const;
+    
+    uint64_t getTickCount() const { return replay.tickCount; }
+
+private:
+    Replay finished() const;
+};
+
+/**
+ * @brief Input provider that plays a replay file back tick by tick
+ */
+class ReplayInput : public InputProvider {
+private:
+    Replay replay;
+    size_t offset;
+    uint32_t mask;
+    uint64_t runRemaining;
+    uint64_t ticksPlayed;
+    bool corrupt;
+
+public:
+    ReplayInput();
+    
+    /**
+     * @brief Load a replay and rewind to its first tick
+     * @param filename Replay file to read
+     * @return False if the file is missing or not a replay
+     */
+    bool load(const std::string& filename);
+    
+    InputState poll() override;
+    
+    bool isFinished() const { return ticksPlayed >= replay.tickCount || corrupt; }
+    uint64_t getSeed() const { return replay.seed; }
+    float getTickRate() const { return replay.tickRate; }
+    uint64_t getTickCount() const { return replay.tickCount; }
+};
+
+#endif // REPLAY_H
@@ -0,0 +1,80 @@
+#include "ResourceCooker.h"
+#include "ResourcePack.h"
+#include "SpriteManager.h"
+#include "TerrainGrid.h"
+#include "Logger.h"
+#include <cstring>
+#include <fstream>
+
+namespace {
+    bool cookAtlas(ResourcePack::Item& item) {
+        std::vector<Image> images = SpriteManager::loadSpriteImages();
+        std::array<raylib::Rectangle, SpriteManager::SPRITE_COUNT> rects;
+        Image packed = SpriteManager::packAtlasImage(images, rects);
+        for (auto& image : images) {
+            if (IsImageValid(image)) UnloadImage(image);
+        }
+        if (!IsImageValid(packed)) {
+            return false;
+        }
+        ImageFormat(&packed, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        
+        ResourcePack::AtlasHeader header = { packed.width, packed.height, SpriteManager::SPRITE_COUNT, 0 };
+        std::vector<ResourcePack::SpriteRect> cookedRects;
+        for (const auto& rect : rects) {
+            cookedRects.push_back({ (int32_t)rect.x, (int32_t)rect.y, (int32_t)rect.width, (int32_t)rect.height });
+        }
+        size_t rectBytes = cookedRects.size() * sizeof(ResourcePack::SpriteRect);
+        size_t pixelBytes = (size_t)packed.width * packed.height * 4;
+        
+        item.name = "sprites/atlas";
+        item.kind = ResourcePack::ENTRY_ATLAS;
+        item.data.resize(sizeof(header) + rectBytes + pixelBytes);
+        std::memcpy(item.data.data(), &header, sizeof(header));
+        std::memcpy(item.data.data() + sizeof(header), cookedRects.data(), rectBytes);
+        std::memcpy(item.data.data() + sizeof(header) + rectBytes, packed.data, pixelBytes);
+        UnloadImage(packed);
+        return true;
+    }
+}
+
+bool ResourceCooker::cook(const std::string& outputFile) {
+    std::vector<ResourcePack::Item> items;
+    
+    for (int level = 1; level <= MAX_LEVELS; level++) {
+        std::string name = "level" + std::to_string(level);
+        std::string filename = "resources/" + name + ".txt";
+        if (!std::ifstream(filename).is_open()) {
+            break;
+        }
+        
+        TerrainGrid terrain(TerrainGrid::DEFAULT_WIDTH, TerrainGrid::DEFAULT_HEIGHT);
+        if (!terrain.loadFromFile(filename)) {
+            GAME_LOG_ERROR("Could not cook %s", filename.c_str());
+            return false;
+        }
+        ResourcePack::Item item = { name, ResourcePack::ENTRY_LEVEL, {} };
+        terrain.writeBinary(item.data);
+        items.push_back(std::move(item));
+    }
+    if (items.empty()) {
+        GAME_LOG_ERROR("No levels found under resources/, nothing to cook");
+        return false;
+    }
+    int levelCount = (int)items.size();
+    
+    ResourcePack::Item atlas;
+    bool hasAtlas = cookAtlas(atlas);
+    if (hasAtlas) {
+        items.push_back(std::move(atlas));
+    } else {
+        GAME_LOG_WARNING("No sprites found, the pack has no atlas");
+    }
+    
+    if (!ResourcePack::write(outputFile, items)) {
+        return false;
+    }
+    GAME_LOG_INFO("Cooked %d levels%s into %s", levelCount, hasAtlas ? " and the sprite atlas" : "",
+                  outputFile.c_str());
+    return true;
+}
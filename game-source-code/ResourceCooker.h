@@ -0,0 +1,27 @@
+#ifndef RESOURCECOOKER_H
+#define RESOURCECOOKER_H
+
+#include <string>
+
+/**
+ * @brief Builds the resource pack the game maps at startup
+ *
+ * Decodes and atlases every sprite PNG and parses every resources/levelN.txt,
+ * then writes the results as one ResourcePack. Run from the directory the
+ * game runs in (game --cook-resources resources/resources.pack), and again
+ * whenever a sprite or level changes: an open pack takes precedence over the
+ * loose files.
+ */
+class ResourceCooker {
+public:
+    static const int MAX_LEVELS = 99;  // levels are cooked from level1 until the first missing file
+    
+    /**
+     * @brief Cook everything under resources/ into a pack
+     * @param outputFile Pack file to create
+     * @return False if no level could be cooked or the pack could not be written
+     */
+    static bool cook(const std::string& outputFile);
+};
+
+#endif // RESOURCECOOKER_H
@@ -0,0 +1,132 @@
+#include "ResourcePack.h"
+#include "Logger.h"
+#include <cstring>
+#include <fstream>
+
+namespace {
+    const char MAGIC[4] = {'D', 'D', 'P', 'K'};
+    
+    uint64_t alignUp(uint64_t value) {
+        return (value + ResourcePack::ALIGNMENT - 1) / ResourcePack::ALIGNMENT * ResourcePack::ALIGNMENT;
+    }
+}
+
+ResourcePack::ResourcePack() : header(nullptr), entries(nullptr) {
+}
+
+ResourcePack* ResourcePack::getInstance() {
+    static ResourcePack instance;
+    return &instance;
+}
+
+bool ResourcePack::open(const std::string& filename) {
+    close();
+    
+    if (!file.open(filename)) {
+        GAME_LOG_DEBUG("No resource pack at %s", filename.c_str());
+        return false;
+    }
+    
+    const uint8_t* data = file.getData();
+    size_t size = file.getSize();
+    const Header* candidate = reinterpret_cast<const Header*>(data);
+    
+    if (size < sizeof(Header) || std::memcmp(candidate->magic, MAGIC, 4) != 0) {
+        GAME_LOG_WARNING("%s is not a resource pack", filename.c_str());
+        file.close();
+        return false;
+    }
+    if (candidate->version != VERSION) {
+        GAME_LOG_WARNING("Resource pack %s has version %d, expected %d; re-cook it",
+                         filename.c_str(), (int)candidate->version, (int)VERSION);
+        file.close();
+        return false;
+    }
+    
+    uint64_t indexEnd = sizeof(Header) + (uint64_t)candidate->entryCount * sizeof(Entry);
+    if (candidate->fileSize != size || indexEnd > size) {
+        GAME_LOG_WARNING("Resource pack %s is truncated", filename.c_str());
+        file.close();
+        return false;
+    }
+    
+    const Entry* index = reinterpret_cast<const Entry*>(data + sizeof(Header));
+    for (uint32_t i = 0; i < candidate->entryCount; i++) {
+        const Entry& entry = index[i];
+        if (entry.name[NAME_LENGTH - 1] != '\0' || entry.offset % ALIGNMENT != 0 ||
+            entry.offset < indexEnd || entry.offset > size || entry.size > size - entry.offset) {
+            GAME_LOG_WARNING("Resource pack %s has a corrupt index entry %u", filename.c_str(), i);
+            file.close();
+            return false;
+        }
+    }
+    
+    header = candidate;
+    entries = index;
+    GAME_LOG_INFO("Resource pack %s: %u entries, %llu bytes", filename.c_str(), header->entryCount,
+                  (unsigned long long)size);
+    return true;
+}
+
+void ResourcePack::close() {
+    header = nullptr;
+    entries = nullptr;
+    file.close();
+}
+
+const ResourcePack::Entry* ResourcePack::find(const std::string& name, uint32_t kind) const {
+    if (!header) {
+        return nullptr;
+    }
+    // A handful of entries: a linear scan beats anything cleverer
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        if (entries[i].kind == kind && name == entries[i].name) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+bool ResourcePack::write(const std::string& filename, const std::vector<Item>& items) {
+    std::vector<Entry> index(items.size());
+    uint64_t offset = alignUp(sizeof(Header) + items.size() * sizeof(Entry));
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i].name.size() >= (size_t)NAME_LENGTH) {
+            GAME_LOG_ERROR("Resource name too long for a pack: %s", items[i].name.c_str());
+            return false;
+        }
+        Entry& entry = index[i];
+        std::memset(&entry, 0, sizeof(entry));
+        std::memcpy(entry.name, items[i].name.c_str(), items[i].name.size());
+        entry.kind = items[i].kind;
+        entry.offset = offset;
+        entry.size = items[i].data.size();
+        offset = alignUp(offset + entry.size);
+    }
+    
+    Header packHeader;
+    std::memset(&packHeader, 0, sizeof(packHeader));
+    std::memcpy(packHeader.magic, MAGIC, 4);
+    packHeader.version = VERSION;
+    packHeader.entryCount = (uint32_t)items.size();
+    packHeader.fileSize = offset;
+    
+    std::vector<uint8_t> data(offset, 0);
+    std::memcpy(data.data(), &packHeader, sizeof(packHeader));
+    if (!index.empty()) {
+        std::memcpy(data.data() + sizeof(Header), index.data(), index.size() * sizeof(Entry));
+    }
+    for (size_t i = 0; i < items.size(); i++) {
+        if (!items[i].data.empty()) {
+            std::memcpy(data.data() + index[i].offset, items[i].data.data(), items[i].data.size());
+        }
+    }
+    
+    std::ofstream output(filename, std::ios::binary);
+    if (!output.is_open()) {
+        GAME_LOG_ERROR("Could not write resource pack %s", filename.c_str());
+        return false;
+    }
+    output.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+    return output.good();
+}
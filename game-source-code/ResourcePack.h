@@ -0,0 +1,124 @@
+#ifndef RESOURCEPACK_H
+#define RESOURCEPACK_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Cooked game resources in one memory-mapped file
+ *
+ * Layout (little endian, every entry's data starts on an ALIGNMENT boundary):
+ *   Header   "DDPK" magic, u16 format version, u16 reserved, u32 entry count,
+ *            u32 reserved, u64 file size
+ *   Entry[]  index: zero-padded name, u32 kind, u32 reserved, u64 offset, u64 size
+ *   data     entry payloads, see AtlasHeader and LevelFile
+ *
+ * Payloads are already in the form the game uses (decoded RGBA pixels, parsed
+ * levels), so loading from a pack is a lookup and a pointer into the mapping.
+ * Packs are written by ResourceCooker (game --cook-resources FILE).
+ */
+class ResourcePack {
+public:
+    static const uint16_t VERSION = 2;
+    static const int NAME_LENGTH = 48;
+    static const int ALIGNMENT = 16;
+    static constexpr const char* DEFAULT_FILENAME = "resources/resources.pack";
+    
+    enum EntryKind {
+        ENTRY_ATLAS = 1,  // sprite atlas: AtlasHeader, SpriteRect[spriteCount], RGBA8 pixels
+        ENTRY_LEVEL = 2   // level in the binary level format (LevelFile)
+    };
+    
+    struct Header {
+        char magic[4];
+        uint16_t version;
+        uint16_t reserved;
+        uint32_t entryCount;
+        uint32_t reserved2;
+        uint64_t fileSize;
+    };
+    
+    struct Entry {
+        char name[NAME_LENGTH];  // zero padded, always zero terminated
+        uint32_t kind;
+        uint32_t reserved;
+        uint64_t offset;         // from the start of the file
+        uint64_t size;
+    };
+    
+    struct AtlasHeader {
+        int32_t width;
+        int32_t height;
+        int32_t spriteCount;     // SpriteManager::SPRITE_COUNT when cooked
+        int32_t reserved;
+    };
+    
+    struct SpriteRect {
+        int32_t x;
+        int32_t y;
+        int32_t width;           // 0 = sprite missing when the pack was cooked
+        int32_t height;
+    };
+    
+    /**
+     * @brief One entry to write with ResourcePack::write
+     */
+    struct Item {
+        std::string name;
+        uint32_t kind;
+        std::vector<uint8_t> data;
+    };
+
+private:
+    MappedFile file;
+    const Header* header;
+    const Entry* entries;
+
+public:
+    ResourcePack();
+    
+    ResourcePack(const ResourcePack&) = delete;
+    ResourcePack& operator=(const ResourcePack&) = delete;
+    
+    /**
+     * @brief The pack the game loads from; stays closed unless main opens one
+     */
+    static ResourcePack* getInstance();
+    
+    /**
+     * @brief Map a pack and check its header and index
+     * @param filename Pack file
+     * @return False if the file is missing, not a pack, from another version or truncated
+     */
+    bool open(const std::string& filename);
+    
+    void close();
+    
+    bool isOpen() const { return header != nullptr; }
+    int getEntryCount() const { return header ? (int)header->entryCount : 0; }
+    
+    /**
+     * @brief Look an entry up by name
+     * @param name Entry name, e.g. "level1" or "sprites/atlas"
+     * @param kind Expected EntryKind
+     * @return The entry, or nullptr if the pack has no such entry of that kind
+     */
+    const Entry* find(const std::string& name, uint32_t kind) const;
+    
+    /**
+     * @brief Entry payload, pointing into the mapping
+     */
+    const uint8_t* getData(const Entry& entry) const { return file.getData() + entry.offset; }
+    
+    /**
+     * @brief Write a pack file
+     * @param filename File to create
+     * @param items Entries in index order
+     * @return False if a name is too long or the file could not be written
+     */
+    static bool write(const std::string& filename, const std::vector<Item>& items);
+};
+
+#endif // RESOURCEPACK_H
@@ -0,0 +1,148 @@
+#include "SpatialIndex.h"
+
+SpatialIndex::SpatialIndex() : width(0), height(0) {
+}
+
+void SpatialIndex::reset(int gridWidth, int gridHeight) {
+    width = gridWidth;
+    height = gridHeight;
+    heads.assign((size_t)width * height, NONE);
+    entries.clear();
+}
+
+int SpatialIndex::cellOf(const Position& pos) const {
+    if (pos.x < 0 || pos.x >= width || pos.y < 0 || pos.y >= height) {
+        return NONE;
+    }
+    return pos.y * width + pos.x;
+}
+
+void SpatialIndex::link(int id, int cell) {
+    Entry& entry = entries[id];
+    entry.cell = cell;
+    entry.prev = NONE;
+    entry.next = NONE;
+    if (cell == NONE) {
+        return;
+    }
+    
+    entry.next = heads[cell];
+    if (entry.next != NONE) {
+        entries[entry.next].prev = id;
+    }
+    heads[cell] = id;
+}
+
+void SpatialIndex::unlink(int id) {
+    Entry& entry = entries[id];
+    if (entry.cell == NONE) {
+        return;
+    }
+    
+    if (entry.prev != NONE) {
+        entries[entry.prev].next = entry.next;
+    } else {
+        heads[entry.cell] = entry.next;
+    }
+    if (entry.next != NONE) {
+        entries[entry.next].prev = entry.prev;
+    }
+    entry.cell = NONE;
+}
+
+int SpatialIndex::insert(const Position& pos) {
+    int id = (int)entries.size();
+    entries.push_back(Entry{NONE, NONE, NONE});
+    link(id, cellOf(pos));
+    return id;
+}
+
+void SpatialIndex::update(int id, const Position& pos) {
+    int cell = cellOf(pos);
+    if (entries[id].cell != cell) {
+        unlink(id);
+        link(id, cell);
+    }
+}
+
+void SpatialIndex::removeSwapLast(int id) {
+    int last = (int)entries.size() - 1;
+    unlink(id);
+    
+    if (id != last) {
+        int lastCell = entries[last].cell;
+        unlink(last);
+        link(id, lastCell);
+    }
+    entries.pop_back();
+}
+
+int SpatialIndex::firstAt(const Position& pos) const {
+    int cell = cellOf(pos);
+    return cell == NONE ? NONE : heads[cell];
+}
+
+void SpatialIndex::saveState(GameSnapshot& out) const {
+    out.write((int32_t)width);
+    out.write((int32_t)height);
+    out.writeVector(heads);
+    out.writeVector(entries);
+}
+
+bool SpatialIndex::restoreState(GameSnapshot::Reader& in, int gridWidth, int gridHeight, int entityCount) {
+    int32_t savedWidth = 0;
+    int32_t savedHeight = 0;
+    if (!in.read(savedWidth) || !in.read(savedHeight) || !in.readVector(heads) || !in.readVector(entries)) {
+        return false;
+    }
+    width = savedWidth;
+    height = savedHeight;
+    if (width != gridWidth || height != gridHeight || heads.size() != (size_t)width * height ||
+        entries.size() != (size_t)entityCount) {
+        return false;
+    }
+    
+    // Every link has to stay inside the arrays, or a lookup reads past them.
+    // The heads cover the whole grid: NONE (-1) maps to 0 and ids to
+    // 1..entityCount, so one unsigned compare checks both and the loop vectorizes
+    const int cellCount = (int)heads.size();
+    int outside = 0;
+    int headCount = 0;
+    for (int head : heads) {
+        outside |= (unsigned)(head + 1) > (unsigned)entityCount;
+        headCount += head != NONE;
+    }
+    for (const Entry& entry : entries) {
+        outside |= entry.cell < NONE || entry.cell >= cellCount || entry.prev < NONE ||
+                   entry.prev >= entityCount || entry.next < NONE || entry.next >= entityCount;
+    }
+    if (outside) {
+        return false;
+    }
+    
+    // Each tile list starts at its tile's head and runs through matching back
+    // links, so no list loops and every entry on the grid is on its tile's list
+    int starts = 0;
+    int linked = 0;
+    int reached = 0;
+    for (int first = 0; first < entityCount; first++) {
+        const Entry& entry = entries[first];
+        linked += entry.cell != NONE;
+        if (entry.cell == NONE || entry.prev != NONE) {
+            continue;
+        }
+        if (heads[entry.cell] != first) {
+            return false;
+        }
+        starts++;
+        int prev = NONE;
+        for (int id = first; id != NONE; id = entries[id].next) {
+            if (entries[id].cell != entry.cell || entries[id].prev != prev) {
+                return false;
+            }
+            reached++;
+            prev = id;
+        }
+    }
+    return starts == headCount && reached == linked;
+}
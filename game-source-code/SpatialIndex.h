@@ -0,0 +1,101 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include "GameSnapshot.h"
+#include "Position.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Per-tile occupancy index answering "who is at this tile" in O(1)
+ *
+ * Entities are identified by their index in the owner's vector. Every tile
+ * holds the head of a doubly linked list threaded through the entries, so
+ * inserting, moving and removing an entity are all O(1). Removal mirrors a
+ * swap-and-pop on the owner's vector: the last entity takes the removed id.
+ */
+class SpatialIndex {
+public:
+    static const int NONE = -1;
+
+private:
+    struct Entry {
+        int cell;  // row-major tile index, NONE if outside the grid
+        int prev;
+        int next;
+    };
+    
+    int width;
+    int height;
+    std::vector<int> heads;
+    std::vector<Entry> entries;
+
+public:
+    SpatialIndex();
+    
+    /**
+     * @brief Clear the index and size it for a grid
+     * @param gridWidth Grid width in tiles
+     * @param gridHeight Grid height in tiles
+     */
+    void reset(int gridWidth, int gridHeight);
+    
+    /**
+     * @brief Add the next entity (its id is the current size)
+     * @param pos Tile the entity is on
+     * @return Id of the new entity
+     */
+    int insert(const Position& pos);
+    
+    /**
+     * @brief Move an entity to another tile; does nothing if the tile is unchanged
+     * @param id Entity id
+     * @param pos Tile the entity is now on
+     */
+    void update(int id, const Position& pos);
+    
+    /**
+     * @brief Remove an entity the way swap-and-pop removes it from a vector
+     * @param id Entity id; the last entity is renumbered to this id
+     */
+    void removeSwapLast(int id);
+    
+    /**
+     * @brief First entity on a tile
+     * @param pos Tile to look at
+     * @return Entity id, or NONE if the tile is empty
+     */
+    int firstAt(const Position& pos) const;
+    
+    /**
+     * @brief Next entity on the same tile
+     * @param id Entity id returned by firstAt or nextAt
+     * @return Entity id, or NONE at the end of the tile
+     */
+    int nextAt(int id) const { return entries[id].next; }
+    
+    int size() const { return (int)entries.size(); }
+    
+    /**
+     * @brief Append the index to a snapshot, tile lists in their current order
+     */
+    void saveState(GameSnapshot& out) const;
+    
+    /**
+     * @brief Read back what saveState wrote
+     * @param in Snapshot being read
+     * @param gridWidth Width the index must have, e.g. the restored terrain's
+     * @param gridHeight Height the index must have
+     * @param entityCount Number of entities the index must hold
+     * @return False if the data is truncated, sized for another grid or
+     *         entity count, or its tile lists are broken
+     */
+    bool restoreState(GameSnapshot::Reader& in, int gridWidth, int gridHeight, int entityCount);
+
+private:
+    int cellOf(const Position& pos) const;
+    void link(int id, int cell);
+    void unlink(int id);
+};
+
+#endif // SPATIALINDEX_H
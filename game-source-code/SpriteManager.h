@@ -2,11 +2,14 @@
 #define SPRITEMANAGER_H
 
 #include <raylib-cpp.hpp>
-#include <unordered_map>
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <string>
-#include <iostream>
+#include <vector>
+#include "Logger.h"
 #include "Position.h"
+#include "ResourcePack.h"
 
 class SpriteManager {
 public:
@@ -29,13 +32,24 @@ public:
     static constexpr float UI_SCALE = 1.5f;           // 16x16 -> 24x24 for power-ups
     static constexpr float WEAPON_SCALE = 2.0f;       // 2x scale for weapons
     
+    static const int ATLAS_WIDTH = 512;   // grows if a single sprite is wider
+    static const int ATLAS_PADDING = 1;   // transparent gap so filtering never bleeds
+
 private:
     static SpriteManager* instance;
-    std::unordered_map<SpriteType, std::unique_ptr<raylib::Texture2D>> sprites;
-    bool spritesLoaded;
     
-    SpriteManager() : spritesLoaded(false) {}
+    // Every sprite lives in one atlas texture so consecutive draws batch;
+    // a sprite is its source rectangle in the atlas, found by array index
+    std::unique_ptr<raylib::Texture2D> atlas;
+    std::array<raylib::Rectangle, SPRITE_COUNT> sourceRects;
+    std::array<bool, SPRITE_COUNT> loaded;
+    int loadedCount;
+    bool spritesLoaded;
     
+    SpriteManager() : loadedCount(0), spritesLoaded(false) {
+        loaded.fill(false);
+    }
+
 public:
     static SpriteManager* getInstance() {
         if (instance == nullptr) {
@@ -49,33 +63,106 @@ public:
     bool loadSprites() {
         if (spritesLoaded) return true;
         
-        std::cout << "Loading sprites for 2x scale rendering..." << std::endl;
+        GAME_LOG_INFO("Loading sprites for 2x scale rendering...");
         
+        // A cooked atlas needs no PNG decoding or packing: upload it straight from the pack
+        if (!loadSpritesFromPack(*ResourcePack::getInstance())) {
+            std::vector<Image> images = loadSpriteImages();
+            std::array<raylib::Rectangle, SPRITE_COUNT> rects;
+            Image packed = packAtlasImage(images, rects);
+            if (IsImageValid(packed)) {
+                useAtlas(packed, rects);
+                UnloadImage(packed);
+            }
+            for (auto& image : images) {
+                if (IsImageValid(image)) UnloadImage(image);
+            }
+        }
+        
+        spritesLoaded = true;
+        GAME_LOG_INFO("Sprite loading complete. Loaded %d sprites.", loadedCount);
+        return true;
+    }
+    
+    /**
+     * @brief Decode every sprite PNG that exists
+     * @return One image per SpriteType; missing or unreadable sprites are left invalid
+     */
+    static std::vector<Image> loadSpriteImages() {
+        std::vector<Image> images(SPRITE_COUNT);
         for (int i = 0; i < SPRITE_COUNT; i++) {
             SpriteType type = static_cast<SpriteType>(i);
             std::string filename = getSpriteFilename(type);
+            images[i] = Image{};
             
             if (FileExists(filename.c_str())) {
-                try {
-                    auto texture = std::make_unique<raylib::Texture2D>(filename);
-                    sprites.emplace(type, std::move(texture));
-                    std::cout << "Loaded: " << filename << std::endl;
-                } catch (const std::exception& e) {
-                    std::cout << "Failed to load: " << filename << std::endl;
+                images[i] = LoadImage(filename.c_str());
+                if (IsImageValid(images[i])) {
+                    GAME_LOG_DEBUG("Loaded: %s", filename.c_str());
+                } else {
+                    GAME_LOG_WARNING("Failed to load: %s", filename.c_str());
                 }
             } else {
-                std::cout << "Sprite file not found: " << filename << std::endl;
+                GAME_LOG_DEBUG("Sprite file not found: %s", filename.c_str());
             }
         }
+        return images;
+    }
+    
+    /**
+     * @brief Shelf-pack sprite images into one atlas image
+     *
+     * Tallest sprites first, left to right, a new shelf when a row is full.
+     * @param images One image per SpriteType, as from loadSpriteImages
+     * @param rects Receives each sprite's place in the atlas (zero size if missing)
+     * @return The atlas, invalid if there were no sprites; the caller unloads it
+     */
+    static Image packAtlasImage(const std::vector<Image>& images, std::array<raylib::Rectangle, SPRITE_COUNT>& rects) {
+        rects.fill(raylib::Rectangle(0, 0, 0, 0));
         
-        spritesLoaded = true;
-        std::cout << "Sprite loading complete. Loaded " << sprites.size() << " sprites." << std::endl;
-        return true;
+        std::vector<int> order;
+        int atlasWidth = ATLAS_WIDTH;
+        for (int i = 0; i < SPRITE_COUNT; i++) {
+            if (IsImageValid(images[i])) {
+                order.push_back(i);
+                atlasWidth = std::max(atlasWidth, images[i].width + 2 * ATLAS_PADDING);
+            }
+        }
+        if (order.empty()) return Image{};
+        
+        std::stable_sort(order.begin(), order.end(),
+            [&](int a, int b) { return images[a].height > images[b].height; });
+        
+        int x = ATLAS_PADDING;
+        int y = ATLAS_PADDING;
+        int shelfHeight = 0;
+        for (int index : order) {
+            const Image& image = images[index];
+            if (x + image.width + ATLAS_PADDING > atlasWidth) {
+                x = ATLAS_PADDING;
+                y += shelfHeight + ATLAS_PADDING;
+                shelfHeight = 0;
+            }
+            rects[index] = raylib::Rectangle(x, y, image.width, image.height);
+            x += image.width + ATLAS_PADDING;
+            shelfHeight = std::max(shelfHeight, image.height);
+        }
+        int atlasHeight = y + shelfHeight + ATLAS_PADDING;
+        
+        Image packed = GenImageColor(atlasWidth, atlasHeight, BLANK);
+        for (int index : order) {
+            const Image& image = images[index];
+            ImageDraw(&packed, image, raylib::Rectangle(0, 0, image.width, image.height), rects[index], WHITE);
+        }
+        GAME_LOG_INFO("Packed %d sprites into a %dx%d atlas", (int)order.size(), atlasWidth, atlasHeight);
+        return packed;
     }
     
     void unloadSprites() {
         if (!spritesLoaded) return;
-        sprites.clear();
+        atlas.reset();
+        loaded.fill(false);
+        loadedCount = 0;
         spritesLoaded = false;
     }
     
@@ -115,19 +202,17 @@ public:
     }
     
     bool isSpriteLoaded(SpriteType type) const {
-        auto it = sprites.find(type);
-        return it != sprites.end() && it->second != nullptr;
+        return type >= 0 && type < SPRITE_COUNT && loaded[type];
     }
     
     raylib::Vector2 getSpriteSize(SpriteType type) const {
-        auto it = sprites.find(type);
-        if (it != sprites.end() && it->second) {
+        if (isSpriteLoaded(type)) {
             float scale = getDefaultScale(type);
-            return raylib::Vector2(it->second->GetWidth() * scale, it->second->GetHeight() * scale);
+            return raylib::Vector2(sourceRects[type].width * scale, sourceRects[type].height * scale);
         }
         return raylib::Vector2(Position::BLOCK_SIZE * 2, Position::BLOCK_SIZE * 2);
     }
-    
+
 private:
     float getDefaultScale(SpriteType type) const {
         // Return appropriate scale based on sprite category
@@ -141,23 +226,58 @@ private:
     }
     
     void drawSpriteAdvanced(SpriteType type, int pixelX, int pixelY, float scale, bool flipHorizontal, raylib::Color tint) const {
-        auto it = sprites.find(type);
-        if (it != sprites.end() && it->second) {
-            float width = it->second->GetWidth() * scale;
-            float height = it->second->GetHeight() * scale;
-            
-            raylib::Rectangle source(0, 0, it->second->GetWidth(), it->second->GetHeight());
-            raylib::Rectangle dest(pixelX, pixelY, width, height);
+        if (isSpriteLoaded(type)) {
+            raylib::Rectangle source = sourceRects[type];
+            raylib::Rectangle dest(pixelX, pixelY, source.width * scale, source.height * scale);
             
             if (flipHorizontal) {
                 source.width = -source.width;
             }
             
-            it->second->Draw(source, dest, raylib::Vector2::Zero(), 0.0f, tint);
+            atlas->Draw(source, dest, raylib::Vector2::Zero(), 0.0f, tint);
         }
     }
     
-    std::string getSpriteFilename(SpriteType type) const {
+    void useAtlas(const Image& image, const std::array<raylib::Rectangle, SPRITE_COUNT>& rects) {
+        atlas = std::make_unique<raylib::Texture2D>(image);
+        sourceRects = rects;
+        loadedCount = 0;
+        for (int i = 0; i < SPRITE_COUNT; i++) {
+            loaded[i] = rects[i].width > 0 && rects[i].height > 0;
+            if (loaded[i]) loadedCount++;
+        }
+    }
+    
+    bool loadSpritesFromPack(const ResourcePack& pack) {
+        const ResourcePack::Entry* entry = pack.find("sprites/atlas", ResourcePack::ENTRY_ATLAS);
+        if (!entry || entry->size < sizeof(ResourcePack::AtlasHeader)) return false;
+        
+        const uint8_t* data = pack.getData(*entry);
+        const ResourcePack::AtlasHeader* header = reinterpret_cast<const ResourcePack::AtlasHeader*>(data);
+        size_t rectBytes = sizeof(ResourcePack::SpriteRect) * SPRITE_COUNT;
+        size_t pixelBytes = (size_t)header->width * header->height * 4;
+        if (header->spriteCount != SPRITE_COUNT || header->width <= 0 || header->height <= 0 ||
+            entry->size != sizeof(ResourcePack::AtlasHeader) + rectBytes + pixelBytes) {
+            GAME_LOG_WARNING("Cooked sprite atlas does not match this build, loading PNGs instead");
+            return false;
+        }
+        
+        const ResourcePack::SpriteRect* cooked =
+            reinterpret_cast<const ResourcePack::SpriteRect*>(data + sizeof(ResourcePack::AtlasHeader));
+        std::array<raylib::Rectangle, SPRITE_COUNT> rects;
+        for (int i = 0; i < SPRITE_COUNT; i++) {
+            rects[i] = raylib::Rectangle(cooked[i].x, cooked[i].y, cooked[i].width, cooked[i].height);
+        }
+        
+        // The pixels are uploaded from the mapping itself, never copied
+        Image image = { const_cast<uint8_t*>(data + sizeof(ResourcePack::AtlasHeader) + rectBytes),
+                        header->width, header->height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        useAtlas(image, rects);
+        GAME_LOG_INFO("Sprite atlas %dx%d loaded from resource pack", header->width, header->height);
+        return true;
+    }
+    
+    static std::string getSpriteFilename(SpriteType type) {
         switch (type) {
             case PLAYER_IDLE: return "resources/sprites/player/idle.png";
             case PLAYER_WALKING_UP: return "resources/sprites/player/walk_up.png";
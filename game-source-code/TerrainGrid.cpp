@@ -1,30 +1,256 @@
 #include "TerrainGrid.h"
 #include "SpriteManager.h"
+#include "LevelFile.h"
+#include "MappedFile.h"
+#include "ResourcePack.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
-#include <iostream>
+#include "Logger.h"
 
-TerrainGrid::TerrainGrid(int levelNumber) : levelLoaded(false) {
+static_assert(TerrainGrid::CHUNK_SIZE == LevelFile::CHUNK_SIZE, "level files store chunks as they are in memory");
+
+TerrainGrid::Chunk::Chunk() {
+    // No rock or empty bits set: solid earth
+    for (int row = 0; row < CHUNK_SIZE; row++) {
+        rockBits[row] = 0;
+        emptyBits[row] = 0;
+        dirtyBits[row] = 0;
+    }
+}
+
+TerrainGrid::TerrainGrid(int levelNumber)
+    : width(0), height(0), chunksWide(0), chunksHigh(0), revision(0), levelLoaded(false), changeLogStart(0) {
     // Initialize all blocks as solid first
-    for (int x = 0; x < WORLD_WIDTH; x++) {
-        for (int y = 0; y < WORLD_HEIGHT; y++) {
-            blocks[x][y] = BlockType::SOLID;
-        }
+    resize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    
+    // Prefer the cooked level when a resource pack is open, then a binary
+    // level file, and only parse the text file when neither is there
+    std::string name = "level" + std::to_string(levelNumber);
+    ResourcePack* pack = ResourcePack::getInstance();
+    const ResourcePack::Entry* entry = pack->find(name, ResourcePack::ENTRY_LEVEL);
+    bool loaded = entry && loadBinary(pack->getData(*entry), (size_t)entry->size, name);
+    
+    if (!loaded) {
+        std::string binaryFile = "resources/" + name + ".lvl";
+        loaded = FileExists(binaryFile.c_str()) && loadBinaryFile(binaryFile);
     }
     
-    // Try to load the specific level file
-    std::string filename = "resources/level" + std::to_string(levelNumber) + ".txt";
-    if (!loadFromFile(filename)) {
-        std::cout << "Level " << levelNumber << " file not found, creating default level..." << std::endl;
+    if (!loaded && !loadFromFile("resources/" + name + ".txt")) {
+        GAME_LOG_WARNING("Level %d file not found, creating default level...", levelNumber);
         createDefaultLevel();
     }
     
+    rebuildRockStability();
+    levelLoaded = true;
+}
+
+TerrainGrid::TerrainGrid(int gridWidth, int gridHeight)
+    : width(0), height(0), chunksWide(0), chunksHigh(0), revision(0), levelLoaded(false), changeLogStart(0) {
+    resize(gridWidth, gridHeight);
+    playerStartPosition = Position(width / 2, 0);
     levelLoaded = true;
 }
 
+TerrainGrid::TerrainGrid(const TerrainGrid& other)
+    : width(other.width), height(other.height), chunksWide(other.chunksWide),
+      chunksHigh(other.chunksHigh), revision(other.revision), initialRockPositions(other.initialRockPositions),
+      playerStartPosition(other.playerStartPosition), monsterPositions(other.monsterPositions),
+      levelLoaded(other.levelLoaded), triggeredRockFalls(other.triggeredRockFalls),
+      dirtyCells(other.dirtyCells), unstableRocks(other.unstableRocks),
+      changeLog(other.changeLog), changeLogStart(other.changeLogStart) {
+    chunks.resize(other.chunks.size());
+    for (size_t i = 0; i < other.chunks.size(); i++) {
+        if (other.chunks[i]) {
+            chunks[i] = std::make_unique<Chunk>(*other.chunks[i]);
+        }
+    }
+}
+
+TerrainGrid& TerrainGrid::operator=(const TerrainGrid& other) {
+    if (this != &other) {
+        TerrainGrid copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+void TerrainGrid::resize(int gridWidth, int gridHeight) {
+    width = std::max(1, gridWidth);
+    height = std::max(1, gridHeight);
+    chunksWide = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunksHigh = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    
+    chunks.clear();
+    chunks.resize((size_t)chunksWide * chunksHigh);
+    revision++;
+    changeLogStart = revision;
+    dirtyCells.clear();
+    unstableRocks.clear();
+    triggeredRockFalls.clear();
+}
+
+TerrainGrid::Chunk* TerrainGrid::findChunk(int x, int y) const {
+    return chunks[(size_t)(y / CHUNK_SIZE) * chunksWide + (x / CHUNK_SIZE)].get();
+}
+
+TerrainGrid::Chunk& TerrainGrid::touchChunk(int x, int y) {
+    auto& chunk = chunks[(size_t)(y / CHUNK_SIZE) * chunksWide + (x / CHUNK_SIZE)];
+    if (!chunk) {
+        chunk = std::make_unique<Chunk>();
+    }
+    return *chunk;
+}
+
+BlockType TerrainGrid::cellAt(int x, int y) const {
+    const Chunk* chunk = findChunk(x, y);
+    if (!chunk) {
+        return BlockType::SOLID;
+    }
+    
+    int row = y % CHUNK_SIZE;
+    uint64_t bit = cellBit(x);
+    if (chunk->emptyBits[row] & bit) {
+        return BlockType::EMPTY;
+    }
+    if (chunk->rockBits[row] & bit) {
+        return BlockType::ROCK;
+    }
+    return BlockType::SOLID;
+}
+
+void TerrainGrid::writeCell(int x, int y, BlockType type) {
+    // Solid earth is what an unallocated chunk already holds
+    if (type == BlockType::SOLID && !findChunk(x, y)) {
+        return;
+    }
+    Chunk& chunk = touchChunk(x, y);
+    int row = y % CHUNK_SIZE;
+    uint64_t bit = cellBit(x);
+    chunk.rockBits[row] &= ~bit;
+    chunk.emptyBits[row] &= ~bit;
+    if (type == BlockType::ROCK) {
+        chunk.rockBits[row] |= bit;
+    } else if (type == BlockType::EMPTY) {
+        chunk.emptyBits[row] |= bit;
+    }
+}
+
+uint64_t TerrainGrid::rowMask(int chunkX) const {
+    // Columns of the last chunk in a row can run past the grid width
+    int columns = std::min(CHUNK_SIZE, width - chunkX * CHUNK_SIZE);
+    return columns >= 64 ? ~uint64_t(0) : (uint64_t(1) << columns) - 1;
+}
+
+uint64_t TerrainGrid::emptyRowBits(int chunkX, int y) const {
+    if (y < 0 || y >= height) {
+        return 0;
+    }
+    const Chunk* chunk = chunks[(size_t)(y / CHUNK_SIZE) * chunksWide + chunkX].get();
+    return chunk ? chunk->emptyBits[y % CHUNK_SIZE] : 0;
+}
+
+int TerrainGrid::getAllocatedChunkCount() const {
+    int allocated = 0;
+    for (const auto& chunk : chunks) {
+        if (chunk) {
+            allocated++;
+        }
+    }
+    return allocated;
+}
+
+long long TerrainGrid::countDugCells() const {
+    long long dug = 0;
+    for (const auto& chunk : chunks) {
+        if (chunk) {
+            for (int row = 0; row < CHUNK_SIZE; row++) {
+                dug += std::popcount(chunk->emptyBits[row]);
+            }
+        }
+    }
+    return dug;
+}
+
+long long TerrainGrid::countRocks() const {
+    long long rocks = 0;
+    for (const auto& chunk : chunks) {
+        if (chunk) {
+            for (int row = 0; row < CHUNK_SIZE; row++) {
+                rocks += std::popcount(chunk->rockBits[row]);
+            }
+        }
+    }
+    return rocks;
+}
+
+bool TerrainGrid::isRowEmpty(int y) const {
+    if (y < 0 || y >= height) {
+        return false;
+    }
+    for (int cx = 0; cx < chunksWide; cx++) {
+        uint64_t mask = rowMask(cx);
+        if ((emptyRowBits(cx, y) & mask) != mask) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<Position> TerrainGrid::findUnsupportedRocks() const {
+    std::vector<long long> keys;
+    collectUnsupportedRocks(keys);
+    
+    std::vector<Position> rocks;
+    rocks.reserve(keys.size());
+    for (long long key : keys) {
+        rocks.push_back(Position((int)(key / height), (int)(key % height)));
+    }
+    return rocks;
+}
+
+void TerrainGrid::collectUnsupportedRocks(std::vector<long long>& keys) const {
+    keys.clear();
+    
+    // Unallocated chunks are solid earth and cannot hold a rock
+    for (int cy = 0; cy < chunksHigh; cy++) {
+        for (int cx = 0; cx < chunksWide; cx++) {
+            const Chunk* chunk = chunks[(size_t)cy * chunksWide + cx].get();
+            if (!chunk) {
+                continue;
+            }
+            
+            int endY = std::min(height, (cy + 1) * CHUNK_SIZE);
+            for (int y = cy * CHUNK_SIZE; y < endY; y++) {
+                // The row below may live in the next chunk down; off the grid counts as support
+                uint64_t unsupported = chunk->rockBits[y % CHUNK_SIZE] & emptyRowBits(cx, y + 1);
+                while (unsupported) {
+                    int x = cx * CHUNK_SIZE + std::countr_zero(unsupported);
+                    keys.push_back((long long)x * height + y);
+                    unsupported &= unsupported - 1;
+                }
+            }
+        }
+    }
+    
+    // Triggers go out in column-major order, same as the original scan
+    std::sort(keys.begin(), keys.end());
+}
+
+bool TerrainGrid::isInside(const TerrainGrid* terrain, const Position& pos) {
+    return terrain ? terrain->isValidPosition(pos) : pos.isValid();
+}
+
+bool TerrainGrid::isOpen(const TerrainGrid* terrain, const Position& pos) {
+    return terrain ? terrain->isBlockEmpty(pos) : pos.isValid();
+}
+
 bool TerrainGrid::loadFromFile(const std::string& filename) {
     std::ifstream file(filename);
     if (!file.is_open()) {
-        std::cout << "Could not open level file: " << filename << std::endl;
+        GAME_LOG_WARNING("Could not open level file: %s", filename.c_str());
         return false;
     }
     
@@ -35,53 +261,67 @@ bool TerrainGrid::loadFromFile(const std::string& filename) {
     initialRockPositions.clear();
     monsterPositions.clear();
     playerStartPosition = Position(17, 3); // Default position
+    resize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
     
-    std::cout << "Loading level from: " << filename << std::endl;
+    GAME_LOG_INFO("Loading level from: %s", filename.c_str());
     
-    while (std::getline(file, line) && y < WORLD_HEIGHT) {
+    while (std::getline(file, line) && y < height) {
         // Skip comment lines and empty lines
         if (line.empty() || line[0] == '#') {
             continue;
         }
         
+        // Optional "SIZE <width> <height>" line before the first row
+        if (y == 0 && line.compare(0, 5, "SIZE ") == 0) {
+            int gridWidth = 0;
+            int gridHeight = 0;
+            if (std::sscanf(line.c_str() + 5, "%d %d", &gridWidth, &gridHeight) != 2 ||
+                gridWidth <= 0 || gridHeight <= 0) {
+                GAME_LOG_WARNING("Invalid SIZE line in %s: %s", filename.c_str(), line.c_str());
+                return false;
+            }
+            resize(gridWidth, gridHeight);
+            continue;
+        }
+        
         // Ensure line is long enough
-        if (line.length() < WORLD_WIDTH) {
-            line.resize(WORLD_WIDTH, 'W'); // Pad with walls
+        if ((int)line.length() < width) {
+            line.resize(width, 'W'); // Pad with walls
         }
         
-        for (int x = 0; x < WORLD_WIDTH && x < (int)line.length(); x++) {
+        for (int x = 0; x < width && x < (int)line.length(); x++) {
             char c = line[x];
             Position pos(x, y);
             
             switch (c) {
                 case 'W':
-                    blocks[x][y] = BlockType::SOLID;
+                    writeCell(x, y, BlockType::SOLID);
                     break;
                 case '.':
-                    blocks[x][y] = BlockType::EMPTY;
+                    writeCell(x, y, BlockType::EMPTY);
                     break;
                 case 'R':
-                    blocks[x][y] = BlockType::ROCK;
+                    writeCell(x, y, BlockType::ROCK);
                     initialRockPositions.push_back(pos);
-                    std::cout << "ROCK LOADED at (" << pos.x << ", " << pos.y << ")" << std::endl;
+                    GAME_LOG_DEBUG("ROCK LOADED at (%d, %d)", pos.x, pos.y);
                     break;
                 case 'P':
-                    blocks[x][y] = BlockType::EMPTY;
+                    writeCell(x, y, BlockType::EMPTY);
                     playerStartPosition = pos;
-                    std::cout << "Player start position: (" << pos.x << ", " << pos.y << ")" << std::endl;
+                    GAME_LOG_DEBUG("Player start position: (%d, %d)", pos.x, pos.y);
                     break;
                 case 'M':
-                    blocks[x][y] = BlockType::EMPTY;
+                    writeCell(x, y, BlockType::EMPTY);
                     monsterPositions.push_back(pos);
-                    std::cout << "Monster position: (" << pos.x << ", " << pos.y << ")" << std::endl;
+                    GAME_LOG_DEBUG("Monster position: (%d, %d)", pos.x, pos.y);
                     break;
                 case 'D':
-                    blocks[x][y] = BlockType::EMPTY;
+                    writeCell(x, y, BlockType::EMPTY);
                     monsterPositions.push_back(pos);
-                    std::cout << "Dragon position: (" << pos.x << ", " << pos.y << ")" << std::endl;
+                    GAME_LOG_DEBUG("Dragon position: (%d, %d)", pos.x, pos.y);
                     break;
                 default:
-                    blocks[x][y] = BlockType::SOLID;
+                    writeCell(x, y, BlockType::SOLID);
                     break;
             }
         }
@@ -92,18 +332,291 @@ bool TerrainGrid::loadFromFile(const std::string& filename) {
     
     // Validate level data
     if (!validateLevelData()) {
-        std::cout << "Level validation failed, using default level" << std::endl;
+        GAME_LOG_WARNING("Level validation failed, using default level");
+        return false;
+    }
+    
+    GAME_LOG_INFO("Level loaded successfully: %d rocks, %d monsters, player start (%d, %d)",
+                  (int)initialRockPositions.size(), (int)monsterPositions.size(),
+                  playerStartPosition.x, playerStartPosition.y);
+    
+    return true;
+}
+
+bool TerrainGrid::loadBinary(const uint8_t* data, size_t size, const std::string& name) {
+    if (size < sizeof(LevelFile::Header)) {
+        GAME_LOG_WARNING("Level %s is truncated", name.c_str());
+        return false;
+    }
+    const LevelFile::Header* header = reinterpret_cast<const LevelFile::Header*>(data);
+    if (std::memcmp(header->magic, LevelFile::MAGIC, 4) != 0 || header->version != LevelFile::VERSION) {
+        GAME_LOG_WARNING("%s is not a version %d binary level", name.c_str(), (int)LevelFile::VERSION);
+        return false;
+    }
+    
+    // Bound every count by the data size before using it in offsets
+    if (header->width <= 0 || header->height <= 0 ||
+        header->width > LevelFile::MAX_SIDE || header->height > LevelFile::MAX_SIDE ||
+        header->rockCount > size || header->monsterCount > size || header->storedChunkCount > size ||
+        LevelFile::fileSize(*header) != size) {
+        GAME_LOG_WARNING("Level %s has a bad header or is truncated", name.c_str());
+        return false;
+    }
+    
+    const uint32_t* chunkTable = reinterpret_cast<const uint32_t*>(data + sizeof(LevelFile::Header));
+    const LevelFile::SpawnPoint* spawns =
+        reinterpret_cast<const LevelFile::SpawnPoint*>(data + LevelFile::spawnOffset(*header));
+    const LevelFile::Chunk* stored = reinterpret_cast<const LevelFile::Chunk*>(data + LevelFile::chunkOffset(*header));
+    
+    // Check the planes before changing anything: no cell both rock and empty,
+    // no bits outside the grid, no chunk table entry past the stored chunks
+    int wide = (header->width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int high = (header->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    for (int chunkY = 0; chunkY < high; chunkY++) {
+        for (int chunkX = 0; chunkX < wide; chunkX++) {
+            uint32_t entry = chunkTable[(size_t)chunkY * wide + chunkX];
+            if (entry == 0) {
+                continue;
+            }
+            if (entry > header->storedChunkCount) {
+                GAME_LOG_WARNING("Level %s has a bad chunk table", name.c_str());
+                return false;
+            }
+            
+            const LevelFile::Chunk& chunk = stored[entry - 1];
+            int columns = std::min(CHUNK_SIZE, header->width - chunkX * CHUNK_SIZE);
+            uint64_t mask = columns >= 64 ? ~uint64_t(0) : (uint64_t(1) << columns) - 1;
+            int rows = std::min(CHUNK_SIZE, header->height - chunkY * CHUNK_SIZE);
+            for (int row = 0; row < CHUNK_SIZE; row++) {
+                uint64_t rowMaskBits = row < rows ? mask : 0;
+                if ((chunk.rockBits[row] & chunk.emptyBits[row]) != 0 ||
+                    ((chunk.rockBits[row] | chunk.emptyBits[row]) & ~rowMaskBits) != 0) {
+                    GAME_LOG_WARNING("Level %s has corrupt cells in chunk (%d, %d)", name.c_str(), chunkX, chunkY);
+                    return false;
+                }
+            }
+        }
+    }
+    
+    resize(header->width, header->height);
+    for (int i = 0; i < chunksWide * chunksHigh; i++) {
+        if (chunkTable[i] != 0) {
+            const LevelFile::Chunk& source = stored[chunkTable[i] - 1];
+            chunks[i] = std::make_unique<Chunk>();
+            std::memcpy(chunks[i]->rockBits, source.rockBits, sizeof(source.rockBits));
+            std::memcpy(chunks[i]->emptyBits, source.emptyBits, sizeof(source.emptyBits));
+        }
+    }
+    
+    playerStartPosition = Position(header->playerX, header->playerY);
+    initialRockPositions.clear();
+    for (uint32_t i = 0; i < header->rockCount; i++) {
+        initialRockPositions.push_back(Position(spawns[i].x, spawns[i].y));
+    }
+    monsterPositions.clear();
+    for (uint32_t i = 0; i < header->monsterCount; i++) {
+        const LevelFile::SpawnPoint& spawn = spawns[header->rockCount + i];
+        monsterPositions.push_back(Position(spawn.x, spawn.y));
+    }
+    
+    for (const auto& pos : initialRockPositions) {
+        if (!isBlockRock(pos)) {
+            GAME_LOG_WARNING("Level %s lists a rock at (%d, %d) that is not in the grid", name.c_str(), pos.x, pos.y);
+            return false;
+        }
+    }
+    if (!validateLevelData()) {
+        GAME_LOG_WARNING("Level %s failed validation", name.c_str());
+        return false;
+    }
+    
+    GAME_LOG_INFO("Level %s loaded: %dx%d, %d rocks, %d monsters, player start (%d, %d)",
+                  name.c_str(), width, height, (int)initialRockPositions.size(), (int)monsterPositions.size(),
+                  playerStartPosition.x, playerStartPosition.y);
+    return true;
+}
+
+bool TerrainGrid::loadBinaryFile(const std::string& filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        GAME_LOG_WARNING("Could not open level file: %s", filename.c_str());
+        return false;
+    }
+    return loadBinary(file.getData(), file.getSize(), filename);
+}
+
+void TerrainGrid::writeBinary(std::vector<uint8_t>& out) const {
+    LevelFile::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, LevelFile::MAGIC, 4);
+    header.version = LevelFile::VERSION;
+    header.width = width;
+    header.height = height;
+    header.playerX = playerStartPosition.x;
+    header.playerY = playerStartPosition.y;
+    header.rockCount = (uint32_t)initialRockPositions.size();
+    header.monsterCount = (uint32_t)monsterPositions.size();
+    
+    // Chunks that are allocated but back to all solid are not worth storing
+    std::vector<uint32_t> chunkTable(chunks.size(), 0);
+    std::vector<const Chunk*> stored;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const Chunk* chunk = chunks[i].get();
+        bool solid = true;
+        for (int row = 0; chunk && row < CHUNK_SIZE && solid; row++) {
+            solid = (chunk->rockBits[row] | chunk->emptyBits[row]) == 0;
+        }
+        if (!solid) {
+            stored.push_back(chunk);
+            chunkTable[i] = (uint32_t)stored.size();
+        }
+    }
+    header.storedChunkCount = (uint32_t)stored.size();
+    
+    size_t start = out.size();
+    out.resize(start + LevelFile::fileSize(header), 0);
+    uint8_t* data = out.data() + start;
+    std::memcpy(data, &header, sizeof(header));
+    std::memcpy(data + sizeof(header), chunkTable.data(), chunkTable.size() * sizeof(uint32_t));
+    
+    LevelFile::SpawnPoint* spawns = reinterpret_cast<LevelFile::SpawnPoint*>(data + LevelFile::spawnOffset(header));
+    for (const auto& pos : initialRockPositions) {
+        *spawns++ = { pos.x, pos.y };
+    }
+    for (const auto& pos : monsterPositions) {
+        *spawns++ = { pos.x, pos.y };
+    }
+    
+    LevelFile::Chunk* planes = reinterpret_cast<LevelFile::Chunk*>(data + LevelFile::chunkOffset(header));
+    for (const Chunk* chunk : stored) {
+        std::memcpy(planes->rockBits, chunk->rockBits, sizeof(planes->rockBits));
+        std::memcpy(planes->emptyBits, chunk->emptyBits, sizeof(planes->emptyBits));
+        planes++;
+    }
+}
+
+bool TerrainGrid::saveBinaryFile(const std::string& filename) const {
+    std::vector<uint8_t> data;
+    writeBinary(data);
+    
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        GAME_LOG_ERROR("Could not write level file: %s", filename.c_str());
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
+    return file.good();
+}
+
+void TerrainGrid::saveState(GameSnapshot& out) const {
+    out.write((int32_t)width);
+    out.write((int32_t)height);
+    out.write(levelLoaded);
+    
+    // Chunk table as in the level format: still-solid chunks take one byte
+    for (const auto& chunk : chunks) {
+        out.write((uint8_t)(chunk ? 1 : 0));
+        if (chunk) {
+            out.write(*chunk);
+        }
+    }
+    out.writeVector(triggeredRockFalls);
+    out.writeVector(dirtyCells);
+    out.writeVector(unstableRocks);
+}
+
+bool TerrainGrid::restoreState(GameSnapshot::Reader& in) {
+    int32_t savedWidth = 0;
+    int32_t savedHeight = 0;
+    bool loaded = false;
+    if (!in.read(savedWidth) || !in.read(savedHeight) || !in.read(loaded) ||
+        savedWidth < 1 || savedHeight < 1 || savedWidth > LevelFile::MAX_SIDE || savedHeight > LevelFile::MAX_SIDE) {
         return false;
     }
+    if (savedWidth != width || savedHeight != height) {
+        resize(savedWidth, savedHeight);
+    }
+    
+    // Chunks that are allocated on both sides are overwritten in place
+    for (auto& chunk : chunks) {
+        uint8_t stored = 0;
+        if (!in.read(stored)) {
+            return false;
+        }
+        if (!stored) {
+            chunk.reset();
+            continue;
+        }
+        if (!chunk) {
+            chunk = std::make_unique<Chunk>();
+        }
+        if (!in.read(*chunk)) {
+            return false;
+        }
+    }
+    levelLoaded = loaded;
     
-    std::cout << "Level loaded successfully:" << std::endl;
-    std::cout << "- Rocks: " << initialRockPositions.size() << std::endl;
-    std::cout << "- Monsters: " << monsterPositions.size() << std::endl;
-    std::cout << "- Player start: (" << playerStartPosition.x << ", " << playerStartPosition.y << ")" << std::endl;
+    if (!in.readVector(triggeredRockFalls) || !in.readVector(dirtyCells) || !in.readVector(unstableRocks)) {
+        return false;
+    }
     
+    // The stability bookkeeping is used to index the grid, so it has to lie
+    // inside it and agree with the chunks' dirty bits
+    for (const auto& pos : triggeredRockFalls) {
+        if (!isValidPosition(pos)) {
+            return false;
+        }
+    }
+    size_t dirtyBitCount = 0;
+    for (const auto& chunk : chunks) {
+        if (chunk) {
+            for (int row = 0; row < CHUNK_SIZE; row++) {
+                dirtyBitCount += std::popcount(chunk->dirtyBits[row]);
+            }
+        }
+    }
+    for (const auto& pos : dirtyCells) {
+        if (!isValidPosition(pos)) {
+            return false;
+        }
+        const Chunk* chunk = findChunk(pos.x, pos.y);
+        if (!chunk || !(chunk->dirtyBits[pos.y % CHUNK_SIZE] & cellBit(pos.x))) {
+            return false;
+        }
+    }
+    if (dirtyBitCount != dirtyCells.size()) {
+        return false;
+    }
+    const long long cellCount = (long long)width * height;
+    for (size_t i = 0; i < unstableRocks.size(); i++) {
+        long long key = unstableRocks[i];
+        if (key < 0 || key >= cellCount || (i > 0 && key <= unstableRocks[i - 1])) {
+            return false;
+        }
+    }
+    
+    revision++;
+    changeLogStart = revision;
     return true;
 }
 
+void TerrainGrid::swapState(TerrainGrid& other) {
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(chunksWide, other.chunksWide);
+    std::swap(chunksHigh, other.chunksHigh);
+    chunks.swap(other.chunks);
+    std::swap(levelLoaded, other.levelLoaded);
+    triggeredRockFalls.swap(other.triggeredRockFalls);
+    dirtyCells.swap(other.dirtyCells);
+    unstableRocks.swap(other.unstableRocks);
+    
+    revision++;
+    changeLogStart = revision;
+    other.revision++;
+    other.changeLogStart = other.revision;
+}
+
 void TerrainGrid::triggerRockFall(const Position& rockPos) {
     if (isBlockRock(rockPos)) {
         // Check if this rock is already triggered to prevent duplicates
@@ -114,7 +627,7 @@ void TerrainGrid::triggerRockFall(const Position& rockPos) {
         }
         
         triggeredRockFalls.push_back(rockPos);
-        std::cout << "Rock fall triggered at (" << rockPos.x << ", " << rockPos.y << ")" << std::endl;
+        GAME_LOG_DEBUG("Rock fall triggered at (%d, %d)", rockPos.x, rockPos.y);
     }
 }
 
@@ -128,45 +641,49 @@ bool TerrainGrid::isBlockSolid(const Position& pos) const {
     if (!isValidPosition(pos)) {
         return true;
     }
-    return blocks[pos.x][pos.y] == BlockType::SOLID;
+    return cellAt(pos.x, pos.y) == BlockType::SOLID;
 }
 
 bool TerrainGrid::isBlockRock(const Position& pos) const {
     if (!isValidPosition(pos)) {
         return false;
     }
-    return blocks[pos.x][pos.y] == BlockType::ROCK;
+    return cellAt(pos.x, pos.y) == BlockType::ROCK;
 }
 
 bool TerrainGrid::isBlockEmpty(const Position& pos) const {
     if (!isValidPosition(pos)) {
         return false;
     }
-    return blocks[pos.x][pos.y] == BlockType::EMPTY;
+    return cellAt(pos.x, pos.y) == BlockType::EMPTY;
 }
 
 BlockType TerrainGrid::getBlockType(const Position& pos) const {
     if (!isValidPosition(pos)) {
         return BlockType::SOLID;
     }
-    return blocks[pos.x][pos.y];
+    return cellAt(pos.x, pos.y);
 }
 
 void TerrainGrid::digTunnelAt(const Position& pos) {
-    if (isValidPosition(pos)) {
-        blocks[pos.x][pos.y] = BlockType::EMPTY;
+    if (isValidPosition(pos) && cellAt(pos.x, pos.y) != BlockType::EMPTY) {
+        writeCell(pos.x, pos.y, BlockType::EMPTY);
+        markDirty(pos);
+        logChange(pos);
     }
 }
 
 void TerrainGrid::setBlock(const Position& pos, BlockType type) {
-    if (isValidPosition(pos)) {
-        blocks[pos.x][pos.y] = type;
+    if (isValidPosition(pos) && cellAt(pos.x, pos.y) != type) {
+        writeCell(pos.x, pos.y, type);
+        markDirty(pos);
+        logChange(pos);
     }
 }
 
 bool TerrainGrid::isValidPosition(const Position& pos) const {
-    return pos.x >= 0 && pos.x < WORLD_WIDTH && 
-           pos.y >= 0 && pos.y < WORLD_HEIGHT;
+    return pos.x >= 0 && pos.x < width && 
+           pos.y >= 0 && pos.y < height;
 }
 
 void TerrainGrid::removeRockAt(const Position& pos) {
@@ -177,36 +694,32 @@ void TerrainGrid::removeRockAt(const Position& pos) {
 
 
 void TerrainGrid::createDefaultLevel() {
-    std::cout << "Creating default level with improved physics..." << std::endl;
+    GAME_LOG_INFO("Creating default level with improved physics...");
+    
+    // Ground level (row 3 and below are solid earth)
+    resize(DEFAULT_WIDTH, DEFAULT_HEIGHT);
     
     // Initialize ground level - sky above row 3
-    for (int x = 0; x < WORLD_WIDTH; x++) {
+    for (int x = 0; x < width; x++) {
         for (int y = 0; y < 3; y++) {
-            blocks[x][y] = BlockType::EMPTY;
-        }
-    }
-    
-    // Ground level (row 3 and below are solid earth)
-    for (int x = 0; x < WORLD_WIDTH; x++) {
-        for (int y = 3; y < WORLD_HEIGHT; y++) {
-            blocks[x][y] = BlockType::SOLID;
+            writeCell(x, y, BlockType::EMPTY);
         }
     }
     
     // Create narrow vertical tunnel from surface
     for (int y = 3; y <= 14; y++) {
-        blocks[20][y] = BlockType::EMPTY;
+        writeCell(20, y, BlockType::EMPTY);
     }
     
     // Create horizontal tunnels
     for (int x = 10; x < 30; x++) {
-        blocks[x][15] = BlockType::EMPTY; // Upper tunnel
-        blocks[x][25] = BlockType::EMPTY; // Lower tunnel
+        writeCell(x, 15, BlockType::EMPTY); // Upper tunnel
+        writeCell(x, 25, BlockType::EMPTY); // Lower tunnel
     }
     
     // Connect vertical to horizontal tunnels
     for (int y = 15; y <= 25; y++) {
-        blocks[20][y] = BlockType::EMPTY;
+        writeCell(20, y, BlockType::EMPTY);
     }
     
     // Set player start position
@@ -227,8 +740,8 @@ void TerrainGrid::createDefaultLevel() {
     
     // Place rocks in terrain
     for (const auto& rockPos : initialRockPositions) {
-        if (rockPos.isValid()) {
-            blocks[rockPos.x][rockPos.y] = BlockType::ROCK;
+        if (isValidPosition(rockPos)) {
+            writeCell(rockPos.x, rockPos.y, BlockType::ROCK);
         }
     }
 }
@@ -238,19 +751,19 @@ void TerrainGrid::initializeGroundLevel() {
 }
 
 bool TerrainGrid::validateLevelData() const {
-    if (!playerStartPosition.isValid()) {
-        std::cout << "Invalid player start position" << std::endl;
+    if (!isValidPosition(playerStartPosition)) {
+        GAME_LOG_WARNING("Invalid player start position");
         return false;
     }
     
     if (monsterPositions.empty()) {
-        std::cout << "No monsters found in level" << std::endl;
+        GAME_LOG_WARNING("No monsters found in level");
         return false;
     }
     
     for (const auto& pos : monsterPositions) {
-        if (!pos.isValid()) {
-            std::cout << "Invalid monster position: (" << pos.x << ", " << pos.y << ")" << std::endl;
+        if (!isValidPosition(pos)) {
+            GAME_LOG_WARNING("Invalid monster position: (%d, %d)", pos.x, pos.y);
             return false;
         }
     }
@@ -259,26 +772,95 @@ bool TerrainGrid::validateLevelData() const {
 }
 
 void TerrainGrid::checkAllRocksForFalling() {
-    std::cout << "Checking initial rock stability..." << std::endl;
-    
-    for (int x = 0; x < WORLD_WIDTH; x++) {
-        for (int y = 0; y < WORLD_HEIGHT; y++) {
-            Position rockPos(x, y);
-            if (isBlockRock(rockPos)) {
-                Position belowPos = rockPos;
-                belowPos.y++;
-                
-                if (isValidPosition(belowPos) && isBlockEmpty(belowPos)) {
-                    std::cout << "Unstable rock at (" << x << ", " << y << ") - triggering fall!" << std::endl;
-                    triggerRockFall(rockPos);
-                }
-            }
-        }
+    GAME_LOG_DEBUG("Checking initial rock stability...");
+    
+    rebuildRockStability();
+    triggerUnstableRocks();
+}
+
+void TerrainGrid::rebuildRockStability() {
+    for (const auto& pos : dirtyCells) {
+        findChunk(pos.x, pos.y)->dirtyBits[pos.y % CHUNK_SIZE] &= ~cellBit(pos.x);
+    }
+    dirtyCells.clear();
+    
+    collectUnsupportedRocks(unstableRocks);
+}
+
+void TerrainGrid::checkDirtyRocksForFalling() {
+    // A change can only affect the rock in the changed cell or the one above it
+    for (const auto& pos : dirtyCells) {
+        findChunk(pos.x, pos.y)->dirtyBits[pos.y % CHUNK_SIZE] &= ~cellBit(pos.x);
+        updateRockStability(pos);
+        updateRockStability(Position(pos.x, pos.y - 1));
+    }
+    dirtyCells.clear();
+    
+    triggerUnstableRocks();
+}
+
+void TerrainGrid::markDirty(const Position& pos) {
+    uint64_t& dirtyRow = touchChunk(pos.x, pos.y).dirtyBits[pos.y % CHUNK_SIZE];
+    if (!(dirtyRow & cellBit(pos.x))) {
+        dirtyRow |= cellBit(pos.x);
+        dirtyCells.push_back(pos);
+    }
+}
+
+void TerrainGrid::logChange(const Position& pos) {
+    revision++;
+    if (changeLog.empty()) {
+        changeLog.resize(CHANGE_LOG_SIZE);
+    }
+    changeLog[revision % CHANGE_LOG_SIZE] = pos;
+}
+
+bool TerrainGrid::getChangesSince(unsigned long long sinceRevision, std::vector<Position>& cells) const {
+    if (sinceRevision < changeLogStart || sinceRevision > revision ||
+        revision - sinceRevision > (unsigned long long)CHANGE_LOG_SIZE) {
+        return false;
+    }
+    for (unsigned long long r = sinceRevision + 1; r <= revision; r++) {
+        cells.push_back(changeLog[r % CHANGE_LOG_SIZE]);
+    }
+    return true;
+}
+
+void TerrainGrid::updateRockStability(const Position& pos) {
+    if (!isValidPosition(pos)) {
+        return;
+    }
+    
+    long long key = (long long)pos.x * height + pos.y;
+    auto it = std::lower_bound(unstableRocks.begin(), unstableRocks.end(), key);
+    bool listed = it != unstableRocks.end() && *it == key;
+    bool unstable = isUnstableRock(pos);
+    
+    if (unstable && !listed) {
+        unstableRocks.insert(it, key);
+    } else if (!unstable && listed) {
+        unstableRocks.erase(it);
+    }
+}
+
+bool TerrainGrid::isUnstableRock(const Position& pos) const {
+    Position belowPos = pos;
+    belowPos.y++;
+    return isBlockRock(pos) && isValidPosition(belowPos) && isBlockEmpty(belowPos);
+}
+
+void TerrainGrid::triggerUnstableRocks() {
+    // Rocks stay listed until they fall (removeRockAt), exactly like a rescan
+    // would keep finding them
+    for (long long key : unstableRocks) {
+        Position rockPos((int)(key / height), (int)(key % height));
+        GAME_LOG_DEBUG("Unstable rock at (%d, %d) - triggering fall!", rockPos.x, rockPos.y);
+        triggerRockFall(rockPos);
     }
 }
 
 raylib::Color TerrainGrid::getBlockColor(const Position& pos) const {
-    switch (blocks[pos.x][pos.y]) {
+    switch (getBlockType(pos)) {
         case BlockType::SOLID:
             return raylib::Color(139, 69, 19, 255); // Brown
         case BlockType::EMPTY:
@@ -290,41 +872,48 @@ raylib::Color TerrainGrid::getBlockColor(const Position& pos) const {
     }
 }
 void TerrainGrid::draw() const {
-    SpriteManager* spriteManager = SpriteManager::getInstance();
+    // Large maps extend past the window; only draw the part that is on screen
+    int visibleWidth = std::min(width, GetScreenWidth() / Position::BLOCK_SIZE + 1);
+    int visibleHeight = std::min(height, GetScreenHeight() / Position::BLOCK_SIZE + 1);
     
-    for (int x = 0; x < WORLD_WIDTH; x++) {
-        for (int y = 0; y < WORLD_HEIGHT; y++) {
-            Position worldPos(x, y);
-            Position pixelPos = worldPos.toPixels();
-            
-            // Try to use sprites first
-            SpriteManager::SpriteType spriteType;
-            bool useSprite = false;
-            
-            switch (blocks[x][y]) {
-                case BlockType::SOLID:
-                    spriteType = SpriteManager::DIRT_BLOCK;
-                    useSprite = spriteManager->isSpriteLoaded(spriteType);
-                    break;
-                case BlockType::ROCK:
-                    spriteType = SpriteManager::ROCK_BLOCK;
-                    useSprite = spriteManager->isSpriteLoaded(spriteType);
-                    break;
-                case BlockType::EMPTY:
-                    spriteType = SpriteManager::TUNNEL_EMPTY;
-                    useSprite = spriteManager->isSpriteLoaded(spriteType);
-                    break;
-            }
-            
-            if (useSprite) {
-                spriteManager->drawSprite(spriteType, worldPos);
-            } else {
-                // Fallback to original color rectangles
-                raylib::Color blockColor = getBlockColor(worldPos);
-                DrawRectangle(pixelPos.x, pixelPos.y,
-                             Position::BLOCK_SIZE, Position::BLOCK_SIZE,
-                             blockColor);
-            }
+    for (int x = 0; x < visibleWidth; x++) {
+        for (int y = 0; y < visibleHeight; y++) {
+            drawCell(x, y);
         }
     }
 }
+
+void TerrainGrid::drawCell(int x, int y) const {
+    SpriteManager* spriteManager = SpriteManager::getInstance();
+    Position worldPos(x, y);
+    Position pixelPos = worldPos.toPixels();
+    
+    // Try to use sprites first
+    SpriteManager::SpriteType spriteType;
+    bool useSprite = false;
+    
+    switch (cellAt(x, y)) {
+        case BlockType::SOLID:
+            spriteType = SpriteManager::DIRT_BLOCK;
+            useSprite = spriteManager->isSpriteLoaded(spriteType);
+            break;
+        case BlockType::ROCK:
+            spriteType = SpriteManager::ROCK_BLOCK;
+            useSprite = spriteManager->isSpriteLoaded(spriteType);
+            break;
+        case BlockType::EMPTY:
+            spriteType = SpriteManager::TUNNEL_EMPTY;
+            useSprite = spriteManager->isSpriteLoaded(spriteType);
+            break;
+    }
+    
+    if (useSprite) {
+        spriteManager->drawSprite(spriteType, worldPos);
+    } else {
+        // Fallback to original color rectangles
+        raylib::Color blockColor = getBlockColor(worldPos);
+        DrawRectangle(pixelPos.x, pixelPos.y,
+                     Position::BLOCK_SIZE, Position::BLOCK_SIZE,
+                     blockColor);
+    }
+}
@@ -1,8 +1,11 @@
 #ifndef TERRAINGRID_H
 #define TERRAINGRID_H
 
+#include "GameSnapshot.h"
 #include "Position.h"
 #include <raylib-cpp.hpp>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -12,24 +15,134 @@ enum class BlockType {
     ROCK
 };
 
+/**
+ * @brief Block grid for one level, sized at runtime and stored in chunks
+ *
+ * Cells live in CHUNK_SIZE x CHUNK_SIZE chunks laid out row-major. Inside a
+ * chunk each block type is a bitplane with one 64-bit word per row (bit n is
+ * column n), so a cell costs 2 bits and row queries such as "rocks with an
+ * empty cell below" handle 64 cells per operation. A cell with neither its
+ * rock nor its empty bit set is solid earth, which is why chunks that are
+ * still untouched solid earth are never allocated at all.
+ */
 class TerrainGrid {
 public:
-    static const int WORLD_WIDTH = 40;
-    static const int WORLD_HEIGHT = 30;
-    
+    static const int DEFAULT_WIDTH = 40;   // used by levels without a SIZE line
+    static const int DEFAULT_HEIGHT = 30;
+    static const int CHUNK_SIZE = 64;  // one bitplane row per uint64_t
+    static const int CHANGE_LOG_SIZE = 1024;  // recent cell changes kept for getChangesSince
+
 private:
-    BlockType blocks[WORLD_WIDTH][WORLD_HEIGHT];
+    struct Chunk {
+        uint64_t rockBits[CHUNK_SIZE];
+        uint64_t emptyBits[CHUNK_SIZE];
+        uint64_t dirtyBits[CHUNK_SIZE];  // cells queued in dirtyCells
+        
+        Chunk();
+    };
+    
+    int width;
+    int height;
+    int chunksWide;
+    int chunksHigh;
+    std::vector<std::unique_ptr<Chunk>> chunks;  // nullptr = all solid
+    unsigned long long revision;  // bumped on every block change
+    
     std::vector<Position> initialRockPositions;
     Position playerStartPosition;
     std::vector<Position> monsterPositions;
     bool levelLoaded;
     std::vector<Position> triggeredRockFalls;
     
+    // Incremental rock stability: cells changed since the last check, and
+    // every rock currently resting on an empty cell (column-major cell keys,
+    // kept sorted so triggers come out in the same order as a full scan)
+    std::vector<Position> dirtyCells;
+    std::vector<long long> unstableRocks;
+    
+    // Ring of the last CHANGE_LOG_SIZE changed cells; the cell changed by
+    // revision r is at r % CHANGE_LOG_SIZE. Bulk edits (resize, level load)
+    // are not logged, they move changeLogStart past themselves instead.
+    std::vector<Position> changeLog;
+    unsigned long long changeLogStart;
+
 public:
     TerrainGrid(int levelNumber = 1);
     
+    /**
+     * @brief Create a blank grid of solid earth, for generated and stress levels
+     * @param gridWidth Width in blocks
+     * @param gridHeight Height in blocks
+     */
+    TerrainGrid(int gridWidth, int gridHeight);
+    
+    TerrainGrid(const TerrainGrid& other);
+    TerrainGrid& operator=(const TerrainGrid& other);
+    TerrainGrid(TerrainGrid&& other) = default;
+    TerrainGrid& operator=(TerrainGrid&& other) = default;
+    
     bool loadFromFile(const std::string& filename);
     
+    /**
+     * @brief Load a level in the binary format (see LevelFile)
+     *
+     * Checks the header, tables and bitplanes, then runs the same validation
+     * as loadFromFile. The grid is only changed once the structure checks pass.
+     * @param data Level data, e.g. a mapped file or resource pack entry
+     * @param size Size of data in bytes
+     * @param name File or entry name, for log messages
+     * @return False if the data is malformed or fails level validation
+     */
+    bool loadBinary(const uint8_t* data, size_t size, const std::string& name);
+    
+    /**
+     * @brief Map a binary level file and load it with loadBinary
+     * @param filename Level file
+     * @return False if the file is missing, malformed or fails validation
+     */
+    bool loadBinaryFile(const std::string& filename);
+    
+    /**
+     * @brief Append this level in the binary format
+     * @param out Buffer to append to
+     */
+    void writeBinary(std::vector<uint8_t>& out) const;
+    
+    /**
+     * @brief Write this level as a binary level file
+     * @param filename File to create
+     * @return False if the file could not be written
+     */
+    bool saveBinaryFile(const std::string& filename) const;
+    
+    /**
+     * @brief Append the blocks and rock-fall bookkeeping to a snapshot
+     *
+     * Spawn tables are left out: they only matter when a level is set up.
+     * @param out Snapshot being written
+     */
+    void saveState(GameSnapshot& out) const;
+    
+    /**
+     * @brief Read back what saveState wrote
+     *
+     * Counts as a bulk edit: the revision moves on and getChangesSince
+     * reports everything as changed.
+     * @param in Snapshot being read
+     * @return False if the data is truncated, the size is out of range or the
+     *         rock stability lists don't fit the grid
+     */
+    bool restoreState(GameSnapshot::Reader& in);
+    
+    /**
+     * @brief Exchange what saveState covers with another grid
+     *
+     * Level data (start positions) stays put. Counts as a bulk edit on both
+     * grids, like restoreState.
+     * @param other Grid to swap with, typically one a snapshot was just restored into
+     */
+    void swapState(TerrainGrid& other);
+    
     bool isBlockSolid(const Position& pos) const;
     bool isBlockRock(const Position& pos) const;
     bool isBlockEmpty(const Position& pos) const;
@@ -41,8 +154,70 @@ public:
     bool isValidPosition(const Position& pos) const;
     bool isLevelLoaded() const { return levelLoaded; }
     
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getAllocatedChunkCount() const;
+    unsigned long long getRevision() const { return revision; }
+    
+    /**
+     * @brief List the cells changed after a given revision, oldest first
+     * @param sinceRevision Revision the caller last saw
+     * @param cells Receives the changed cells (a cell changed twice is listed twice)
+     * @return False if the changes are no longer known (too many, or a bulk edit);
+     *         the caller must then treat the whole grid as changed
+     */
+    bool getChangesSince(unsigned long long sinceRevision, std::vector<Position>& cells) const;
+    
+    /**
+     * @brief Count tunnel (empty) cells, 64 cells per popcount
+     * @return Number of empty cells in the grid
+     */
+    long long countDugCells() const;
+    
+    /**
+     * @brief Count rock cells, 64 cells per popcount
+     * @return Number of rock cells in the grid
+     */
+    long long countRocks() const;
+    
+    /**
+     * @brief Check whether a whole row has been dug out
+     * @param y Row to check
+     * @return True if every cell in the row is empty
+     */
+    bool isRowEmpty(int y) const;
+    
+    /**
+     * @brief Find every rock resting on an empty cell, one word per chunk row
+     * @return Rock positions in column-major order (the order a full scan finds them)
+     */
+    std::vector<Position> findUnsupportedRocks() const;
+    
+    /**
+     * @brief Bounds check that falls back to the default world without a grid
+     * @param terrain Grid to check against, may be nullptr
+     * @param pos Position to check
+     * @return True if pos is inside the grid (or the default world)
+     */
+    static bool isInside(const TerrainGrid* terrain, const Position& pos);
+    
+    /**
+     * @brief Tunnel check for wandering, which never digs
+     * @param terrain Grid to check against, may be nullptr
+     * @param pos Position to check
+     * @return True if pos is an empty cell (or inside the default world without a grid)
+     */
+    static bool isOpen(const TerrainGrid* terrain, const Position& pos);
+    
     void draw() const;
     
+    /**
+     * @brief Draw a single cell (sprite, or a coloured square without sprites)
+     * @param x Column
+     * @param y Row
+     */
+    void drawCell(int x, int y) const;
+    
     // Enhanced position getters
     Position getPlayerStartPosition() const { return playerStartPosition; }
     const std::vector<Position>& getMonsterPositions() const { return monsterPositions; }
@@ -52,13 +227,43 @@ public:
     void triggerRockFall(const Position& rockPos);
     std::vector<Position> getTriggeredRockFalls();
     void removeRockAt(const Position& pos);
+    
+    /**
+     * @brief Trigger every unsupported rock by scanning the whole grid
+     *
+     * Also rebuilds the incremental stability state, so call it after the
+     * grid has been edited without going through setBlock.
+     */
     void checkAllRocksForFalling();
     
+    /**
+     * @brief Trigger every unsupported rock, only re-evaluating changed cells
+     *
+     * Produces the same triggers, in the same order, as checkAllRocksForFalling
+     * but costs O(changes) instead of O(grid).
+     */
+    void checkDirtyRocksForFalling();
+
 private:
+    void resize(int gridWidth, int gridHeight);
+    Chunk* findChunk(int x, int y) const;
+    Chunk& touchChunk(int x, int y);
+    static uint64_t cellBit(int x) { return uint64_t(1) << (x % CHUNK_SIZE); }
+    uint64_t rowMask(int chunkX) const;
+    uint64_t emptyRowBits(int chunkX, int y) const;
+    void collectUnsupportedRocks(std::vector<long long>& keys) const;
+    BlockType cellAt(int x, int y) const;
+    void writeCell(int x, int y, BlockType type);
     void createDefaultLevel();
     void initializeGroundLevel();
     raylib::Color getBlockColor(const Position& pos) const;
     bool validateLevelData() const;
+    void rebuildRockStability();
+    void markDirty(const Position& pos);
+    void logChange(const Position& pos);
+    void updateRockStability(const Position& pos);
+    bool isUnstableRock(const Position& pos) const;
+    void triggerUnstableRocks();
 };
 
 #endif // TERRAINGRID_H
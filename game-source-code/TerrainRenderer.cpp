@@ -0,0 +1,158 @@
+#include "TerrainRenderer.h"
+#include "TerrainGrid.h"
+#include "SpriteManager.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+
+TerrainRenderer::TerrainRenderer()
+    : target(), hasTarget(false), valid(false), drawnRevision(0), tilesWide(0), tilesHigh(0),
+      spriteReach(0), lastRedrawCount(0) {
+}
+
+TerrainRenderer::~TerrainRenderer() {
+    if (hasTarget) {
+        UnloadRenderTexture(target);
+    }
+}
+
+int TerrainRenderer::computeSpriteReach() {
+    SpriteManager* spriteManager = SpriteManager::getInstance();
+    const SpriteManager::SpriteType terrainSprites[] = {
+        SpriteManager::DIRT_BLOCK, SpriteManager::ROCK_BLOCK, SpriteManager::TUNNEL_EMPTY
+    };
+    
+    int reach = 0;
+    for (SpriteManager::SpriteType type : terrainSprites) {
+        if (!spriteManager->isSpriteLoaded(type)) {
+            continue;
+        }
+        raylib::Vector2 size = spriteManager->getSpriteSize(type);
+        int cells = (int)std::ceil(std::max(size.x, size.y) / Position::BLOCK_SIZE);
+        reach = std::max(reach, cells - 1);
+    }
+    return reach;
+}
+
+bool TerrainRenderer::ensureTarget(int width, int height) {
+    if (hasTarget && target.texture.width == width && target.texture.height == height) {
+        return true;
+    }
+    if (hasTarget) {
+        UnloadRenderTexture(target);
+        hasTarget = false;
+    }
+    
+    target = LoadRenderTexture(width, height);
+    if (target.id == 0) {
+        GAME_LOG_WARNING("Could not create %dx%d terrain texture, drawing terrain directly", width, height);
+        return false;
+    }
+    hasTarget = true;
+    return true;
+}
+
+void TerrainRenderer::update(const TerrainGrid& terrain) {
+    int wide = std::min(terrain.getWidth(), GetScreenWidth() / Position::BLOCK_SIZE + 1);
+    int high = std::min(terrain.getHeight(), GetScreenHeight() / Position::BLOCK_SIZE + 1);
+    if (wide != tilesWide || high != tilesHigh) {
+        tilesWide = wide;
+        tilesHigh = high;
+        valid = false;
+    }
+    
+    if (!ensureTarget(tilesWide * Position::BLOCK_SIZE, tilesHigh * Position::BLOCK_SIZE)) {
+        valid = false;
+        return;
+    }
+    
+    if (valid && drawnRevision == terrain.getRevision()) {
+        lastRedrawCount = 0;
+        return;
+    }
+    
+    changedCells.clear();
+    bool incremental = valid && terrain.getChangesSince(drawnRevision, changedCells);
+    if (incremental) {
+        collectDirtyTiles(changedCells, spriteReach, tilesWide, tilesHigh);
+    }
+    
+    // Each dirty tile costs up to (reach + 1)^2 clipped draws; past a
+    // quarter of the screen a full redraw is cheaper
+    if (incremental && (int)changedCells.size() * 4 > tilesWide * tilesHigh) {
+        incremental = false;
+    }
+    
+    BeginTextureMode(target);
+    if (incremental) {
+        for (const Position& tile : changedCells) {
+            redrawCell(terrain, tile);
+        }
+        lastRedrawCount = (int)changedCells.size();
+    } else {
+        redrawAll(terrain);
+        lastRedrawCount = -1;
+    }
+    EndTextureMode();
+    
+    drawnRevision = terrain.getRevision();
+    valid = true;
+}
+
+void TerrainRenderer::collectDirtyTiles(std::vector<Position>& cells, int reach, int tilesWide, int tilesHigh) {
+    // The cell's own tile plus every tile its sprite spills over
+    size_t changed = cells.size();
+    for (size_t i = 0; i < changed; i++) {
+        Position cell = cells[i];
+        for (int x = cell.x; x <= cell.x + reach; x++) {
+            for (int y = cell.y; y <= cell.y + reach; y++) {
+                if (x != cell.x || y != cell.y) {
+                    cells.push_back(Position(x, y));
+                }
+            }
+        }
+    }
+    
+    auto offScreen = [&](const Position& tile) { return tile.x >= tilesWide || tile.y >= tilesHigh; };
+    cells.erase(std::remove_if(cells.begin(), cells.end(), offScreen), cells.end());
+    std::sort(cells.begin(), cells.end(),
+        [](const Position& a, const Position& b) { return a.x != b.x ? a.x < b.x : a.y < b.y; });
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+}
+
+void TerrainRenderer::redrawAll(const TerrainGrid& terrain) {
+    // Sprites may have been loaded since the last full redraw
+    spriteReach = computeSpriteReach();
+    
+    ClearBackground(BLACK);
+    for (int x = 0; x < tilesWide; x++) {
+        for (int y = 0; y < tilesHigh; y++) {
+            terrain.drawCell(x, y);
+        }
+    }
+}
+
+void TerrainRenderer::redrawCell(const TerrainGrid& terrain, const Position& cell) {
+    Position pixelPos = cell.toPixels();
+    BeginScissorMode(pixelPos.x, pixelPos.y, Position::BLOCK_SIZE, Position::BLOCK_SIZE);
+    DrawRectangle(pixelPos.x, pixelPos.y, Position::BLOCK_SIZE, Position::BLOCK_SIZE, BLACK);
+    
+    // Same column-major order as TerrainGrid::draw, so overlaps come out the same
+    for (int x = std::max(0, cell.x - spriteReach); x <= cell.x; x++) {
+        for (int y = std::max(0, cell.y - spriteReach); y <= cell.y; y++) {
+            terrain.drawCell(x, y);
+        }
+    }
+    EndScissorMode();
+}
+
+void TerrainRenderer::draw(const TerrainGrid& terrain) const {
+    if (!hasTarget || !valid) {
+        terrain.draw();
+        return;
+    }
+    
+    // Render textures are stored upside down
+    Rectangle source = { 0.0f, 0.0f, (float)target.texture.width, -(float)target.texture.height };
+    DrawTextureRec(target.texture, source, Vector2{ 0.0f, 0.0f }, WHITE);
+}
@@ -0,0 +1,82 @@
+#ifndef TERRAINRENDERER_H
+#define TERRAINRENDERER_H
+
+#include "Position.h"
+#include <raylib-cpp.hpp>
+#include <vector>
+
+class TerrainGrid;
+
+/**
+ * @brief Keeps the visible terrain composited in an offscreen texture
+ *
+ * The texture is only touched where the grid changed since the last frame
+ * (found through TerrainGrid::getChangesSince), so a frame with no digging
+ * costs a single textured quad instead of one draw per cell.
+ *
+ * Terrain sprites are drawn at 2x and overlap the cells to their right and
+ * below. A changed cell therefore dirties every tile its sprite reaches, and
+ * each dirty tile is repainted by redrawing, clipped to that tile, every cell
+ * whose sprite reaches into it, in the same order as a full draw.
+ */
+class TerrainRenderer {
+private:
+    RenderTexture2D target;
+    bool hasTarget;
+    bool valid;                        // texture matches drawnRevision
+    unsigned long long drawnRevision;
+    int tilesWide;
+    int tilesHigh;
+    int spriteReach;                   // cells a terrain sprite spills over to the right/below
+    int lastRedrawCount;
+    std::vector<Position> changedCells;
+
+public:
+    TerrainRenderer();
+    ~TerrainRenderer();
+    
+    TerrainRenderer(const TerrainRenderer&) = delete;
+    TerrainRenderer& operator=(const TerrainRenderer&) = delete;
+    
+    /**
+     * @brief Force a full redraw on the next update (e.g. after a new level is loaded)
+     */
+    void invalidate() { valid = false; }
+    
+    /**
+     * @brief Bring the texture up to date with the grid
+     *
+     * Call before any matrix is pushed for the frame: texture mode resets
+     * the modelview matrix.
+     * @param terrain Grid to show
+     */
+    void update(const TerrainGrid& terrain);
+    
+    /**
+     * @brief Draw the terrain, from the texture when there is one
+     * @param terrain Grid to draw directly if no texture could be created
+     */
+    void draw(const TerrainGrid& terrain) const;
+    
+    /**
+     * @brief Number of cells repainted by the last update (-1 = full redraw)
+     */
+    int getLastRedrawCount() const { return lastRedrawCount; }
+    
+    /**
+     * @brief Turn a list of changed cells into the tiles that must be repainted
+     * @param cells Changed cells in; dirty tiles out, column-major and without duplicates
+     * @param reach Tiles a sprite spills over to the right and below
+     * @param tilesWide Tiles on screen horizontally; tiles beyond are dropped
+     * @param tilesHigh Tiles on screen vertically
+     */
+    static void collectDirtyTiles(std::vector<Position>& cells, int reach, int tilesWide, int tilesHigh);
+
+private:
+    bool ensureTarget(int width, int height);
+    void redrawAll(const TerrainGrid& terrain);
+    void redrawCell(const TerrainGrid& terrain, const Position& cell);
+    static int computeSpriteReach();
+};
+
+#endif // TERRAINRENDERER_H
@@ -0,0 +1,120 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(int threadCount) : jobGeneration(0), remaining(0), stopping(false) {
+    if (threadCount <= 0) {
+        threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+WorkerPool* WorkerPool::getInstance() {
+    static WorkerPool instance(0);
+    return &instance;
+}
+
+void WorkerPool::parallelFor(int count, int chunkSize, const Body& body) {
+    if (count <= 0) {
+        return;
+    }
+    chunkSize = std::max(1, chunkSize);
+    
+    // Nothing to share out: skip the queues and the wake-ups
+    if (workers.empty() || count <= chunkSize) {
+        body(0, count);
+        return;
+    }
+    
+    // Count first: a worker still looking for work from the last job can pick
+    // a chunk up the moment it is queued
+    int chunkCount = (count + chunkSize - 1) / chunkSize;
+    remaining.store(chunkCount, std::memory_order_release);
+    
+    for (int chunk = 0; chunk < chunkCount; chunk++) {
+        int begin = chunk * chunkSize;
+        Queue& queue = *queues[chunk % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.chunks.push_back({ begin, std::min(count, begin + chunkSize), &body });
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobGeneration++;
+    }
+    jobReady.notify_all();
+    
+    runChunks(0);
+    
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobDone.wait(lock, [this] { return remaining.load(std::memory_order_acquire) == 0; });
+}
+
+bool WorkerPool::popOwn(int queue, Chunk& chunk) {
+    Queue& own = *queues[queue];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.chunks.empty()) {
+        return false;
+    }
+    chunk = own.chunks.back();
+    own.chunks.pop_back();
+    return true;
+}
+
+bool WorkerPool::steal(int thief, Chunk& chunk) {
+    int count = (int)queues.size();
+    for (int offset = 1; offset < count; offset++) {
+        Queue& victim = *queues[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty()) {
+            chunk = victim.chunks.front();
+            victim.chunks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::runChunks(int queue) {
+    Chunk chunk;
+    while (popOwn(queue, chunk) || steal(queue, chunk)) {
+        (*chunk.body)(chunk.begin, chunk.end);
+        
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Take the lock so the caller can't miss the wake-up between its check and its wait
+            std::lock_guard<std::mutex> lock(jobMutex);
+            jobDone.notify_all();
+        }
+    }
+}
+
+void WorkerPool::workerLoop(int queue) {
+    uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [&] { return stopping || jobGeneration != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = jobGeneration;
+        }
+        runChunks(queue);
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads for data-parallel loops, with work stealing
+ *
+ * parallelFor() cuts an index range into chunks and deals them out
+ * round-robin to one queue per participant (the calling thread is one of
+ * them). Each participant works through its own queue from the back and,
+ * once that is empty, steals from the front of the others, so a chunk that
+ * turns out slow doesn't leave the other threads idle. The call returns
+ * when every chunk has run.
+ *
+ * The loop body must only write data owned by the indices it is given;
+ * which thread runs a chunk is not deterministic.
+ */
+class WorkerPool {
+public:
+    using Body = std::function<void(int begin, int end)>;
+
+private:
+    struct Chunk {
+        int begin;
+        int end;
+        const Body* body;  // per chunk, so a late worker can never run a finished job's body
+    };
+    
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+    
+    std::vector<std::unique_ptr<Queue>> queues;  // [0] belongs to the calling thread
+    std::vector<std::thread> workers;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    uint64_t jobGeneration;
+    std::atomic<int> remaining;  // chunks of the current job not finished yet
+    bool stopping;
+
+public:
+    /**
+     * @brief Start a pool
+     * @param threadCount Threads taking part in each loop, the caller included;
+     *                    1 runs everything on the caller, 0 = one per hardware thread
+     */
+    explicit WorkerPool(int threadCount);
+    ~WorkerPool();
+    
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    
+    /**
+     * @brief Shared pool with one thread per hardware thread
+     */
+    static WorkerPool* getInstance();
+    
+    /**
+     * @brief Threads taking part in each loop, the caller included
+     */
+    int getThreadCount() const { return (int)queues.size(); }
+    
+    /**
+     * @brief Run body over [0, count) in chunks spread across the pool
+     * @param count Number of indices
+     * @param chunkSize Indices per chunk
+     * @param body Called as body(begin, end) for each chunk
+     */
+    void parallelFor(int count, int chunkSize, const Body& body);
+
+private:
+    bool popOwn(int queue, Chunk& chunk);
+    bool steal(int thief, Chunk& chunk);
+    void runChunks(int queue);
+    void workerLoop(int queue);
+};
+
+#endif // WORKERPOOL_H
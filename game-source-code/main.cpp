@@ -1,27 +1,211 @@
 #include <raylib-cpp.hpp>
 #include "Game.h"
+#include "InputProvider.h"
+#include "FixedTimestep.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "Replay.h"
+#include "ResourceCooker.h"
+#include "ResourcePack.h"
+#include "TerrainGrid.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
-int main() {
+// Runs the simulation without a window, driven by a bot, as fast as possible
+static int runHeadless(long tickCount, float tickRate, uint64_t seed, const char* recordFile,
+                       const char* traceFile) {
+    // Probes cost more than a headless tick, so only record when a trace is wanted
+    Profiler::getInstance()->setEnabled(traceFile != nullptr);
+    RandomBotInput bot(seed);
+    ReplayRecorder recorder(&bot, seed, tickRate);
+    Game game(&recorder, true, seed);
+    FixedTimestep clock(tickRate);
+    
+    auto start = std::chrono::steady_clock::now();
+    for (long tick = 0; tick < tickCount; tick++) {
+        game.beginFrame();
+        game.update(clock.getStepSeconds());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    Logger::getInstance()->flush();
+    
+    if (recordFile && !recorder.save(recordFile)) {
+        return 1;
+    }
+    if (traceFile && !Profiler::getInstance()->saveChromeTrace(traceFile)) {
+        Logger::getInstance()->flush();
+        return 1;
+    }
+    
+    double simulatedSeconds = tickCount * (double)clock.getStepSeconds();
+    std::cout << "Headless run: " << tickCount << " ticks (" << simulatedSeconds << "s simulated) in "
+              << elapsed.count() << "s, "
+              << (elapsed.count() > 0.0 ? simulatedSeconds / elapsed.count() : 0.0) << "x real time, "
+              << "level " << game.getLevel() << ", score " << game.getScore()
+              << ", " << game.getTerrain().countDugCells() << " cells dug, seed " << seed << std::endl;
+    return 0;
+}
+
+// Plays a recorded session back without a window, as fast as possible
+static int runReplay(const char* replayFile, const char* traceFile) {
+    Profiler::getInstance()->setEnabled(traceFile != nullptr);
+    ReplayInput replay;
+    if (!replay.load(replayFile)) {
+        Logger::getInstance()->flush();
+        return 1;
+    }
+    
+    Game game(&replay, true, replay.getSeed());
+    FixedTimestep clock(replay.getTickRate());
+    
+    auto start = std::chrono::steady_clock::now();
+    while (!replay.isFinished()) {
+        game.beginFrame();
+        game.update(clock.getStepSeconds());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    bool traceSaved = !traceFile || Profiler::getInstance()->saveChromeTrace(traceFile);
+    Logger::getInstance()->flush();
+    if (!traceSaved) {
+        return 1;
+    }
+    
+    Position playerPos = game.getPlayerPosition();
+    std::cout << "Replay: " << replay.getTickCount() << " ticks at " << replay.getTickRate() << " Hz in "
+              << elapsed.count() << "s, level " << game.getLevel() << ", score " << game.getScore()
+              << ", player (" << playerPos.x << ", " << playerPos.y << "), "
+              << game.getMonsterCount() << " monsters left, seed " << replay.getSeed() << std::endl;
+    return 0;
+}
+
+// Converts a text level to the binary level format
+static int convertLevel(const char* inputFile, const char* outputFile) {
+    TerrainGrid terrain(TerrainGrid::DEFAULT_WIDTH, TerrainGrid::DEFAULT_HEIGHT);
+    bool converted = terrain.loadFromFile(inputFile) && terrain.saveBinaryFile(outputFile);
+    Logger::getInstance()->flush();
+    if (!converted) {
+        return 1;
+    }
+    std::cout << "Converted " << inputFile << " (" << terrain.getWidth() << "x" << terrain.getHeight()
+              << ") to " << outputFile << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    bool headless = false;
+    long tickCount = 36000; // ten minutes of play at 60 ticks per second
+    float tickRate = 60.0f;
+    float timeScale = 1.0f;
+    uint64_t seed = Random::DEFAULT_SEED;
+    const char* recordFile = nullptr;
+    const char* replayFile = nullptr;
+    const char* traceFile = nullptr;
+    const char* cookFile = nullptr;
+    const char* packFile = ResourcePack::DEFAULT_FILENAME;
+    const char* convertInput = nullptr;
+    const char* convertOutput = nullptr;
+    
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if ((std::strcmp(argv[i], "--ticks") == 0 || std::strcmp(argv[i], "--frames") == 0) &&
+                   i + 1 < argc) {
+            // --frames predates the fixed timestep and is kept as an alias
+            tickCount = std::atol(argv[++i]);
+        } else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            tickRate = (float)std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            timeScale = (float)std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--profile-trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--cook-resources") == 0 && i + 1 < argc) {
+            cookFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--convert-level") == 0 && i + 2 < argc) {
+            convertInput = argv[++i];
+            convertOutput = argv[++i];
+        } else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            packFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (std::strcmp(name, "debug") == 0) Logger::getInstance()->setLevel(Logger::LEVEL_DEBUG);
+            else if (std::strcmp(name, "info") == 0) Logger::getInstance()->setLevel(Logger::LEVEL_INFO);
+            else if (std::strcmp(name, "warning") == 0) Logger::getInstance()->setLevel(Logger::LEVEL_WARNING);
+            else if (std::strcmp(name, "error") == 0) Logger::getInstance()->setLevel(Logger::LEVEL_ERROR);
+            else if (std::strcmp(name, "none") == 0) Logger::getInstance()->setLevel(Logger::LEVEL_NONE);
+        }
+    }
+    
+    if (tickRate <= 0.0f) {
+        tickRate = 60.0f;
+    }
+    
+    if (convertInput) {
+        return convertLevel(convertInput, convertOutput);
+    }
+    
+    if (cookFile) {
+        bool cooked = ResourceCooker::cook(cookFile);
+        Logger::getInstance()->flush();
+        return cooked ? 0 : 1;
+    }
+    
+    // Without a pack everything is loaded from the loose files under resources/
+    ResourcePack::getInstance()->open(packFile);
+    
+    if (replayFile) {
+        return runReplay(replayFile, traceFile);
+    }
+    
+    if (headless) {
+        return runHeadless(tickCount, tickRate, seed, recordFile, traceFile);
+    }
+    
     // Initialize window using raylib-cpp wrapper
     raylib::Window window(800, 600, "Dig Dug Game - v1.0");
     window.SetTargetFPS(60);
     
-    // Create game instance
-    Game game;
+    // Create game instance; input always goes through the recorder so a
+    // session can be saved with --record
+    KeyboardInput keyboard;
+    ReplayRecorder recorder(&keyboard, seed, tickRate);
+    Game game(&recorder, false, seed);
+    
+    // Simulation runs in fixed ticks independent of the render frame rate
+    FixedTimestep clock(tickRate);
+    clock.setTimeScale(timeScale);
     
     // Main game loop
     while (!window.ShouldClose()) {
         // Update game logic
-        game.update(window.GetFrameTime());
+        game.beginFrame();
+        int ticks = clock.advance(window.GetFrameTime());
+        for (int i = 0; i < ticks; i++) {
+            game.update(clock.getStepSeconds());
+        }
         
         // Draw everything
         BeginDrawing();
         ClearBackground(BLACK);
         
-        game.draw();
+        game.draw(clock.getInterpolationAlpha());
         
         EndDrawing();
     }
     
+    if (recordFile && !recorder.save(recordFile)) {
+        return 1;
+    }
+    if (traceFile && !Profiler::getInstance()->saveChromeTrace(traceFile)) {
+        return 1;
+    }
+    
     return 0;
 }
@@ -4,10 +4,58 @@
 #include "../game-source-code/Position.h"
 #include "../game-source-code/Player.h"
 #include "../game-source-code/Monster.h"
+#include "../game-source-code/MonsterStore.h"
+#include "../game-source-code/BehaviorKernel.h"
+#include "../game-source-code/WorkerPool.h"
 #include "../game-source-code/Projectile.h"
 #include "../game-source-code/PowerUp.h"
 #include "../game-source-code/FallingRock.h"
 #include "../game-source-code/TerrainGrid.h"
+#include "../game-source-code/TerrainRenderer.h"
+#include "../game-source-code/InputProvider.h"
+#include "../game-source-code/FixedTimestep.h"
+#include "../game-source-code/Logger.h"
+#include "../game-source-code/FlowField.h"
+#include "../game-source-code/ProjectilePool.h"
+#include "../game-source-code/GameSnapshot.h"
+#include "../game-source-code/SpatialIndex.h"
+#include "../game-source-code/Random.h"
+#include "../game-source-code/Replay.h"
+#include "../game-source-code/Profiler.h"
+#include "../game-source-code/ResourcePack.h"
+#include "../game-source-code/LevelFile.h"
+#include "../game-source-code/LevelLoader.h"
+#include "../game-source-code/ResourceCooker.h"
+#include <sstream>
+#include <atomic>
+#include <functional>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "../game-source-code/Game.h"
+
+static std::vector<Position> findEmptyCells(const TerrainGrid& grid) {
+    std::vector<Position> cells;
+    for (int y = 0; y < grid.getHeight(); y++) {
+        for (int x = 0; x < grid.getWidth(); x++) {
+            if (grid.isBlockEmpty(Position(x, y))) {
+                cells.push_back(Position(x, y));
+            }
+        }
+    }
+    return cells;
+}
+
+// Monster i of a crowd spread over the open cells, on its own random stream;
+// with dragons, every third one is a dragon
+static Monster makeCrowdMonster(const std::vector<Position>& openCells, int i, TerrainGrid& terrain,
+                                uint64_t seed, bool dragons) {
+    Monster::MonsterType type = (dragons && i % 3 == 0) ? Monster::GREEN_DRAGON : Monster::RED_MONSTER;
+    Monster monster(openCells[(size_t)i * 37 % openCells.size()], type, &terrain);
+    monster.seedRandom(seed, Random::MONSTER_STREAM_BASE + i);
+    return monster;
+}
 
 TEST_CASE("Position class functionality") {
     SUBCASE("Basic position operations") {
@@ -470,6 +518,29 @@ TEST_CASE("PowerUp tests") {
         powerUp.update(0.5f);
         CHECK_FALSE(powerUp.isCollected());
     }
+    
+    SUBCASE("Snapshot states with an unknown type are rejected") {
+        std::vector<PowerUp> powerUps = { PowerUp(Position(1, 1), PowerUp::SPEED_BOOST),
+                                          PowerUp(Position(2, 2), PowerUp::INVULNERABILITY) };
+        PowerUp::SavedState bad = powerUps[1].getSavedState();
+        CHECK(bad.isValid());
+        uint32_t unknown = 4;
+        std::memcpy(&bad.type, &unknown, sizeof(bad.type));
+        CHECK_FALSE(bad.isValid());
+        
+        GameSnapshot snapshot;
+        snapshot.beginWrite();
+        snapshot.writeStates(powerUps);
+        snapshot.write((uint32_t)1);
+        snapshot.write(bad);
+        snapshot.endWrite();
+        GameSnapshot::Reader in(snapshot);
+        std::vector<PowerUp> restored;
+        CHECK(in.readStates(restored));
+        CHECK(restored.size() == 2);
+        CHECK_FALSE(in.readStates(restored));
+        CHECK_FALSE(in.isValid());
+    }
 }
 
 TEST_CASE("TerrainGrid tests") {
@@ -627,4 +698,1947 @@ TEST_CASE("Edge case tests") {
         CHECK(topPos.isValid());
         CHECK(bottomPos.isValid());
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Headless game simulation") {
+    SUBCASE("Scripted input state") {
+        ScriptedInput input;
+        input.hold(InputState::MOVE_LEFT);
+        input.press(InputState::FIRE);
+        
+        InputState first = input.poll();
+        CHECK(first.isDown(InputState::MOVE_LEFT));
+        CHECK(first.isPressed(InputState::FIRE));
+        
+        InputState second = input.poll();
+        CHECK(second.isDown(InputState::MOVE_LEFT));
+        CHECK_FALSE(second.isPressed(InputState::FIRE));
+    }
+    
+    SUBCASE("Game runs without a window") {
+        ScriptedInput input;
+        Game game(&input, true);
+        
+        CHECK(game.isHeadless());
+        CHECK(game.isOnSplashScreen());
+        
+        input.press(InputState::CONFIRM);
+        game.update(1.0f / 60.0f);
+        CHECK_FALSE(game.isOnSplashScreen());
+        
+        Position startPos = game.getPlayerPosition();
+        input.hold(InputState::MOVE_DOWN);
+        for (int i = 0; i < 30; i++) {
+            game.update(1.0f / 60.0f);
+        }
+        CHECK(game.getPlayerPosition().y > startPos.y);
+        
+        game.draw(); // no-op without a window
+    }
+    
+    SUBCASE("Starting a level directly skips the splash screen") {
+        ScriptedInput input;
+        Game game(&input, true);
+        
+        game.startLevel(3);
+        CHECK_FALSE(game.isOnSplashScreen());
+        CHECK(game.getLevel() == 3);
+        CHECK(game.getScore() == 0);
+        CHECK(game.getMonsterCount() == (int)TerrainGrid(3).getMonsterPositions().size());
+        CHECK(game.getPlayerPosition() == TerrainGrid(3).getPlayerStartPosition());
+    }
+    
+    SUBCASE("Injected input fires the harpoon") {
+        ScriptedInput input;
+        Game game(&input, true);
+        
+        input.press(InputState::CONFIRM);
+        game.update(1.0f / 60.0f);
+        CHECK(game.getProjectileCount() == 0);
+        
+        input.press(InputState::FIRE);
+        game.update(1.0f / 60.0f);
+        CHECK(game.getProjectileCount() == 1);
+    }
+}
+
+
+TEST_CASE("Fixed timestep simulation clock") {
+    SUBCASE("Frame time is split into whole ticks") {
+        FixedTimestep clock(60.0f);
+        
+        CHECK(clock.advance(1.0f / 30.0f) == 2);
+        CHECK(clock.advance(0.004f) == 0);
+        CHECK(clock.getInterpolationAlpha() > 0.0f);
+        CHECK(clock.getInterpolationAlpha() < 1.0f);
+    }
+    
+    SUBCASE("Uneven frames add up to the same number of ticks") {
+        FixedTimestep clock(60.0f);
+        const float frames[] = {0.0078125f, 0.03125f, 0.015625f, 0.0234375f, 0.001953125f};
+        
+        int ticks = 0;
+        double elapsed = 0.0;
+        while (elapsed < 1.0) {
+            for (float frame : frames) {
+                ticks += clock.advance(frame);
+                elapsed += frame;
+            }
+        }
+        
+        CHECK(ticks == (int)(elapsed * 60.0));
+        CHECK(clock.getTickCount() == ticks);
+    }
+    
+    SUBCASE("Long hitches are clamped") {
+        FixedTimestep clock(60.0f, 5);
+        
+        CHECK(clock.advance(2.0f) == 5);
+        CHECK(clock.advance(0.0f) == 0);
+    }
+    
+    SUBCASE("Time scale runs faster than real time") {
+        FixedTimestep clock(60.0f);
+        clock.setTimeScale(10.0f);
+        
+        int ticks = 0;
+        for (int frame = 0; frame < 64; frame++) {
+            ticks += clock.advance(0.015625f);
+        }
+        CHECK(ticks == 600); // one real second is ten simulated seconds
+    }
+    
+    SUBCASE("Configurable tick rate") {
+        FixedTimestep clock(120.0f);
+        
+        CHECK(clock.getStepSeconds() == doctest::Approx(1.0f / 120.0f));
+        CHECK(clock.advance(0.0625f) == 7);
+    }
+    
+    SUBCASE("Render offset interpolates single steps") {
+        Monster monster(Position(10, 10), Monster::RED_MONSTER);
+        monster.storePreviousPosition();
+        monster.moveRight();
+        
+        Vector2 start = monster.getRenderOffset(0.0f);
+        Vector2 halfway = monster.getRenderOffset(0.5f);
+        Vector2 end = monster.getRenderOffset(1.0f);
+        
+        CHECK(start.x == doctest::Approx(-Position::BLOCK_SIZE));
+        CHECK(halfway.x == doctest::Approx(-Position::BLOCK_SIZE / 2.0f));
+        CHECK(end.x == doctest::Approx(0.0f));
+        CHECK(end.y == doctest::Approx(0.0f));
+    }
+}
+
+
+TEST_CASE("Asynchronous logger") {
+    Logger* logger = Logger::getInstance();
+    std::ostringstream output;
+    logger->setSink(&output);
+    Logger::Level previousLevel = logger->getLevel();
+    
+    SUBCASE("Messages are written after a flush") {
+        logger->setLevel(Logger::LEVEL_DEBUG);
+        logger->log(Logger::LEVEL_INFO, "Rock landed at (%d, %d)", 4, 7);
+        logger->log(Logger::LEVEL_WARNING, "Level %d missing", 3);
+        logger->flush();
+        
+        std::string text = output.str();
+        CHECK(text.find("[INFO] Rock landed at (4, 7)") != std::string::npos);
+        CHECK(text.find("[WARNING] Level 3 missing") != std::string::npos);
+        CHECK(text.find("Rock landed") < text.find("Level 3"));
+    }
+    
+    SUBCASE("Runtime level filter") {
+        logger->setLevel(Logger::LEVEL_WARNING);
+        logger->log(Logger::LEVEL_INFO, "hidden message");
+        logger->log(Logger::LEVEL_ERROR, "shown message");
+        logger->flush();
+        
+        CHECK(output.str().find("hidden message") == std::string::npos);
+        CHECK(output.str().find("shown message") != std::string::npos);
+    }
+    
+    SUBCASE("Compile-time filter removes disabled levels") {
+        logger->setLevel(Logger::LEVEL_DEBUG);
+        int evaluations = 0;
+        GAME_LOG_DEBUG("debug %d", ++evaluations);
+        GAME_LOG_ERROR("error %d", ++evaluations);
+        logger->flush();
+        
+        if (GAME_LOG_MIN_LEVEL > Logger::LEVEL_DEBUG) {
+            CHECK(evaluations == 1); // arguments of compiled-out calls are never evaluated
+            CHECK(output.str().find("debug") == std::string::npos);
+        }
+        CHECK(output.str().find("error") != std::string::npos);
+    }
+    
+    SUBCASE("Long messages are truncated, not overflowed") {
+        logger->setLevel(Logger::LEVEL_DEBUG);
+        std::string longText(Logger::MESSAGE_SIZE * 2, 'x');
+        logger->log(Logger::LEVEL_INFO, "%s", longText.c_str());
+        logger->flush();
+        
+        CHECK(output.str().size() < (size_t)Logger::MESSAGE_SIZE + 16);
+    }
+    
+    logger->setLevel(previousLevel);
+    logger->setSink(nullptr);
+}
+
+
+TEST_CASE("Incremental rock stability matches full scan") {
+    SUBCASE("Digging under a rock triggers it") {
+        TerrainGrid terrain;
+        terrain.checkAllRocksForFalling();
+        for (const auto& rockPos : terrain.getTriggeredRockFalls()) {
+            terrain.removeRockAt(rockPos);
+        }
+        terrain.checkDirtyRocksForFalling();
+        terrain.getTriggeredRockFalls();
+        
+        terrain.setBlock(Position(5, 10), BlockType::ROCK);
+        terrain.setBlock(Position(5, 11), BlockType::SOLID);
+        terrain.checkDirtyRocksForFalling();
+        CHECK(terrain.getTriggeredRockFalls().empty());
+        
+        terrain.digTunnelAt(Position(5, 11));
+        terrain.checkDirtyRocksForFalling();
+        auto triggered = terrain.getTriggeredRockFalls();
+        REQUIRE(triggered.size() == 1);
+        CHECK(triggered[0] == Position(5, 10));
+    }
+    
+    SUBCASE("Differential test against checkAllRocksForFalling") {
+        // Two copies of the same level receive identical edits; one is checked
+        // incrementally and the other with a full rescan every round
+        TerrainGrid incremental(1);
+        TerrainGrid fullScan = incremental;
+        incremental.checkAllRocksForFalling();
+        fullScan.checkAllRocksForFalling();
+        
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<int> randomX(0, incremental.getWidth() - 1);
+        std::uniform_int_distribution<int> randomY(0, incremental.getHeight() - 1);
+        std::uniform_int_distribution<int> randomOp(0, 9);
+        
+        int totalTriggered = 0;
+        for (int round = 0; round < 2000; round++) {
+            int edits = randomOp(rng);
+            for (int i = 0; i < edits; i++) {
+                Position pos(randomX(rng), randomY(rng));
+                int op = randomOp(rng);
+                if (op < 5) {
+                    incremental.digTunnelAt(pos);
+                    fullScan.digTunnelAt(pos);
+                } else if (op < 8) {
+                    incremental.setBlock(pos, BlockType::ROCK);
+                    fullScan.setBlock(pos, BlockType::ROCK);
+                } else if (op < 9) {
+                    incremental.setBlock(pos, BlockType::SOLID);
+                    fullScan.setBlock(pos, BlockType::SOLID);
+                } else {
+                    incremental.removeRockAt(pos);
+                    fullScan.removeRockAt(pos);
+                }
+            }
+            
+            incremental.checkDirtyRocksForFalling();
+            fullScan.checkAllRocksForFalling();
+            auto expected = fullScan.getTriggeredRockFalls();
+            auto actual = incremental.getTriggeredRockFalls();
+            REQUIRE(actual.size() == expected.size());
+            for (size_t i = 0; i < expected.size(); i++) {
+                CHECK(actual[i] == expected[i]);
+            }
+            totalTriggered += (int)expected.size();
+            
+            // Like the game, most triggered rocks start falling; the rest are
+            // left in place (already falling) and must be found again next round
+            for (const auto& rockPos : expected) {
+                if (randomOp(rng) < 7) {
+                    incremental.removeRockAt(rockPos);
+                    fullScan.removeRockAt(rockPos);
+                }
+            }
+        }
+        
+        CHECK(totalTriggered > 100);
+        for (int x = 0; x < incremental.getWidth(); x++) {
+            for (int y = 0; y < incremental.getHeight(); y++) {
+                CHECK(incremental.getBlockType(Position(x, y)) == fullScan.getBlockType(Position(x, y)));
+            }
+        }
+    }
+}
+
+
+TEST_CASE("Runtime-sized chunked terrain") {
+    SUBCASE("Classic levels keep the 40x30 grid") {
+        TerrainGrid terrain(1);
+        CHECK(terrain.getWidth() == Position::WORLD_WIDTH);
+        CHECK(terrain.getHeight() == Position::WORLD_HEIGHT);
+    }
+    
+    SUBCASE("Large grids only allocate touched chunks") {
+        TerrainGrid terrain(1000, 1000);
+        CHECK(terrain.getWidth() == 1000);
+        CHECK(terrain.getHeight() == 1000);
+        CHECK(terrain.getAllocatedChunkCount() == 0);
+        CHECK(terrain.isBlockSolid(Position(999, 999)));
+        
+        terrain.digTunnelAt(Position(500, 700));
+        terrain.digTunnelAt(Position(501, 700));
+        CHECK(terrain.getAllocatedChunkCount() == 1);
+        CHECK(terrain.isBlockEmpty(Position(500, 700)));
+        
+        // Writing solid earth into untouched space must not allocate
+        terrain.setBlock(Position(10, 10), BlockType::SOLID);
+        CHECK(terrain.getAllocatedChunkCount() == 1);
+        
+        // Cells on either side of a chunk edge
+        terrain.digTunnelAt(Position(TerrainGrid::CHUNK_SIZE - 1, 5));
+        terrain.digTunnelAt(Position(TerrainGrid::CHUNK_SIZE, 5));
+        CHECK(terrain.getAllocatedChunkCount() == 3);
+        CHECK(terrain.isBlockEmpty(Position(TerrainGrid::CHUNK_SIZE - 1, 5)));
+        CHECK(terrain.isBlockEmpty(Position(TerrainGrid::CHUNK_SIZE, 5)));
+        CHECK(terrain.isBlockSolid(Position(TerrainGrid::CHUNK_SIZE + 1, 5)));
+    }
+    
+    SUBCASE("Bounds come from the grid, not Position") {
+        TerrainGrid terrain(100, 60);
+        Position farAway(90, 50);
+        CHECK_FALSE(farAway.isValid());
+        CHECK(terrain.isValidPosition(farAway));
+        CHECK_FALSE(terrain.isValidPosition(Position(100, 50)));
+        CHECK(TerrainGrid::isInside(&terrain, farAway));
+        CHECK_FALSE(TerrainGrid::isInside(nullptr, farAway));
+        
+        Monster monster(Position(99, 50), Monster::RED_MONSTER, &terrain);
+        monster.moveLeft();
+        CHECK(monster.getPosition() == Position(98, 50));
+        monster.moveRight();
+        monster.moveRight();
+        CHECK(monster.getPosition() == Position(99, 50));
+    }
+    
+    SUBCASE("Rocks fall to the bottom of a tall grid") {
+        TerrainGrid terrain(50, 200);
+        for (int y = 100; y < 200; y++) {
+            terrain.digTunnelAt(Position(45, y));
+        }
+        terrain.setBlock(Position(45, 99), BlockType::ROCK);
+        terrain.checkAllRocksForFalling();
+        auto triggered = terrain.getTriggeredRockFalls();
+        REQUIRE(triggered.size() == 1);
+        
+        terrain.removeRockAt(triggered[0]);
+        FallingRock rock(triggered[0], &terrain);
+        for (int i = 0; i < 200 && !rock.isLanded(); i++) {
+            rock.update(0.5f);
+        }
+        CHECK(rock.isLanded());
+        CHECK(rock.getPosition() == Position(45, 199));
+    }
+    
+    SUBCASE("SIZE line in a level file sets the dimensions") {
+        const char* filename = "test_size_level.txt";
+        {
+            std::ofstream file(filename);
+            file << "# generated test level\n";
+            file << "SIZE 120 80\n";
+            file << std::string(120, '.') << "\n";
+            file << std::string(60, 'W') << "P" << std::string(29, 'W') << "M" << std::string(29, 'W') << "\n";
+        }
+        
+        TerrainGrid terrain(1);
+        bool loaded = terrain.loadFromFile(filename);
+        std::remove(filename);
+        
+        REQUIRE(loaded);
+        CHECK(terrain.getWidth() == 120);
+        CHECK(terrain.getHeight() == 80);
+        CHECK(terrain.getPlayerStartPosition() == Position(60, 1));
+        CHECK(terrain.getMonsterPositions()[0] == Position(90, 1));
+        CHECK(terrain.isBlockEmpty(Position(119, 0)));
+        CHECK(terrain.isBlockSolid(Position(119, 79)));
+    }
+    
+    SUBCASE("Copies do not share chunks") {
+        TerrainGrid original(64, 64);
+        original.digTunnelAt(Position(3, 3));
+        TerrainGrid copy = original;
+        copy.setBlock(Position(3, 3), BlockType::ROCK);
+        CHECK(original.isBlockEmpty(Position(3, 3)));
+        CHECK(copy.isBlockRock(Position(3, 3)));
+    }
+    
+    SUBCASE("Restoring checks the rock stability lists against the grid") {
+        // Hand-written 8x8 solid grid (one unallocated chunk) with the given lists
+        auto restore = [](std::vector<Position> triggered, std::vector<Position> dirty,
+                          std::vector<long long> unstable) {
+            GameSnapshot snapshot;
+            snapshot.beginWrite();
+            snapshot.write((int32_t)8);
+            snapshot.write((int32_t)8);
+            snapshot.write(true);
+            snapshot.write((uint8_t)0);
+            snapshot.writeVector(triggered);
+            snapshot.writeVector(dirty);
+            snapshot.writeVector(unstable);
+            snapshot.endWrite();
+            TerrainGrid terrain(8, 8);
+            GameSnapshot::Reader in(snapshot);
+            return terrain.restoreState(in);
+        };
+        CHECK(restore({ Position(2, 3) }, {}, { 3, 12 }));
+        CHECK_FALSE(restore({ Position(8, 3) }, {}, {}));
+        CHECK_FALSE(restore({}, { Position(2, 3) }, {}));  // not marked dirty in its chunk
+        CHECK_FALSE(restore({}, {}, { 64 }));
+        CHECK_FALSE(restore({}, {}, { 12, 3 }));
+    }
+}
+
+
+TEST_CASE("Packed terrain word-parallel queries") {
+    // Compare every word-wide query with a cell-by-cell answer on random grids,
+    // including widths that leave a partial word at the end of each row
+    int sizes[][2] = {{40, 30}, {64, 64}, {65, 130}, {200, 77}};
+    std::mt19937 rng(777);
+    
+    for (auto& size : sizes) {
+        TerrainGrid terrain(size[0], size[1]);
+        std::uniform_int_distribution<int> randomX(0, size[0] - 1);
+        std::uniform_int_distribution<int> randomY(0, size[1] - 1);
+        std::uniform_int_distribution<int> randomType(0, 2);
+        
+        for (int i = 0; i < size[0] * size[1] / 2; i++) {
+            terrain.setBlock(Position(randomX(rng), randomY(rng)), (BlockType)randomType(rng));
+        }
+        int fullRow = size[1] / 2;
+        for (int x = 0; x < size[0]; x++) {
+            terrain.digTunnelAt(Position(x, fullRow));
+        }
+        
+        long long dug = 0;
+        long long rocks = 0;
+        std::vector<Position> unsupported;
+        for (int x = 0; x < size[0]; x++) {
+            for (int y = 0; y < size[1]; y++) {
+                Position pos(x, y);
+                dug += terrain.isBlockEmpty(pos);
+                rocks += terrain.isBlockRock(pos);
+                if (terrain.isBlockRock(pos) && terrain.isBlockEmpty(Position(x, y + 1))) {
+                    unsupported.push_back(pos);
+                }
+            }
+        }
+        
+        CHECK(terrain.countDugCells() == dug);
+        CHECK(terrain.countRocks() == rocks);
+        
+        auto found = terrain.findUnsupportedRocks();
+        REQUIRE(found.size() == unsupported.size());
+        for (size_t i = 0; i < found.size(); i++) {
+            CHECK(found[i] == unsupported[i]);
+        }
+        
+        CHECK(terrain.isRowEmpty(fullRow));
+        for (int y = 0; y < size[1]; y++) {
+            bool allEmpty = true;
+            for (int x = 0; x < size[0]; x++) {
+                allEmpty = allEmpty && terrain.isBlockEmpty(Position(x, y));
+            }
+            CHECK(terrain.isRowEmpty(y) == allEmpty);
+        }
+        
+        terrain.setBlock(Position(size[0] - 1, fullRow), BlockType::SOLID);
+        CHECK_FALSE(terrain.isRowEmpty(fullRow));
+    }
+}
+
+
+TEST_CASE("Flow field pathfinding") {
+    // U-shaped tunnel: down column 2, along row 8, up column 10
+    TerrainGrid terrain(20, 12);
+    for (int y = 2; y <= 8; y++) {
+        terrain.digTunnelAt(Position(2, y));
+        terrain.digTunnelAt(Position(10, y));
+    }
+    for (int x = 2; x <= 10; x++) {
+        terrain.digTunnelAt(Position(x, 8));
+    }
+    
+    FlowField field;
+    Position player(2, 2);
+    CHECK(field.update(terrain, player));
+    
+    SUBCASE("Distances follow the tunnels") {
+        CHECK(field.getDistance(player) == 0);
+        CHECK(field.getDistance(Position(2, 8)) == 6);
+        CHECK(field.getDistance(Position(10, 2)) == 6 + 8 + 6);
+        CHECK(field.getDistance(Position(6, 4)) == -1); // solid earth
+        
+        Position next;
+        CHECK(field.getNextStep(Position(10, 2), next));
+        CHECK(next == Position(10, 3));
+        CHECK_FALSE(field.getNextStep(player, next));
+    }
+    
+    SUBCASE("Rebuilt only when the player tile or terrain changes") {
+        CHECK_FALSE(field.update(terrain, player));
+        CHECK(field.getRebuildCount() == 1);
+        
+        CHECK(field.update(terrain, Position(2, 3)));
+        CHECK(field.getRebuildCount() == 2);
+        
+        // A shortcut along row 2 makes the far column much closer
+        for (int x = 3; x < 10; x++) {
+            terrain.digTunnelAt(Position(x, 2));
+        }
+        CHECK(field.update(terrain, Position(2, 3)));
+        CHECK(field.getDistance(Position(10, 2)) == 9);
+        CHECK_FALSE(field.update(terrain, Position(2, 3)));
+    }
+    
+    SUBCASE("Monsters walk the tunnel instead of through earth") {
+        Monster monster(Position(10, 2), Monster::RED_MONSTER, &terrain);
+        monster.setFlowField(&field);
+        monster.setTarget(player);
+        REQUIRE(monster.getBehaviorState() == Monster::CHASING);
+        monster.update(0.3f);
+        
+        // Straight-line movement would have stepped left into solid earth
+        CHECK(monster.getPosition() == Position(10, 3));
+        CHECK(terrain.isBlockEmpty(monster.getPosition()));
+    }
+    
+    SUBCASE("One rebuild serves hundreds of monsters") {
+        std::vector<Monster> monsters;
+        for (int i = 0; i < 300; i++) {
+            monsters.emplace_back(Position(10, 2 + i % 7), Monster::GREEN_DRAGON, &terrain);
+            monsters.back().setFlowField(&field);
+        }
+        for (int tick = 0; tick < 10; tick++) {
+            field.update(terrain, player);
+            for (auto& monster : monsters) {
+                monster.setTarget(player);
+                monster.update(0.3f);
+            }
+        }
+        CHECK(field.getRebuildCount() == 1);
+    }
+}
+
+
+TEST_CASE("Projectile pool") {
+    Player player(Position(10, 10));
+    ProjectilePool pool(4);
+    
+    SUBCASE("Handles resolve until the harpoon is retired") {
+        ProjectileHandle handle = pool.spawn(&player, Projectile::RIGHT, 5);
+        REQUIRE(handle.isValid());
+        REQUIRE(pool.get(handle) != nullptr);
+        CHECK(pool.get(handle)->getMaxRange() == 5);
+        CHECK(pool.size() == 1);
+        
+        CHECK(pool.release(handle));
+        CHECK(pool.get(handle) == nullptr);
+        CHECK_FALSE(pool.release(handle));
+        CHECK(pool.size() == 0);
+    }
+    
+    SUBCASE("Slots are reused with a new generation") {
+        ProjectileHandle first = pool.spawn(&player, Projectile::UP, 3);
+        Projectile* firstAddress = pool.get(first);
+        pool.release(first);
+        
+        ProjectileHandle second = pool.spawn(&player, Projectile::DOWN, 3);
+        CHECK(second.index == first.index);
+        CHECK(second.generation != first.generation);
+        CHECK(pool.get(second) == firstAddress); // same storage, no new allocation
+        CHECK(pool.get(first) == nullptr);
+    }
+    
+    SUBCASE("Full pool refuses new harpoons") {
+        for (int i = 0; i < pool.capacity(); i++) {
+            CHECK(pool.spawn(&player, Projectile::LEFT, 3).isValid());
+        }
+        CHECK(pool.isFull());
+        CHECK_FALSE(pool.spawn(&player, Projectile::LEFT, 3).isValid());
+        
+        pool.releaseAt(1);
+        CHECK(pool.spawn(&player, Projectile::LEFT, 3).isValid());
+    }
+    
+    SUBCASE("Harpoons follow their owner by handle") {
+        Player other(Position(20, 5));
+        CHECK(pool.addOwner(&player) == 0);
+        CHECK(pool.addOwner(&other) == 1);
+        CHECK(pool.addOwner(&player) == 0);
+        
+        ProjectileHandle handle = pool.spawn(&other, Projectile::RIGHT, 5);
+        REQUIRE(handle.isValid());
+        CHECK(pool.get(handle)->getOwner() == 1);
+        CHECK(pool.get(handle)->getPosition() == Position(20, 5));
+        
+        other.setPosition(Position(22, 7));
+        pool.update(0.0f);
+        CHECK(pool.get(handle)->getPosition() == Position(22, 7));
+    }
+    
+    SUBCASE("Finished harpoons are retired in place, keeping firing order") {
+        ProjectileHandle a = pool.spawn(&player, Projectile::UP, 3);
+        ProjectileHandle b = pool.spawn(&player, Projectile::DOWN, 3);
+        ProjectileHandle c = pool.spawn(&player, Projectile::LEFT, 3);
+        
+        pool.get(b)->markHit();
+        for (int i = 0; i < 100 && !pool.get(b)->isFinished(); i++) {
+            pool.get(b)->update(0.1f);
+        }
+        REQUIRE(pool.get(b)->isFinished());
+        
+        CHECK(pool.retireFinished() == 1);
+        CHECK(pool.size() == 2);
+        CHECK(pool.handleAt(0) == a);
+        CHECK(pool.handleAt(1) == c);
+        
+        int visited = 0;
+        for (const auto& projectile : pool) {
+            CHECK_FALSE(projectile.isFinished());
+            visited++;
+        }
+        CHECK(visited == 2);
+    }
+    
+    SUBCASE("Restoring checks the slot lists and the harpoon enums") {
+        Projectile::SavedState harpoon = pool.get(pool.spawn(&player, Projectile::UP, 3))->getSavedState();
+        
+        // Hand-written four-slot pools with slots 1 and 2 occupied
+        auto restoreRaw = [&](std::vector<uint32_t> freeSlots, std::vector<uint32_t> activeSlots,
+                              const Projectile::SavedState& saved) {
+            GameSnapshot raw;
+            raw.beginWrite();
+            raw.write((uint32_t)4);
+            for (uint32_t i = 0; i < 4; i++) {
+                bool occupied = i == 1 || i == 2;
+                raw.write((uint32_t)0);
+                raw.write((uint8_t)occupied);
+                if (occupied) {
+                    raw.write(saved);
+                }
+            }
+            raw.writeVector(freeSlots);
+            raw.writeVector(activeSlots);
+            raw.endWrite();
+            ProjectilePool restored(4);
+            restored.addOwner(&player);
+            GameSnapshot::Reader in(raw);
+            return restored.restoreState(in);
+        };
+        CHECK(restoreRaw({ 0, 3 }, { 2, 1 }, harpoon));
+        CHECK_FALSE(restoreRaw({ 0, 3 }, { 1, 1 }, harpoon));  // active slot listed twice
+        CHECK_FALSE(restoreRaw({ 0, 0 }, { 1, 2 }, harpoon));  // free slot listed twice
+        CHECK_FALSE(restoreRaw({ 0, 1 }, { 3, 2 }, harpoon));  // occupied slot listed as free
+        
+        uint32_t unknown = 9;
+        Projectile::SavedState badDirection = harpoon;
+        std::memcpy(&badDirection.direction, &unknown, sizeof(badDirection.direction));
+        CHECK_FALSE(restoreRaw({ 0, 3 }, { 1, 2 }, badDirection));
+        Projectile::SavedState badState = harpoon;
+        std::memcpy(&badState.state, &unknown, sizeof(badState.state));
+        CHECK_FALSE(restoreRaw({ 0, 3 }, { 1, 2 }, badState));
+    }
+}
+
+
+TEST_CASE("Spatial index for tile occupancy") {
+    SpatialIndex index;
+    index.reset(50, 40);
+    
+    SUBCASE("Lookup, move and remove") {
+        int a = index.insert(Position(3, 4));
+        int b = index.insert(Position(3, 4));
+        int c = index.insert(Position(10, 10));
+        CHECK(c == 2);
+        
+        int count = 0;
+        for (int id = index.firstAt(Position(3, 4)); id != SpatialIndex::NONE; id = index.nextAt(id)) {
+            CHECK((id == a || id == b));
+            count++;
+        }
+        CHECK(count == 2);
+        CHECK(index.firstAt(Position(4, 4)) == SpatialIndex::NONE);
+        
+        index.update(a, Position(4, 4));
+        CHECK(index.firstAt(Position(4, 4)) == a);
+        CHECK(index.firstAt(Position(3, 4)) == b);
+        
+        // Removing a renumbers the last entity (c) to a's id
+        index.removeSwapLast(a);
+        CHECK(index.size() == 2);
+        CHECK(index.firstAt(Position(4, 4)) == SpatialIndex::NONE);
+        CHECK(index.firstAt(Position(10, 10)) == a);
+    }
+    
+    SUBCASE("Matches a brute-force scan under random churn") {
+        std::vector<Position> positions;
+        std::mt19937 rng(99);
+        std::uniform_int_distribution<int> randomX(-1, 50);
+        std::uniform_int_distribution<int> randomY(-1, 40);
+        std::uniform_int_distribution<int> randomOp(0, 9);
+        
+        for (int step = 0; step < 5000; step++) {
+            int op = randomOp(rng);
+            if (op < 3 || positions.empty()) {
+                positions.push_back(Position(randomX(rng) % 8, randomY(rng) % 8));
+                index.insert(positions.back());
+            } else if (op < 8) {
+                int id = (int)(rng() % positions.size());
+                positions[id] = Position(randomX(rng) % 8, randomY(rng) % 8);
+                index.update(id, positions[id]);
+            } else {
+                int id = (int)(rng() % positions.size());
+                positions[id] = positions.back();
+                positions.pop_back();
+                index.removeSwapLast(id);
+            }
+            
+            Position probe(randomX(rng) % 8, randomY(rng) % 8);
+            std::vector<int> expected;
+            for (size_t i = 0; i < positions.size(); i++) {
+                if (positions[i] == probe && probe.x >= 0 && probe.y >= 0) {
+                    expected.push_back((int)i);
+                }
+            }
+            std::vector<int> actual;
+            for (int id = index.firstAt(probe); id != SpatialIndex::NONE; id = index.nextAt(id)) {
+                actual.push_back(id);
+            }
+            std::sort(actual.begin(), actual.end());
+            REQUIRE(actual == expected);
+        }
+    }
+    
+    SUBCASE("Restoring checks the grid, the count and the links") {
+        index.insert(Position(3, 4));
+        index.insert(Position(3, 4));
+        index.insert(Position(60, 4));  // off the grid
+        GameSnapshot snapshot;
+        snapshot.beginWrite();
+        index.saveState(snapshot);
+        snapshot.endWrite();
+        
+        auto restore = [&](int width, int height, int count) {
+            SpatialIndex restored;
+            GameSnapshot::Reader in(snapshot);
+            return restored.restoreState(in, width, height, count);
+        };
+        CHECK(restore(50, 40, 3));
+        CHECK_FALSE(restore(40, 50, 3));
+        CHECK_FALSE(restore(50, 40, 2));
+        
+        // Hand-written indexes over a 2x1 grid: the heads, then cell, prev
+        // and next for each entry
+        auto restoreRaw = [](std::vector<int> heads, std::vector<int> links) {
+            GameSnapshot raw;
+            raw.beginWrite();
+            raw.write((int32_t)2);
+            raw.write((int32_t)1);
+            raw.writeVector(heads);
+            raw.write((uint32_t)(links.size() / 3));
+            raw.writeArray(links.data(), links.size());
+            raw.endWrite();
+            SpatialIndex restored;
+            GameSnapshot::Reader in(raw);
+            return restored.restoreState(in, 2, 1, (int)links.size() / 3);
+        };
+        const int NONE = SpatialIndex::NONE;
+        CHECK(restoreRaw({ 1, NONE }, { 0, 1, NONE, 0, NONE, 0 }));
+        CHECK_FALSE(restoreRaw({ 5, NONE }, { 0, NONE, NONE }));    // head past the entries
+        CHECK_FALSE(restoreRaw({ 0, NONE }, { 7, NONE, NONE }));    // cell past the grid
+        CHECK_FALSE(restoreRaw({ 0, NONE }, { 0, NONE, 9 }));       // next past the entries
+        CHECK_FALSE(restoreRaw({ 0, NONE }, { 0, NONE, 0 }));       // list loops on itself
+        CHECK_FALSE(restoreRaw({ NONE, NONE }, { 0, NONE, NONE })); // entry missing from its tile
+    }
+}
+
+
+TEST_CASE("Seeded random streams") {
+    SUBCASE("Same seed and stream repeat exactly") {
+        Random a(42, 7);
+        Random b(42, 7);
+        for (int i = 0; i < 1000; i++) {
+            CHECK(a.next() == b.next());
+        }
+    }
+    
+    SUBCASE("Streams and seeds are independent") {
+        Random base(42, 7);
+        Random otherStream(42, 8);
+        Random otherSeed(43, 7);
+        int sameStream = 0;
+        int sameSeed = 0;
+        for (int i = 0; i < 1000; i++) {
+            uint32_t value = base.next();
+            sameStream += (value == otherStream.next());
+            sameSeed += (value == otherSeed.next());
+        }
+        CHECK(sameStream < 5);
+        CHECK(sameSeed < 5);
+    }
+    
+    SUBCASE("Ranges") {
+        Random random(1);
+        int counts[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 40000; i++) {
+            int value = random.nextInt(4);
+            REQUIRE(value >= 0);
+            REQUIRE(value < 4);
+            counts[value]++;
+            float f = random.nextFloat();
+            REQUIRE(f >= 0.0f);
+            REQUIRE(f < 1.0f);
+        }
+        for (int count : counts) {
+            CHECK(count > 9000);
+            CHECK(count < 11000);
+        }
+        CHECK(random.nextInt(0) == 0);
+    }
+    
+    SUBCASE("Headless games with the same seed play out identically") {
+        auto runGame = [](uint64_t seed) {
+            RandomBotInput bot(seed);
+            Game game(&bot, true, seed);
+            std::vector<int> trace;
+            for (int tick = 0; tick < 3000; tick++) {
+                game.beginFrame();
+                game.update(1.0f / 60.0f);
+                Position pos = game.getPlayerPosition();
+                trace.push_back(pos.x * 1000 + pos.y);
+                trace.push_back(game.getScore());
+                trace.push_back(game.getMonsterCount());
+            }
+            return trace;
+        };
+        
+        CHECK(runGame(1234) == runGame(1234));
+        CHECK(runGame(1234) != runGame(5678));
+    }
+}
+
+
+TEST_CASE("Input recording and replay") {
+    const char* filename = "test_replay.ddr";
+    
+    SUBCASE("Varints round trip") {
+        std::vector<uint8_t> bytes;
+        uint64_t values[] = {0, 1, 127, 128, 300, 0xFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull};
+        for (uint64_t value : values) {
+            Replay::writeVarint(bytes, value);
+        }
+        size_t offset = 0;
+        for (uint64_t value : values) {
+            uint64_t decoded = 0;
+            REQUIRE(Replay::readVarint(bytes, offset, decoded));
+            CHECK(decoded == value);
+        }
+        CHECK(offset == bytes.size());
+    }
+    
+    SUBCASE("Replaying a recorded game reproduces it exactly") {
+        const uint64_t seed = 2024;
+        const int ticks = 5000;
+        std::vector<uint32_t> recordedInput;
+        std::vector<int> recordedTrace;
+        {
+            RandomBotInput bot(seed);
+            ReplayRecorder recorder(&bot, seed, 60.0f);
+            Game game(&recorder, true, seed);
+            for (int tick = 0; tick < ticks; tick++) {
+                game.beginFrame();
+                game.update(1.0f / 60.0f);
+                Position pos = game.getPlayerPosition();
+                recordedTrace.push_back(pos.x * 1000 + pos.y);
+                recordedTrace.push_back(game.getScore());
+            }
+            CHECK(recorder.getTickCount() == (uint64_t)ticks);
+            REQUIRE(recorder.save(filename));
+        }
+        
+        ReplayInput replay;
+        REQUIRE(replay.load(filename));
+        CHECK(replay.getSeed() == seed);
+        CHECK(replay.getTickRate() == 60.0f);
+        CHECK(replay.getTickCount() == (uint64_t)ticks);
+        
+        Game game(&replay, true, replay.getSeed());
+        std::vector<int> replayedTrace;
+        while (!replay.isFinished()) {
+            game.beginFrame();
+            game.update(1.0f / 60.0f);
+            Position pos = game.getPlayerPosition();
+            replayedTrace.push_back(pos.x * 1000 + pos.y);
+            replayedTrace.push_back(game.getScore());
+        }
+        CHECK(replayedTrace == recordedTrace);
+    }
+    
+    SUBCASE("Half an hour of input stays small") {
+        const uint64_t ticks = 30 * 60 * 60;
+        ScriptedInput player;
+        ReplayRecorder recorder(&player, 1, 60.0f);
+        for (uint64_t tick = 0; tick < ticks; tick++) {
+            // Walk in a new direction every two seconds, fire every three
+            player.releaseAll();
+            player.hold((InputState::Action)(InputState::MOVE_UP + (tick / 120) % 4));
+            if (tick % 180 == 0) {
+                player.press(InputState::FIRE);
+            }
+            recorder.poll();
+        }
+        REQUIRE(recorder.save(filename));
+        
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        long long size = (long long)file.tellg();
+        CHECK(size < 8 * 1024);
+        
+        ReplayInput replay;
+        REQUIRE(replay.load(filename));
+        uint64_t played = 0;
+        while (!replay.isFinished()) {
+            InputState state = replay.poll();
+            REQUIRE(state.isDown((InputState::Action)(InputState::MOVE_UP + (played / 120) % 4)));
+            REQUIRE(state.isPressed(InputState::FIRE) == (played % 180 == 0));
+            played++;
+        }
+        CHECK(played == ticks);
+    }
+    
+    SUBCASE("Rejects files that are not replays") {
+        {
+            std::ofstream file(filename);
+            file << "not a replay";
+        }
+        ReplayInput replay;
+        CHECK_FALSE(replay.load(filename));
+        CHECK(replay.isFinished());
+    }
+    
+    std::remove(filename);
+}
+
+TEST_CASE("Frame profiler") {
+    Profiler* profiler = Profiler::getInstance();
+    profiler->reset();
+    
+    SUBCASE("Nested scopes are recorded per frame") {
+        {
+            ProfileScope outer("outer");
+            ProfileScope inner("inner");
+        }
+        CHECK(profiler->getFinishedFrameCount() == 0);
+        
+        profiler->beginFrame();
+        REQUIRE(profiler->getFinishedFrameCount() == 1);
+        const Profiler::Frame& frame = profiler->getFinishedFrame(0);
+        REQUIRE(frame.sampleCount == 2);
+        CHECK(std::string(frame.samples[0].name) == "outer");
+        CHECK(frame.samples[0].depth == 0);
+        CHECK(frame.samples[1].depth == 1);
+        CHECK(frame.samples[1].startNs >= frame.samples[0].startNs);
+        CHECK(frame.samples[0].durationNs >= frame.samples[1].durationNs);
+        CHECK(frame.durationNs >= frame.samples[0].durationNs);
+    }
+    
+    SUBCASE("Ring keeps the most recent frames") {
+        for (int i = 0; i < Profiler::FRAME_HISTORY * 2; i++) {
+            ProfileScope scope("tick");
+            profiler->beginFrame();
+        }
+        CHECK(profiler->getFinishedFrameCount() == Profiler::FRAME_HISTORY - 1);
+        CHECK(profiler->getFinishedFrame(0).index == (uint64_t)Profiler::FRAME_HISTORY * 2 - 1);
+        
+        std::vector<Profiler::SectionStats> sections = profiler->summarize();
+        REQUIRE(sections.size() == 1);
+        CHECK(std::string(sections[0].name) == "tick");
+        CHECK(sections[0].maxMs >= sections[0].averageMs);
+    }
+    
+    SUBCASE("Probes beyond the frame capacity are dropped, not written") {
+        for (int i = 0; i < Profiler::MAX_SAMPLES_PER_FRAME + 10; i++) {
+            ProfileScope scope("probe");
+        }
+        profiler->beginFrame();
+        CHECK(profiler->getFinishedFrame(0).sampleCount == Profiler::MAX_SAMPLES_PER_FRAME);
+        CHECK(profiler->getFinishedFrame(0).droppedCount == 10);
+    }
+    
+    SUBCASE("A disabled profiler records nothing") {
+        profiler->setEnabled(false);
+        {
+            ProfileScope scope("ignored");
+        }
+        profiler->beginFrame();
+        CHECK(profiler->getFinishedFrameCount() == 0);
+        
+        profiler->setEnabled(true);
+        {
+            ProfileScope scope("recorded");
+        }
+        profiler->beginFrame();
+        REQUIRE(profiler->getFinishedFrameCount() == 1);
+        CHECK(profiler->getFinishedFrame(0).sampleCount == 1);
+    }
+    
+    SUBCASE("Chrome trace export") {
+        {
+            ProfileScope scope("say \"hi\"");
+        }
+        profiler->beginFrame();
+        
+        std::ostringstream trace;
+        profiler->writeChromeTrace(trace);
+        std::string json = trace.str();
+        CHECK(json.find("\"traceEvents\"") != std::string::npos);
+        CHECK(json.find("\"ph\": \"X\"") != std::string::npos);
+        CHECK(json.find("\"say \\\"hi\\\"\"") != std::string::npos);
+    }
+
+#if GAME_PROFILE
+    SUBCASE("Headless game ticks are split into subsystems") {
+        ScriptedInput input;
+        Game game(&input, true);
+        input.press(InputState::CONFIRM);
+        for (int i = 0; i < 3; i++) {
+            game.beginFrame();
+            game.update(1.0f / 60.0f);
+        }
+        game.beginFrame();
+        
+        std::vector<std::string> names;
+        for (const auto& section : profiler->summarize()) {
+            names.push_back(section.name);
+        }
+        CHECK(std::find(names.begin(), names.end(), "update") != names.end());
+        CHECK(std::find(names.begin(), names.end(), "monsters") != names.end());
+        CHECK(std::find(names.begin(), names.end(), "harpoon collisions") != names.end());
+    }
+#endif
+    
+    profiler->reset();
+}
+
+TEST_CASE("Terrain change log for the render cache") {
+    TerrainGrid grid(100, 80);
+    unsigned long long start = grid.getRevision();
+    std::vector<Position> changes;
+    
+    SUBCASE("Lists changed cells in order") {
+        grid.digTunnelAt(Position(3, 4));
+        grid.setBlock(Position(70, 5), BlockType::ROCK);
+        grid.digTunnelAt(Position(3, 4)); // already empty: no change
+        
+        REQUIRE(grid.getChangesSince(start, changes));
+        REQUIRE(changes.size() == 2);
+        CHECK(changes[0] == Position(3, 4));
+        CHECK(changes[1] == Position(70, 5));
+        
+        changes.clear();
+        REQUIRE(grid.getChangesSince(grid.getRevision(), changes));
+        CHECK(changes.empty());
+    }
+    
+    SUBCASE("Reports when the changes are no longer known") {
+        for (int i = 0; i <= TerrainGrid::CHANGE_LOG_SIZE; i++) {
+            grid.digTunnelAt(Position(i % 100, i / 100));
+        }
+        CHECK_FALSE(grid.getChangesSince(start, changes));
+        CHECK(grid.getChangesSince(grid.getRevision() - 10, changes));
+        CHECK(changes.size() == 10);
+    }
+    
+    SUBCASE("Copies keep their own log") {
+        grid.digTunnelAt(Position(1, 1));
+        TerrainGrid copy(grid);
+        copy.digTunnelAt(Position(2, 2));
+        
+        REQUIRE(copy.getChangesSince(start, changes));
+        CHECK(changes.size() == 2);
+        changes.clear();
+        REQUIRE(grid.getChangesSince(start, changes));
+        CHECK(changes.size() == 1);
+    }
+}
+
+TEST_CASE("Render cache repaints every tile a change shows in") {
+    TerrainGrid grid(40, 30);
+    const int tilesWide = 30;
+    const int tilesHigh = 20;
+    
+    // What a tile shows after TerrainRenderer::redrawCell: the cells whose
+    // sprites reach into it, drawn in full-draw order
+    auto paintTile = [&](int tileX, int tileY, int reach) {
+        std::vector<BlockType> layers;
+        for (int x = std::max(0, tileX - reach); x <= tileX; x++) {
+            for (int y = std::max(0, tileY - reach); y <= tileY; y++) {
+                layers.push_back(grid.getBlockType(Position(x, y)));
+            }
+        }
+        return layers;
+    };
+    auto paintAll = [&](int reach) {
+        std::vector<std::vector<BlockType>> tiles;
+        for (int x = 0; x < tilesWide; x++) {
+            for (int y = 0; y < tilesHigh; y++) {
+                tiles.push_back(paintTile(x, y, reach));
+            }
+        }
+        return tiles;
+    };
+    
+    for (int reach : { 0, 1, 2 }) {
+        CAPTURE(reach);
+        TerrainGrid original(grid);
+        std::vector<std::vector<BlockType>> cached = paintAll(reach);
+        unsigned long long drawn = grid.getRevision();
+        
+        // A dig, a rock, a change at the screen edge and one off screen
+        for (int x = 4; x < 9; x++) {
+            grid.digTunnelAt(Position(x, 6));
+        }
+        grid.setBlock(Position(12, 3), BlockType::ROCK);
+        grid.digTunnelAt(Position(tilesWide - 1, tilesHigh - 1));
+        grid.digTunnelAt(Position(35, 25));
+        
+        std::vector<Position> tiles;
+        REQUIRE(grid.getChangesSince(drawn, tiles));
+        TerrainRenderer::collectDirtyTiles(tiles, reach, tilesWide, tilesHigh);
+        for (const Position& tile : tiles) {
+            REQUIRE(tile.x < tilesWide);
+            REQUIRE(tile.y < tilesHigh);
+            cached[(size_t)tile.x * tilesHigh + tile.y] = paintTile(tile.x, tile.y, reach);
+        }
+        CHECK(cached == paintAll(reach));
+        CHECK(std::is_sorted(tiles.begin(), tiles.end(), [](const Position& a, const Position& b) {
+            return a.x != b.x ? a.x < b.x : a.y < b.y;
+        }));
+        CHECK(std::adjacent_find(tiles.begin(), tiles.end()) == tiles.end());
+        
+        grid = original;
+    }
+}
+
+TEST_CASE("Cooked resource pack") {
+    const char* packFile = "test_resources.pack";
+    REQUIRE(ResourceCooker::cook(packFile));
+    
+    ResourcePack pack;
+    REQUIRE(pack.open(packFile));
+    
+    SUBCASE("Cooked levels match the text files") {
+        for (int level = 1; level <= 5; level++) {
+            std::string name = "level" + std::to_string(level);
+            const ResourcePack::Entry* entry = pack.find(name, ResourcePack::ENTRY_LEVEL);
+            REQUIRE(entry != nullptr);
+            
+            TerrainGrid text(TerrainGrid::DEFAULT_WIDTH, TerrainGrid::DEFAULT_HEIGHT);
+            REQUIRE(text.loadFromFile("resources/" + name + ".txt"));
+            TerrainGrid cooked(1, 1);
+            REQUIRE(cooked.loadBinary(pack.getData(*entry), (size_t)entry->size, name));
+            
+            REQUIRE(cooked.getWidth() == text.getWidth());
+            REQUIRE(cooked.getHeight() == text.getHeight());
+            CHECK(cooked.getPlayerStartPosition() == text.getPlayerStartPosition());
+            CHECK(cooked.getMonsterPositions() == text.getMonsterPositions());
+            CHECK(cooked.getInitialRockPositions() == text.getInitialRockPositions());
+            for (int y = 0; y < text.getHeight(); y++) {
+                for (int x = 0; x < text.getWidth(); x++) {
+                    CHECK(cooked.getBlockType(Position(x, y)) == text.getBlockType(Position(x, y)));
+                }
+            }
+        }
+        CHECK(pack.find("level1", ResourcePack::ENTRY_ATLAS) == nullptr);
+        CHECK(pack.find("level99", ResourcePack::ENTRY_LEVEL) == nullptr);
+    }
+    
+    SUBCASE("Truncated level payloads are rejected") {
+        const ResourcePack::Entry* entry = pack.find("level1", ResourcePack::ENTRY_LEVEL);
+        REQUIRE(entry != nullptr);
+        TerrainGrid grid(1, 1);
+        CHECK_FALSE(grid.loadBinary(pack.getData(*entry), (size_t)entry->size - 1, "level1"));
+        CHECK_FALSE(grid.loadBinary(pack.getData(*entry), 8, "level1"));
+    }
+    
+    SUBCASE("Damaged packs are rejected") {
+        std::ifstream input(packFile, std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        input.close();
+        pack.close();
+        
+        std::vector<char> truncated(bytes.begin(), bytes.end() - 1);
+        std::ofstream(packFile, std::ios::binary).write(truncated.data(), (std::streamsize)truncated.size());
+        CHECK_FALSE(pack.open(packFile));
+        
+        bytes[0] = 'X';
+        std::ofstream(packFile, std::ios::binary).write(bytes.data(), (std::streamsize)bytes.size());
+        CHECK_FALSE(pack.open(packFile));
+        CHECK_FALSE(pack.open("no_such_file.pack"));
+    }
+    
+    pack.close();
+    std::remove(packFile);
+}
+
+TEST_CASE("Binary level files") {
+    TerrainGrid text(TerrainGrid::DEFAULT_WIDTH, TerrainGrid::DEFAULT_HEIGHT);
+    REQUIRE(text.loadFromFile("resources/level3.txt"));
+    std::vector<uint8_t> data;
+    text.writeBinary(data);
+    
+    SUBCASE("Round trip through a file") {
+        const char* filename = "test_level.lvl";
+        REQUIRE(text.saveBinaryFile(filename));
+        TerrainGrid loaded(1, 1);
+        REQUIRE(loaded.loadBinaryFile(filename));
+        std::remove(filename);
+        
+        REQUIRE(loaded.getWidth() == text.getWidth());
+        REQUIRE(loaded.getHeight() == text.getHeight());
+        CHECK(loaded.getPlayerStartPosition() == text.getPlayerStartPosition());
+        CHECK(loaded.getMonsterPositions() == text.getMonsterPositions());
+        CHECK(loaded.getInitialRockPositions() == text.getInitialRockPositions());
+        CHECK(loaded.countDugCells() == text.countDugCells());
+        CHECK(loaded.countRocks() == text.countRocks());
+        for (int y = 0; y < text.getHeight(); y++) {
+            for (int x = 0; x < text.getWidth(); x++) {
+                CHECK(loaded.getBlockType(Position(x, y)) == text.getBlockType(Position(x, y)));
+            }
+        }
+    }
+    
+    SUBCASE("Only chunks with tunnels or rocks are stored") {
+        TerrainGrid big(1000, 1000);
+        big.digTunnelAt(Position(500, 500));
+        big.setBlock(Position(500, 499), BlockType::ROCK);
+        big.setBlock(Position(10, 10), BlockType::ROCK);
+        big.setBlock(Position(10, 10), BlockType::SOLID);  // allocated, but solid again
+        std::vector<uint8_t> sparse;
+        big.writeBinary(sparse);
+        
+        const LevelFile::Header* sparseHeader = reinterpret_cast<const LevelFile::Header*>(sparse.data());
+        CHECK(sparseHeader->storedChunkCount == 1);
+        CHECK(sparse.size() == LevelFile::fileSize(*sparseHeader));
+        CHECK(sparse.size() < 8192);
+    }
+    
+    SUBCASE("Malformed data is rejected") {
+        TerrainGrid grid(1, 1);
+        REQUIRE(grid.loadBinary(data.data(), data.size(), "level3"));
+        
+        CHECK_FALSE(grid.loadBinary(data.data(), data.size() - 1, "truncated"));
+        CHECK_FALSE(grid.loadBinary(data.data(), 10, "header only"));
+        
+        
+        std::vector<std::function<void(std::vector<uint8_t>&)>> corruptions = {
+            [](std::vector<uint8_t>& bytes) { bytes[0] = 'X'; },  // bad magic
+            [](std::vector<uint8_t>& bytes) {  // cell both rock and empty
+                auto* chunk = reinterpret_cast<LevelFile::Chunk*>(
+                    bytes.data() + LevelFile::chunkOffset(*reinterpret_cast<LevelFile::Header*>(bytes.data())));
+                chunk->rockBits[0] |= 1;
+                chunk->emptyBits[0] |= 1;
+            },
+            [](std::vector<uint8_t>& bytes) {  // cell outside the 40-wide grid
+                auto* chunk = reinterpret_cast<LevelFile::Chunk*>(
+                    bytes.data() + LevelFile::chunkOffset(*reinterpret_cast<LevelFile::Header*>(bytes.data())));
+                chunk->emptyBits[0] |= uint64_t(1) << 50;
+            },
+            [](std::vector<uint8_t>& bytes) {  // chunk table past the stored chunks
+                reinterpret_cast<uint32_t*>(bytes.data() + sizeof(LevelFile::Header))[0] = 7;
+            },
+            [](std::vector<uint8_t>& bytes) {  // monster outside the grid
+                auto* levelHeader = reinterpret_cast<LevelFile::Header*>(bytes.data());
+                auto* spawns = reinterpret_cast<LevelFile::SpawnPoint*>(bytes.data() + LevelFile::spawnOffset(*levelHeader));
+                spawns[levelHeader->rockCount].x = 500;
+            },
+        };
+        for (size_t i = 0; i < corruptions.size(); i++) {
+            CAPTURE(i);
+            std::vector<uint8_t> corrupt = data;
+            corruptions[i](corrupt);
+            CHECK_FALSE(grid.loadBinary(corrupt.data(), corrupt.size(), "corrupt"));
+        }
+        
+        // Well formed, but fails the same validation as a text level
+        std::vector<uint8_t> noMonsters;
+        TerrainGrid(40, 30).writeBinary(noMonsters);
+        CHECK_FALSE(grid.loadBinary(noMonsters.data(), noMonsters.size(), "no monsters"));
+    }
+}
+
+TEST_CASE("Background level preloading") {
+    LevelLoader loader;
+    
+    SUBCASE("Hands over the same level a direct load gives") {
+        loader.preload(3);
+        CHECK(loader.getPendingLevel() == 3);
+        std::unique_ptr<TerrainGrid> loaded = loader.take(3);
+        REQUIRE(loaded != nullptr);
+        CHECK(loader.getPendingLevel() == 0);
+        
+        TerrainGrid direct(3);
+        CHECK(loaded->getPlayerStartPosition() == direct.getPlayerStartPosition());
+        CHECK(loaded->getMonsterPositions() == direct.getMonsterPositions());
+        CHECK(loaded->countDugCells() == direct.countDugCells());
+        CHECK(loaded->countRocks() == direct.countRocks());
+        
+        CHECK(loader.take(3) == nullptr);  // handed over only once
+    }
+    
+    SUBCASE("A different level is discarded") {
+        loader.preload(2);
+        loader.preload(2);  // already pending: no second load
+        CHECK(loader.take(4) == nullptr);
+        CHECK(loader.getPendingLevel() == 0);
+        CHECK_FALSE(loader.isReady(2));
+    }
+    
+    SUBCASE("Becomes ready without being asked") {
+        loader.preload(1);
+        for (int i = 0; i < 2000 && !loader.isReady(1); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(loader.isReady(1));
+        CHECK_FALSE(loader.isReady(2));
+        CHECK(loader.take(1) != nullptr);
+    }
+}
+
+TEST_CASE("Structure-of-arrays monster store") {
+    TerrainGrid terrain(5);
+    FlowField flowField;
+    std::vector<Position> openCells = findEmptyCells(terrain);
+    REQUIRE_FALSE(openCells.empty());
+    
+    std::vector<Monster> objects;
+    MonsterStore store;
+    store.setTerrain(&terrain);
+    store.setFlowField(&flowField);
+    store.setLodDistance(0.0f);  // full AI everywhere, like the Monster objects
+    for (int i = 0; i < 60; i++) {
+        objects.push_back(makeCrowdMonster(openCells, i, terrain, 99, true));
+        objects.back().setFlowField(&flowField);
+        CHECK(store.add(objects.back()) == i);
+    }
+    
+    SUBCASE("Restoring rejects out-of-range states, types and levels of detail") {
+        // One monster, written field by field in saveState's order
+        auto restoreRaw = [](int32_t state, int32_t type, uint8_t lod) {
+            GameSnapshot raw;
+            raw.beginWrite();
+            raw.write(Position(3, 4));
+            raw.write((uint32_t)0);
+            raw.write(DecisionScheduler());
+            raw.writeVector(std::vector<int32_t>{ 3 });
+            raw.writeVector(std::vector<int32_t>{ 4 });
+            raw.writeVector(std::vector<int32_t>{ state });
+            for (int i = 0; i < 6; i++) {
+                raw.writeVector(std::vector<float>{ 1.0f });  // timers, cooldown and ranges
+            }
+            raw.writeVector(std::vector<uint8_t>{ lod });
+            raw.writeVector(std::vector<int32_t>{ 3 });
+            raw.writeVector(std::vector<int32_t>{ 4 });
+            raw.writeVector(std::vector<int32_t>{ type });
+            raw.writeVector(std::vector<uint8_t>{ 0 });
+            raw.writeVector(std::vector<Random>{ Random(1) });
+            raw.endWrite();
+            MonsterStore restored;
+            GameSnapshot::Reader in(raw);
+            return restored.restoreState(in) && in.isFinished();
+        };
+        CHECK(restoreRaw(Monster::AGGRESSIVE, Monster::GREEN_DRAGON, MonsterStore::LOD_DISTANT));
+        CHECK_FALSE(restoreRaw(3, Monster::RED_MONSTER, MonsterStore::LOD_FULL));
+        CHECK_FALSE(restoreRaw(-1, Monster::RED_MONSTER, MonsterStore::LOD_FULL));
+        CHECK_FALSE(restoreRaw(Monster::PATROLLING, 2, MonsterStore::LOD_FULL));
+        CHECK_FALSE(restoreRaw(Monster::PATROLLING, Monster::RED_MONSTER, 2));
+    }
+    
+    SUBCASE("Batch update matches per-object updates") {
+        Random walk(7);
+        Position target = openCells[0];
+        int transitions = 0;
+        for (int tick = 0; tick < 3000; tick++) {
+            // The target hops around so every state and transition gets exercised
+            if (tick % 40 == 0) {
+                target = openCells[walk.nextInt((int)openCells.size())];
+            }
+            flowField.update(terrain, target);
+            
+            for (auto& monster : objects) {
+                monster.setTarget(target);
+                monster.update(1.0f / 60.0f);
+            }
+            store.update(1.0f / 60.0f, target);
+            
+            for (int i = 0; i < store.size(); i++) {
+                REQUIRE(store.getPosition(i) == objects[i].getPosition());
+                REQUIRE(store.getBehaviorState(i) == objects[i].getBehaviorState());
+                REQUIRE(store.getAggressionTimer(i) == objects[i].getAggressionTimer());
+                REQUIRE(store.getFireBreathCooldown(i) == objects[i].getFireBreathCooldown());
+                REQUIRE(store.canFireBreath(i) == objects[i].canFireBreath());
+                if (store.getBehaviorState(i) == Monster::AGGRESSIVE) {
+                    transitions++;
+                }
+            }
+        }
+        CHECK(transitions > 0);
+    }
+    
+    SUBCASE("Removal moves the last monster into the gap") {
+        Position last = store.getPosition(59);
+        Monster::MonsterType lastType = store.getType(59);
+        store.remove(4);
+        CHECK(store.size() == 59);
+        CHECK(store.getPosition(4) == last);
+        CHECK(store.getType(4) == lastType);
+        
+        store.remove(58);
+        CHECK(store.size() == 58);
+        store.clear();
+        CHECK(store.empty());
+    }
+}
+
+TEST_CASE("SIMD behaviour state kernel") {
+    // 67 monsters: whole SSE and AVX blocks plus a scalar tail
+    const int count = 67;
+    TerrainGrid terrain(40, 30);
+    std::vector<Monster> objects;
+    std::vector<int32_t> x(count), y(count);
+    std::vector<float> detect(count), lose(count);
+    for (int i = 0; i < count; i++) {
+        Position start(i % 40, (i * 7) % 30);
+        objects.emplace_back(start, (i % 3 == 0) ? Monster::GREEN_DRAGON : Monster::RED_MONSTER, &terrain);
+        x[i] = start.x;
+        y[i] = start.y;
+        float range = objects[i].getDetectionRange();
+        detect[i] = range * range;
+        lose[i] = range * 1.5f * range * 1.5f;
+    }
+    
+    const BehaviorKernel::Path paths[] = { BehaviorKernel::SCALAR, BehaviorKernel::SSE2, BehaviorKernel::AVX2 };
+    std::vector<int32_t> states[3];
+    std::vector<float> aggression[3];
+    for (int p = 0; p < 3; p++) {
+        states[p].assign(count, Monster::PATROLLING);
+        aggression[p].assign(count, 0.0f);
+    }
+    
+    Random walk(11);
+    Position target(20, 15);
+    int aggressive = 0;
+    for (int tick = 0; tick < 2000; tick++) {
+        if (tick % 30 == 0) {
+            target = Position(walk.nextInt(40), walk.nextInt(30));
+        }
+        for (auto& monster : objects) {
+            monster.setTarget(target);
+        }
+        for (int p = 0; p < 3; p++) {
+            BehaviorKernel::Batch batch = { x.data(), y.data(), states[p].data(), aggression[p].data(),
+                                            detect.data(), lose.data(), count };
+            BehaviorKernel::updateStates(paths[p], batch, target.x, target.y);
+        }
+        
+        for (int i = 0; i < count; i++) {
+            for (int p = 0; p < 3; p++) {
+                REQUIRE(states[p][i] == objects[i].getBehaviorState());
+                REQUIRE(aggression[p][i] == objects[i].getAggressionTimer());
+            }
+            if (objects[i].getBehaviorState() == Monster::AGGRESSIVE) {
+                aggressive++;
+            }
+        }
+    }
+    CHECK(aggressive > 0);
+    CHECK(BehaviorKernel::getBestPath() >= BehaviorKernel::SCALAR);
+    
+    // Far enough out that an int32 square wraps (negative for 65535 and
+    // 46341): every path must still see the target as out of range
+    CHECK(BehaviorKernel::squaredDistance(65535, 0) > 4.0e9f);
+    CHECK(BehaviorKernel::squaredDistance(-46341, 46341) > 4.0e9f);
+    for (Position farTarget : { Position(65535, 0), Position(46341, 5), Position(-46341, 46341) }) {
+        for (int p = 0; p < 3; p++) {
+            for (int i = 0; i < count; i++) {
+                states[p][i] = (i % 2 == 0) ? Monster::CHASING : Monster::PATROLLING;
+                aggression[p][i] = 0.0f;
+            }
+            BehaviorKernel::Batch batch = { x.data(), y.data(), states[p].data(), aggression[p].data(),
+                                            detect.data(), lose.data(), count };
+            BehaviorKernel::updateStates(paths[p], batch, farTarget.x, farTarget.y);
+            for (int i = 0; i < count; i++) {
+                REQUIRE(states[p][i] == Monster::PATROLLING);
+            }
+        }
+    }
+}
+
+TEST_CASE("Work-stealing worker pool") {
+    SUBCASE("Every index runs exactly once") {
+        WorkerPool pool(4);
+        CHECK(pool.getThreadCount() == 4);
+        std::vector<std::atomic<int>> hits(1000);
+        for (int round = 0; round < 50; round++) {
+            pool.parallelFor((int)hits.size(), 7, [&](int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                    hits[i].fetch_add(1);
+                }
+            });
+        }
+        for (auto& hit : hits) {
+            REQUIRE(hit.load() == 50);
+        }
+    }
+    
+    SUBCASE("A single-thread pool runs on the caller") {
+        WorkerPool pool(1);
+        std::thread::id caller = std::this_thread::get_id();
+        bool sameThread = true;
+        pool.parallelFor(100, 10, [&](int begin, int end) {
+            sameThread = sameThread && std::this_thread::get_id() == caller;
+        });
+        CHECK(sameThread);
+    }
+    
+    SUBCASE("Parallel monster decisions match a single thread") {
+        TerrainGrid terrain(5);
+        FlowField flowField;
+        std::vector<Position> openCells = findEmptyCells(terrain);
+        REQUIRE_FALSE(openCells.empty());
+        
+        WorkerPool pool(4);
+        MonsterStore serial;
+        MonsterStore parallel;
+        for (MonsterStore* store : { &serial, &parallel }) {
+            store->setTerrain(&terrain);
+            store->setFlowField(&flowField);
+        }
+        parallel.setWorkerPool(&pool);
+        
+        const int count = MonsterStore::PARALLEL_MIN_MONSTERS * 4;
+        for (int i = 0; i < count; i++) {
+            Monster monster = makeCrowdMonster(openCells, i, terrain, 5, true);
+            serial.add(monster);
+            parallel.add(monster);
+        }
+        
+        Random walk(3);
+        Position target = openCells[0];
+        for (int tick = 0; tick < 600; tick++) {
+            if (tick % 50 == 0) {
+                target = openCells[walk.nextInt((int)openCells.size())];
+            }
+            flowField.update(terrain, target);
+            serial.update(1.0f / 60.0f, target);
+            parallel.update(1.0f / 60.0f, target);
+            for (int i = 0; i < count; i++) {
+                REQUIRE(parallel.getPosition(i) == serial.getPosition(i));
+                REQUIRE(parallel.getBehaviorState(i) == serial.getBehaviorState(i));
+            }
+        }
+    }
+}
+
+TEST_CASE("Staggered monster decisions with a per-tick budget") {
+    TerrainGrid terrain(5);
+    std::vector<Position> openCells = findEmptyCells(terrain);
+    REQUIRE_FALSE(openCells.empty());
+    
+    const int count = 360;
+    auto fill = [&](MonsterStore& store, bool staggered) {
+        store.setTerrain(&terrain);
+        store.setLodDistance(0.0f);
+        for (int i = 0; i < count; i++) {
+            Monster monster = makeCrowdMonster(openCells, i, terrain, 5, false);
+            if (staggered) {
+                monster.setDecisionPhase(DecisionScheduler::getPhase(i));
+            }
+            store.add(monster);
+        }
+    };
+    const float tick = 1.0f / 60.0f;
+    const Position target = openCells[0];
+    
+    SUBCASE("Phases are spread over the interval") {
+        for (int i = 0; i < 1000; i++) {
+            float phase = DecisionScheduler::getPhase(i);
+            REQUIRE(phase >= 0.0f);
+            REQUIRE(phase < 1.0f);
+        }
+        CHECK(DecisionScheduler::getPhase(0) == 0.0f);
+        CHECK(DecisionScheduler::getPhase(1) != DecisionScheduler::getPhase(2));
+    }
+    
+    SUBCASE("Staggering flattens the peak without changing the decision rate") {
+        MonsterStore synchronized;
+        MonsterStore staggered;
+        fill(synchronized, false);
+        fill(staggered, true);
+        
+        int synchronizedTotal = 0, staggeredTotal = 0;
+        int synchronizedPeak = 0, staggeredPeak = 0;
+        for (int t = 0; t < 1800; t++) {
+            synchronized.update(tick, target);
+            staggered.update(tick, target);
+            synchronizedTotal += synchronized.getScheduler().getLastDecided();
+            staggeredTotal += staggered.getScheduler().getLastDecided();
+            synchronizedPeak = std::max(synchronizedPeak, synchronized.getScheduler().getLastDecided());
+            staggeredPeak = std::max(staggeredPeak, staggered.getScheduler().getLastDecided());
+        }
+        
+        CHECK(synchronizedPeak == count);
+        CHECK(staggeredPeak <= count / 10);
+        // At most one decision apiece lost or gained at the ends of the run
+        CHECK(std::abs(synchronizedTotal - staggeredTotal) <= count);
+    }
+    
+    SUBCASE("Monsters over budget carry over to the next ticks") {
+        MonsterStore store;
+        fill(store, false);
+        store.getScheduler().setBudget(50);
+        
+        int decided = 0;
+        bool deferred = false;
+        for (int t = 0; t < 40; t++) {
+            store.update(tick, target);
+            REQUIRE(store.getScheduler().getLastDecided() <= 50);
+            deferred = deferred || store.getScheduler().getLastDeferred() > 0;
+            decided += store.getScheduler().getLastDecided();
+            if (decided >= count) {
+                break;
+            }
+        }
+        CHECK(deferred);
+        // Round robin: the first wave is served in full before anyone goes twice
+        CHECK(decided == count);
+    }
+    
+    SUBCASE("Monsters deferred for several intervals catch up only once") {
+        MonsterStore store;
+        fill(store, false);
+        const float interval = Monster(target, Monster::RED_MONSTER, &terrain).getDecisionInterval();
+        const int intervalTicks = (int)(interval / tick);
+        REQUIRE(intervalTicks >= 4);
+        
+        // Sustained overload: one decision a tick, so each monster waits
+        // count ticks (many intervals) for its turn
+        store.getScheduler().setBudget(1);
+        for (int t = 0; t < 2 * count; t++) {
+            store.update(tick, target);
+        }
+        
+        // Load drops: every monster makes its overdue decision and at most one
+        // more, instead of deciding every tick until its backlog is paid off
+        store.getScheduler().setBudget(0);
+        int decided = 0;
+        for (int t = 0; t < intervalTicks / 2; t++) {
+            store.update(tick, target);
+            decided += store.getScheduler().getLastDecided();
+        }
+        CHECK(decided >= count);
+        CHECK(decided <= 2 * count);
+    }
+    
+    SUBCASE("A long stall leaves at most one interval of overshoot") {
+        Monster monster(target, Monster::RED_MONSTER, &terrain);
+        monster.seedRandom(5, Random::MONSTER_STREAM_BASE);
+        monster.update(10.0f * monster.getDecisionInterval());
+        CHECK(monster.getDecisionTimer() <= monster.getDecisionInterval());
+    }
+}
+
+TEST_CASE("Level-of-detail AI for distant monsters") {
+    TerrainGrid terrain(120, 20);
+    FlowField flowField;
+    MonsterStore store;
+    store.setTerrain(&terrain);
+    store.setFlowField(&flowField);
+    
+    // One red monster (detection range 8) far down the grid from the target,
+    // in a dug-out room it can wander around
+    for (int x = 100; x < 120; x++) {
+        for (int y = 5; y < 16; y++) {
+            terrain.digTunnelAt(Position(x, y));
+        }
+    }
+    Monster far(Position(110, 10), Monster::RED_MONSTER, &terrain);
+    far.seedRandom(3, Random::MONSTER_STREAM_BASE);
+    store.add(far);
+    Position target(5, 10);
+    const float tick = 1.0f / 60.0f;
+    
+    SUBCASE("A far patrolling monster drops to the cheap AI and barely moves") {
+        store.update(tick, target);
+        CHECK(store.getLevelOfDetail(0) == MonsterStore::LOD_DISTANT);
+        CHECK(store.countDistant() == 1);
+        
+        // A random walk of at most one step per decision
+        int steps = 0;
+        Position last = store.getPosition(0);
+        for (int t = 0; t < 600; t++) {
+            store.update(tick, target);
+            Position now = store.getPosition(0);
+            REQUIRE(std::abs(now.x - last.x) + std::abs(now.y - last.y) <= 1);
+            steps += !(now == last);
+            last = now;
+            REQUIRE(store.getBehaviorState(0) == Monster::PATROLLING);
+        }
+        // Deciding LOD_TICK_DIVISOR times less often than every 18 ticks
+        CHECK(steps <= 600 / (18 * MonsterStore::LOD_TICK_DIVISOR) + 1);
+        CHECK(steps > 0);
+    }
+    
+    SUBCASE("Wandering never digs out of a closed pocket") {
+        Position pocket(60, 10);
+        terrain.digTunnelAt(pocket);
+        Monster buried(pocket, Monster::RED_MONSTER, &terrain);
+        buried.seedRandom(3, Random::MONSTER_STREAM_BASE + 1);
+        store.add(buried);
+        for (int t = 0; t < 600; t++) {
+            store.update(tick, target);
+            REQUIRE(store.getLevelOfDetail(1) == MonsterStore::LOD_DISTANT);
+            REQUIRE(store.getPosition(1) == pocket);
+        }
+    }
+    
+    SUBCASE("The target coming within 1.5x detection range promotes at once") {
+        store.update(tick, target);
+        REQUIRE(store.getLevelOfDetail(0) == MonsterStore::LOD_DISTANT);
+        Position monster = store.getPosition(0);
+        store.update(tick, Position(monster.x - 11, monster.y));
+        CHECK(store.getLevelOfDetail(0) == MonsterStore::LOD_FULL);
+    }
+    
+    SUBCASE("A short tunnel path to the target promotes on the monster's LOD tick") {
+        store.update(tick, target);
+        REQUIRE(store.getLevelOfDetail(0) == MonsterStore::LOD_DISTANT);
+        
+        // Target 15 tiles away along an open tunnel: beyond 12, within 20 steps,
+        // wide enough that a wander step on the way stays inside it
+        Position monster = store.getPosition(0);
+        Position near(monster.x - 15, monster.y);
+        for (int x = near.x; x <= monster.x + 1; x++) {
+            for (int y = monster.y - 1; y <= monster.y + 1; y++) {
+                terrain.digTunnelAt(Position(x, y));
+            }
+        }
+        flowField.update(terrain, near);
+        for (int t = 0; t < MonsterStore::LOD_TICK_DIVISOR; t++) {
+            store.update(tick, near);
+        }
+        CHECK(store.getLevelOfDetail(0) == MonsterStore::LOD_FULL);
+    }
+    
+    SUBCASE("LOD distance 0 keeps full AI") {
+        store.setLodDistance(0.0f);
+        store.update(tick, target);
+        CHECK(store.getLevelOfDetail(0) == MonsterStore::LOD_FULL);
+        CHECK(store.countDistant() == 0);
+    }
+}
+
+TEST_CASE("Monster timers run on simulated time, not ticks") {
+    struct Transition {
+        Monster::BehaviorState state;
+        double time;
+    };
+    
+    // One red monster (detection range 8). The target starts 3 tiles away,
+    // then keeps 10 tiles ahead of it (out of calm-down range, inside chase
+    // range), then 20 tiles ahead (out of chase range). The store runs the
+    // same monster alongside and has to agree on every tick
+    auto run = [](int rate) {
+        TerrainGrid terrain(80, 30);
+        Monster monster(Position(5, 15), Monster::RED_MONSTER, &terrain);
+        monster.seedRandom(9, Random::MONSTER_STREAM_BASE);
+        MonsterStore store;
+        store.setTerrain(&terrain);
+        store.setLodDistance(0.0f);
+        store.add(monster);
+        
+        std::vector<Transition> transitions;
+        Monster::BehaviorState last = monster.getBehaviorState();
+        const float tick = 1.0f / rate;
+        for (int t = 0; t < 10 * rate; t++) {
+            double time = (double)t / rate;
+            Position at = monster.getPosition();
+            Position target = time < 1.95 ? Position(8, 15)
+                            : time < 6.95 ? Position(at.x + 10, at.y)
+                            : Position(at.x + 20, at.y);
+            monster.setTarget(target);
+            monster.update(tick);
+            store.update(tick, target);
+            REQUIRE(store.getBehaviorState(0) == monster.getBehaviorState());
+            REQUIRE(store.getPosition(0) == monster.getPosition());
+            
+            if (monster.getBehaviorState() != last) {
+                last = monster.getBehaviorState();
+                transitions.push_back({ last, time });
+            }
+        }
+        return transitions;
+    };
+    
+    std::vector<Transition> reference = run(60);
+    REQUIRE(reference.size() == 4);
+    CHECK(reference[0].state == Monster::CHASING);
+    CHECK(reference[1].state == Monster::AGGRESSIVE);
+    CHECK(reference[2].state == Monster::CHASING);
+    CHECK(reference[3].state == Monster::PATROLLING);
+    // Aggression lasts five simulated seconds
+    CHECK(reference[2].time - reference[1].time == doctest::Approx(5.0).epsilon(0.01));
+    
+    for (int rate : { 30, 144, 1000 }) {
+        std::vector<Transition> transitions = run(rate);
+        REQUIRE(transitions.size() == reference.size());
+        for (size_t i = 0; i < reference.size(); i++) {
+            CHECK(transitions[i].state == reference[i].state);
+            // Same moment, give or take a tick at the slowest rate
+            CHECK(std::abs(transitions[i].time - reference[i].time) <= 2.0 / 30.0);
+        }
+    }
+}
+
+TEST_CASE("Game snapshots for rollback") {
+    const char* filename = "test_snapshot.dds";
+    const int snapshotTick = 240;
+    const int endTick = 1800;
+    
+    // Walks a square, digging as it goes, and fires every 1.5 s (tick 230 included)
+    auto script = [](int tick) {
+        InputState state;
+        state.hold((InputState::Action)(InputState::MOVE_UP + (tick / 45) % 4));
+        if (tick % 90 == 50) {
+            state.press(InputState::FIRE);
+        }
+        return state;
+    };
+    
+    auto run = [&](Game& game, ScriptedInput& input, int from, int to) {
+        std::vector<int> trace;
+        for (int tick = from; tick < to; tick++) {
+            input.setState(script(tick));
+            game.beginFrame();
+            game.update(1.0f / 60.0f);
+            Position pos = game.getPlayerPosition();
+            trace.insert(trace.end(), { pos.x, pos.y, game.getScore(), game.getMonsterCount(),
+                                        game.getProjectileCount(), (int)game.getTerrain().countDugCells(),
+                                        game.isGameOver() ? 1 : 0 });
+            for (int i = 0; i < game.getMonsterCount(); i++) {
+                Position monster = game.getMonsterPosition(i);
+                trace.insert(trace.end(), { monster.x, monster.y });
+            }
+        }
+        return trace;
+    };
+    
+    ScriptedInput input;
+    Game game(&input, true, 77);
+    game.startLevel(1);
+    run(game, input, 0, snapshotTick);
+    REQUIRE_FALSE(game.isGameOver());
+    REQUIRE(game.getProjectileCount() > 0);  // a harpoon in flight, tied to its owner
+    
+    GameSnapshot snapshot;
+    game.saveSnapshot(snapshot);
+    std::vector<int> expected = run(game, input, snapshotTick, endTick);
+    
+    SUBCASE("Restoring replays the same ticks") {
+        REQUIRE(game.restoreSnapshot(snapshot));
+        CHECK(run(game, input, snapshotTick, endTick) == expected);
+        
+        // And again, as rollback scrubbing would
+        REQUIRE(game.restoreSnapshot(snapshot));
+        CHECK(run(game, input, snapshotTick, endTick) == expected);
+    }
+    
+    SUBCASE("A saved snapshot restores into another game") {
+        REQUIRE(snapshot.save(filename));
+        GameSnapshot loaded;
+        REQUIRE(loaded.load(filename));
+        CHECK(loaded.size() == snapshot.size());
+        
+        ScriptedInput otherInput;
+        Game other(&otherInput, true, 12345);
+        other.startLevel(2);
+        REQUIRE(other.restoreSnapshot(loaded));
+        CHECK(other.getSeed() == 77);
+        CHECK(other.getLevel() == 1);
+        CHECK(run(other, otherInput, snapshotTick, endTick) == expected);
+    }
+    
+    SUBCASE("Saving again reuses the buffer") {
+        size_t capacity = snapshot.capacity();
+        REQUIRE(game.restoreSnapshot(snapshot));
+        game.saveSnapshot(snapshot);
+        CHECK(snapshot.capacity() == capacity);
+        CHECK(run(game, input, snapshotTick, endTick) == expected);
+    }
+    
+    SUBCASE("Rejects empty and foreign snapshots") {
+        GameSnapshot empty;
+        CHECK(empty.isEmpty());
+        CHECK_FALSE(game.restoreSnapshot(empty));
+        CHECK_FALSE(empty.save(filename));
+        
+        {
+            std::ofstream file(filename);
+            file << "not a snapshot";
+        }
+        GameSnapshot loaded;
+        CHECK_FALSE(loaded.load(filename));
+        CHECK(loaded.isEmpty());
+    }
+    
+    SUBCASE("A damaged snapshot leaves the game unchanged") {
+        GameSnapshot current;
+        game.saveSnapshot(current);
+        
+        REQUIRE(snapshot.save(filename));
+        std::vector<char> bytes;
+        {
+            std::ifstream file(filename, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        const uint64_t payloadSize = bytes.size() - sizeof(GameSnapshot::Header);
+        
+        // Cut the payload short, fixing up the header so the file still loads;
+        // the last cut only drops the final byte, after every subsystem has read
+        std::vector<uint64_t> cuts;
+        for (uint64_t cut = 0; cut < payloadSize - 1; cut += payloadSize / 40 + 1) {
+            cuts.push_back(cut);
+        }
+        cuts.push_back(payloadSize - 1);
+        for (uint64_t cut : cuts) {
+            std::vector<char> truncated(bytes.begin(), bytes.begin() + sizeof(GameSnapshot::Header) + cut);
+            std::memcpy(truncated.data() + offsetof(GameSnapshot::Header, payloadSize), &cut, sizeof(cut));
+            {
+                std::ofstream file(filename, std::ios::binary);
+                file.write(truncated.data(), (std::streamsize)truncated.size());
+            }
+            GameSnapshot damaged;
+            REQUIRE(damaged.load(filename));
+            CHECK_FALSE(game.restoreSnapshot(damaged));
+        }
+        
+        // Still the game as it was before any of the failed restores
+        ScriptedInput referenceInput;
+        Game reference(&referenceInput, true, 77);
+        REQUIRE(reference.restoreSnapshot(current));
+        CHECK(run(game, input, endTick, endTick + 600) == run(reference, referenceInput, endTick, endTick + 600));
+    }
+    
+    std::remove(filename);
+}